@@ -8,23 +8,104 @@
 
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 TARGET = QRegExpTester
 TEMPLATE = app
 
+CONFIG += c++11
+
+# Compressed testees; gzip and zstd input are each only offered when
+# pkg-config finds their library.
+CONFIG += link_pkgconfig
+packagesExist(zlib) {
+    DEFINES += HAVE_ZLIB
+    PKGCONFIG += zlib
+}
+packagesExist(libzstd) {
+    DEFINES += HAVE_ZSTD
+    PKGCONFIG += libzstd
+}
+
 
 SOURCES += main.cpp\
         mainwindow.cpp \
     regextesterwindow.cpp \
-    regexpcontroller.cpp
+    regexpcontroller.cpp \
+    matchworker.cpp \
+    matchresultmodel.cpp \
+    matchexporter.cpp \
+    spanarena.cpp \
+    mappedtestee.cpp \
+    compressedreader.cpp \
+    compressedstream.cpp \
+    batchrunner.cpp \
+    corpusrunner.cpp \
+    parallelscanner.cpp \
+    filesearcher.cpp \
+    regexpengine.cpp \
+    legacyregexpengine.cpp \
+    lazydfa.cpp \
+    lazydfaregexpengine.cpp \
+    fixedstringmatcher.cpp \
+    globregexpengine.cpp \
+    pcreregexpengine.cpp \
+    stdregexpengine.cpp \
+    benchmark.cpp \
+    charset.cpp \
+    patternparser.cpp \
+    patternanalyzer.cpp \
+    patternprofiler.cpp \
+    enginecache.cpp \
+    matchhighlighter.cpp \
+    matchdensitymap.cpp \
+    prefilter.cpp \
+    ahocorasick.cpp \
+    patternlibrary.cpp \
+    patternset.cpp \
+    patternsetscanner.cpp \
+    patternsetwindow.cpp
 
 HEADERS  += mainwindow.h \
     regextesterwindow.h \
-    regexpcontroller.h
+    regexpcontroller.h \
+    matchworker.h \
+    matchresultmodel.h \
+    matchexporter.h \
+    spanarena.h \
+    mappedtestee.h \
+    compressedreader.h \
+    compressedstream.h \
+    batchrunner.h \
+    corpusrunner.h \
+    parallelscanner.h \
+    filesearcher.h \
+    regexpengine.h \
+    legacyregexpengine.h \
+    lazydfa.h \
+    lazydfaregexpengine.h \
+    fixedstringmatcher.h \
+    globregexpengine.h \
+    pcreregexpengine.h \
+    stdregexpengine.h \
+    benchmark.h \
+    charset.h \
+    patternparser.h \
+    patternanalyzer.h \
+    patternprofiler.h \
+    enginecache.h \
+    matchhighlighter.h \
+    matchdensitymap.h \
+    prefilter.h \
+    ahocorasick.h \
+    patternlibrary.h \
+    patternset.h \
+    patternsetscanner.h \
+    patternsetwindow.h
 
 FORMS    += mainwindow.ui \
-    regextesterwindow.ui
+    regextesterwindow.ui \
+    patternsetwindow.ui
 
 RESOURCES += \
     qregexptester.qrc
@@ -0,0 +1,137 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QQueue>
+#include "ahocorasick.h"
+
+AhoCorasick::Node::Node() :
+    fail(0),
+    output(0)
+{
+}
+
+AhoCorasick::AhoCorasick(Qt::CaseSensitivity caseSensitivity) :
+    _caseSensitivity(caseSensitivity),
+    _maxLength(0)
+{
+    _nodes << Node();
+}
+
+void AhoCorasick::addLiteral(const QString &literal, int id)
+{
+    Q_ASSERT_X(!literal.isEmpty(), "AhoCorasick::addLiteral", "literal can't be empty.");
+    int state = 0;
+    for (int i = 0; i < literal.length(); ++i)
+    {
+        ushort ch = literal.at(i).unicode();
+        int next = _nodes.at(state).next.value(ch, 0);
+        if (next == 0)
+        {
+            next = _nodes.size();
+            _nodes << Node();
+            _nodes[state].next.insert(ch, next);
+        }
+        state = next;
+    }
+    _nodes[state].ids << id;
+    _lengths.insert(id, literal.length());
+    _maxLength = qMax(_maxLength, literal.length());
+}
+
+void AhoCorasick::build()
+{
+    // Breadth first, so a node's failure target is always done before it.
+    QQueue<int> queue;
+    foreach (int child, _nodes.at(0).next)
+    {
+        _nodes[child].fail = 0;
+        _nodes[child].output = 0;
+        queue.enqueue(child);
+    }
+    while (!queue.isEmpty())
+    {
+        int state = queue.dequeue();
+        QHash<ushort, int>::const_iterator it = _nodes.at(state).next.constBegin();
+        for (; it != _nodes.at(state).next.constEnd(); ++it)
+        {
+            int child = it.value();
+            int fail = step(_nodes.at(state).fail, it.key());
+            _nodes[child].fail = fail;
+            _nodes[child].output = _nodes.at(fail).ids.isEmpty() ? _nodes.at(fail).output : fail;
+            queue.enqueue(child);
+        }
+    }
+}
+
+bool AhoCorasick::isEmpty() const
+{
+    return _lengths.isEmpty();
+}
+
+/*
+ * Appends the start position of every literal that ends inside [from, to)
+ * and returns the state to resume from at to.
+ */
+int AhoCorasick::scan(const QString &text, int from, int to, int state, QVector<LiteralHit> &hits) const
+{
+    const QChar *data = text.constData();
+    bool fold = (_caseSensitivity == Qt::CaseInsensitive);
+    for (int i = from; i < to; ++i)
+    {
+        state = step(state, fold ? data[i].toLower().unicode() : data[i].unicode());
+        int out = _nodes.at(state).ids.isEmpty() ? _nodes.at(state).output : state;
+        for (; out != 0; out = _nodes.at(out).output)
+        {
+            foreach (int id, _nodes.at(out).ids)
+            {
+                LiteralHit hit;
+                hit.id = id;
+                hit.pos = i + 1 - _lengths.value(id);
+                hits << hit;
+            }
+        }
+    }
+    return state;
+}
+
+/*
+ * Returns the start of the leftmost literal at or after from, or -1. Hits
+ * come in order of their end, so after the first one the scan goes on
+ * while a longer literal could still start further left.
+ */
+int AhoCorasick::indexIn(const QString &text, int from) const
+{
+    const QChar *data = text.constData();
+    bool fold = (_caseSensitivity == Qt::CaseInsensitive);
+    int state = 0;
+    int best = -1;
+    int end = text.length();
+    for (int i = qMax(from, 0); i < end; ++i)
+    {
+        state = step(state, fold ? data[i].toLower().unicode() : data[i].unicode());
+        int out = _nodes.at(state).ids.isEmpty() ? _nodes.at(state).output : state;
+        for (; out != 0; out = _nodes.at(out).output)
+        {
+            foreach (int id, _nodes.at(out).ids)
+            {
+                int pos = i + 1 - _lengths.value(id);
+                if (best < 0 || pos < best)
+                {
+                    best = pos;
+                    end = qMin(text.length(), best + _maxLength);
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int AhoCorasick::step(int state, ushort ch) const
+{
+    while (state != 0 && !_nodes.at(state).next.contains(ch))
+    {
+        state = _nodes.at(state).fail;
+    }
+    return _nodes.at(state).next.value(ch, 0);
+}
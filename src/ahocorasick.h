@@ -0,0 +1,54 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef AHOCORASICK_H
+#define AHOCORASICK_H
+
+#include <QtGlobal>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+struct LiteralHit
+{
+    int id;
+    int pos;
+};
+
+/*
+ * Aho-Corasick automaton over UTF-16 code units: finds every occurrence of
+ * every literal in a single pass over the text. A case-insensitive
+ * automaton expects literals folded by Prefilter::fold() and folds the
+ * text as it goes. Scanning can be split into consecutive ranges by
+ * passing the returned state on to the next call.
+ */
+class AhoCorasick
+{
+public:
+    explicit AhoCorasick(Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive);
+    void addLiteral(const QString &literal, int id);
+    void build();
+    bool isEmpty() const;
+    int scan(const QString &text, int from, int to, int state, QVector<LiteralHit> &hits) const;
+    int indexIn(const QString &text, int from) const;
+
+private:
+    struct Node
+    {
+        Node();
+        QHash<ushort, int> next;
+        int fail;
+        int output;
+        QVector<int> ids;
+    };
+
+    int step(int state, ushort ch) const;
+
+    Qt::CaseSensitivity _caseSensitivity;
+    QVector<Node> _nodes;
+    QHash<int, int> _lengths;
+    int _maxLength;
+};
+
+#endif // AHOCORASICK_H
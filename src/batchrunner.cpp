@@ -0,0 +1,482 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QElapsedTimer>
+#include <QFile>
+#include <cstdio>
+#include <cstring>
+#include "batchrunner.h"
+#include "parallelscanner.h"
+#include "patternlibrary.h"
+#include "patternset.h"
+
+#define BATCH_OPTION "--batch"
+#define EXIT_MATCHED 0
+#define EXIT_NOT_MATCHED 1
+#define EXIT_ERROR 2
+
+BatchRunner::BatchRunner(QObject *parent) :
+    QObject(parent),
+    _mode(IndexIn),
+    _format(Tsv),
+    _parallel(false),
+    _maxMatches(0),
+    _maxMsecs(0),
+    _out(stdout, QIODevice::WriteOnly),
+    _err(stderr, QIODevice::WriteOnly)
+{
+    _out.setCodec("UTF-8");
+    _err.setCodec("UTF-8");
+}
+
+bool BatchRunner::isBatchMode(int argc, char *argv[])
+{
+    // Past "--" come input files, which may be named anything.
+    for (int i = 1; i < argc && strcmp(argv[i], "--") != 0; ++i)
+    {
+        if (strcmp(argv[i], BATCH_OPTION) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int BatchRunner::run(const QStringList &arguments)
+{
+    if (!parseArguments(arguments))
+    {
+        printUsage();
+        return EXIT_ERROR;
+    }
+
+    // Patterns are loaded once, not again for every input.
+    QList<RegExpController *> patterns;
+    QStringList labels;
+    int exitCode = loadPatterns(patterns, labels) ? EXIT_NOT_MATCHED : EXIT_ERROR;
+
+    if (!_compileTo.isEmpty())
+    {
+        QString error;
+        if (!PatternLibrary::write(_compileTo, patterns, error))
+        {
+            _err << QString(tr("Can't write pattern library: %1 %2")).arg(_compileTo).arg(error) << endl;
+            exitCode = EXIT_ERROR;
+        }
+        else
+        {
+            _err << QString(tr("Compiled %1 pattern(s) into %2.")).arg(patterns.size()).arg(_compileTo) << endl;
+            exitCode = (exitCode == EXIT_ERROR) ? EXIT_ERROR : EXIT_MATCHED;
+        }
+        _inputs.clear();
+    }
+
+    foreach (const QString &input, _inputs)
+    {
+        QString testee;
+        if (!readInput(input, testee))
+        {
+            _err << QString(tr("Can't read input: %1")).arg(input) << endl;
+            exitCode = EXIT_ERROR;
+            continue;
+        }
+
+        for (int i = 0; i < patterns.size(); ++i)
+        {
+            if (runPattern(*patterns.at(i), labels.at(i), input, testee) > 0 && exitCode == EXIT_NOT_MATCHED)
+            {
+                exitCode = EXIT_MATCHED;
+            }
+        }
+    }
+
+    qDeleteAll(patterns);
+    _out.flush();
+    _err.flush();
+    return exitCode;
+}
+
+/*
+ * Loads the valid patterns of every pattern file, labelled with the file
+ * they came from. A text file contributes its first pattern (all of them
+ * when compiling), a precompiled library all of its patterns, labelled
+ * "FILE#N". Returns false when anything failed to load.
+ */
+bool BatchRunner::loadPatterns(QList<RegExpController *> &patterns, QStringList &labels)
+{
+    bool loaded = true;
+    foreach (const QString &patternFile, _patternFiles)
+    {
+        QList<RegExpController *> filePatterns;
+        QString error;
+        if (PatternLibrary::isLibrary(patternFile))
+        {
+            PatternLibrary library;
+            if (library.open(patternFile))
+            {
+                for (int i = 0; i < library.count(); ++i)
+                {
+                    filePatterns << new RegExpController();
+                    if (!library.load(i, *filePatterns.last()))
+                    {
+                        break;
+                    }
+                }
+            }
+            error = library.getError();
+        }
+        else if (!_compileTo.isEmpty())
+        {
+            PatternSet set;
+            if (set.loadFromFile(patternFile))
+            {
+                for (int i = 0; i < set.count(); ++i)
+                {
+                    filePatterns << new RegExpController();
+                    filePatterns.last()->copyFrom(*set.at(i));
+                }
+            }
+            error = set.getFileError();
+            if (set.count() == 0 && error.isEmpty())
+            {
+                error = tr("no patterns");
+            }
+        }
+        else
+        {
+            filePatterns << new RegExpController();
+            if (!filePatterns.last()->loadFromFile(patternFile))
+            {
+                error = filePatterns.last()->getFileError();
+                if (error.isEmpty())
+                {
+                    error = tr("can't open file");
+                }
+            }
+        }
+
+        if (!error.isEmpty())
+        {
+            _err << QString(tr("Can't load pattern file: %1 %2")).arg(patternFile).arg(error) << endl;
+            qDeleteAll(filePatterns);
+            loaded = false;
+            continue;
+        }
+        for (int i = 0; i < filePatterns.size(); ++i)
+        {
+            RegExpController *regexp = filePatterns.at(i);
+            QString label = filePatterns.size() > 1 ? QString("%1#%2").arg(patternFile).arg(i + 1) : patternFile;
+            if (!regexp->isPatternValid())
+            {
+                _err << QString(tr("Invalid pattern in %1: %2")).arg(label).arg(regexp->errorString()) << endl;
+                delete regexp;
+                loaded = false;
+                continue;
+            }
+            patterns << regexp;
+            labels << label;
+        }
+    }
+    return loaded;
+}
+
+bool BatchRunner::parseArguments(const QStringList &arguments)
+{
+    bool inputsFollow = false;
+
+    // arguments[0] is the program itself.
+    for (int i = 1; i < arguments.count(); ++i)
+    {
+        const QString &argument = arguments.at(i);
+        if (inputsFollow)
+        {
+            _inputs << argument;
+        }
+        else if (argument == BATCH_OPTION)
+        {
+            continue;
+        }
+        else if (argument == "--")
+        {
+            inputsFollow = true;
+        }
+        else if (argument == "--exactMatch")
+        {
+            _mode = ExactMatch;
+        }
+        else if (argument == "--indexIn")
+        {
+            _mode = IndexIn;
+        }
+        else if (argument == "--parallel")
+        {
+            _parallel = true;
+        }
+        else if (argument == "--max-matches" && i + 1 < arguments.count())
+        {
+            bool ok;
+            _maxMatches = arguments.at(++i).toInt(&ok);
+            if (!ok || _maxMatches < 0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--max-time" && i + 1 < arguments.count())
+        {
+            bool ok;
+            _maxMsecs = arguments.at(++i).toLongLong(&ok);
+            if (!ok || _maxMsecs < 0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--compile" && i + 1 < arguments.count())
+        {
+            _compileTo = arguments.at(++i);
+        }
+        else if (argument == "--format" && i + 1 < arguments.count())
+        {
+            QString format = arguments.at(++i);
+            if (format.compare("tsv", Qt::CaseInsensitive) == 0)
+            {
+                _format = Tsv;
+            }
+            else if (format.compare("json", Qt::CaseInsensitive) == 0)
+            {
+                _format = Json;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (argument.startsWith("--"))
+        {
+            return false;
+        }
+        else
+        {
+            _patternFiles << argument;
+        }
+    }
+
+    if (_inputs.isEmpty())
+    {
+        _inputs << "-";
+    }
+    return !_patternFiles.isEmpty();
+}
+
+void BatchRunner::printUsage()
+{
+    _err << tr("Usage: QRegExpTester --batch [--exactMatch|--indexIn] [--parallel]\n"
+               "                     [--max-matches N] [--max-time MS]\n"
+               "                     [--format tsv|json] PATTERN.qregexp... [-- INPUT...]\n"
+               "       QRegExpTester --batch --compile LIBRARY PATTERN.qregexp...\n"
+               "Reads stdin when no INPUT (or \"-\") is given.") << endl;
+}
+
+bool BatchRunner::readInput(const QString &input, QString &testee)
+{
+    QFile file;
+    bool opened;
+    if (input == "-")
+    {
+        opened = file.open(stdin, QIODevice::ReadOnly);
+    }
+    else
+    {
+        file.setFileName(input);
+        opened = file.open(QIODevice::ReadOnly);
+    }
+    if (!opened)
+    {
+        return false;
+    }
+    testee = QString::fromUtf8(file.readAll());
+    return true;
+}
+
+int BatchRunner::runPattern(RegExpController &regexp, const QString &patternFile,
+                            const QString &input, const QString &testee)
+{
+    if (_mode == ExactMatch)
+    {
+        bool matched = regexp.exactMatch(testee);
+        writeExactMatch(patternFile, input, testee, matched, regexp);
+        return matched ? 1 : 0;
+    }
+
+    int captureCount = regexp.captureCount();
+    int stride = regexp.spanStride();
+    // Slices can't share a time limit, so only the match limit is kept.
+    if (_parallel && _maxMsecs == 0 && ParallelScanner::isSupported(regexp))
+    {
+        ParallelScanner scanner(regexp);
+        scanner.setTestee(testee);
+        scanner.setMaxMatches(_maxMatches);
+        scanner.start();
+        QVector<qint64> spans = scanner.result();
+        for (int i = 0; i + stride <= spans.size(); i += stride)
+        {
+            writeMatch(patternFile, input, testee, spans.constData() + i, captureCount);
+        }
+        if (_maxMatches > 0 && spans.size() / stride >= _maxMatches)
+        {
+            _err << QString(tr("%1 on %2: stopped at the match limit after %3 matches."))
+                    .arg(patternFile).arg(input).arg(_maxMatches) << endl;
+        }
+        return spans.size() / stride;
+    }
+    if (_parallel)
+    {
+        _err << QString(tr("%1 on %2: scanning sequentially, %3."))
+                .arg(patternFile).arg(input)
+                .arg(_maxMsecs > 0 ? tr("slices can't share a time limit")
+                                   : tr("the testee can't be split for this pattern")) << endl;
+    }
+
+    QVector<qint64> spans;
+    spans.reserve(stride);
+    QElapsedTimer timer;
+    timer.start();
+    RegExpMatchIterator it(regexp, testee);
+    it.setMaxMatches(_maxMatches);
+    it.setMaxMsecs(_maxMsecs);
+    while (it.next())
+    {
+        spans.resize(0);
+        regexp.appendSpans(spans);
+        writeMatch(patternFile, input, testee, spans.constData(), captureCount);
+    }
+    if (it.isLimited() && _maxMatches > 0 && it.matchCount() >= _maxMatches)
+    {
+        _err << QString(tr("%1 on %2: stopped at the match limit after %3 matches."))
+                .arg(patternFile).arg(input).arg(it.matchCount()) << endl;
+    }
+    else if (it.isLimited())
+    {
+        _err << QString(tr("%1 on %2: stopped at the time limit of %3 ms after %4 ms and %5 matches."))
+                .arg(patternFile).arg(input).arg(_maxMsecs).arg(timer.elapsed()).arg(it.matchCount()) << endl;
+    }
+    return it.matchCount();
+}
+
+void BatchRunner::writeMatch(const QString &patternFile, const QString &input,
+                             const QString &testee, const qint64 *spans, int captureCount)
+{
+    if (_format == Tsv)
+    {
+        _out << escapeTsv(patternFile) << '\t' << escapeTsv(input) << '\t'
+             << spans[0] << '\t' << spans[1];
+        for (int i = 0; i <= captureCount; ++i)
+        {
+            _out << '\t' << escapeTsv(RegExpController::spanRef(testee, spans[i * 2], spans[i * 2 + 1]));
+        }
+        _out << '\n';
+        return;
+    }
+
+    _out << "{\"pattern\":\"" << escapeJson(patternFile)
+         << "\",\"input\":\"" << escapeJson(input)
+         << "\",\"pos\":" << spans[0]
+         << ",\"length\":" << spans[1]
+         << ",\"captures\":[";
+    for (int i = 0; i <= captureCount; ++i)
+    {
+        _out << (i > 0 ? ",\"" : "\"") << escapeJson(RegExpController::spanRef(testee, spans[i * 2], spans[i * 2 + 1])) << '"';
+    }
+    _out << "]}\n";
+}
+
+void BatchRunner::writeExactMatch(const QString &patternFile, const QString &input, const QString &testee,
+                                  bool matched, const RegExpController &regexp)
+{
+    int captureCount = regexp.captureCount();
+    QVector<qint64> spans;
+    if (matched)
+    {
+        regexp.appendSpans(spans);
+    }
+    if (_format == Tsv)
+    {
+        _out << escapeTsv(patternFile) << '\t' << escapeTsv(input) << '\t'
+             << (matched ? "true" : "false") << '\t' << regexp.matchedLength();
+        for (int i = 0; matched && i <= captureCount; ++i)
+        {
+            _out << '\t' << escapeTsv(RegExpController::spanRef(testee, spans.at(i * 2), spans.at(i * 2 + 1)));
+        }
+        _out << '\n';
+        return;
+    }
+
+    _out << "{\"pattern\":\"" << escapeJson(patternFile)
+         << "\",\"input\":\"" << escapeJson(input)
+         << "\",\"exactMatch\":" << (matched ? "true" : "false")
+         << ",\"length\":" << regexp.matchedLength()
+         << ",\"captures\":[";
+    for (int i = 0; matched && i <= captureCount; ++i)
+    {
+        _out << (i > 0 ? ",\"" : "\"") << escapeJson(RegExpController::spanRef(testee, spans.at(i * 2), spans.at(i * 2 + 1))) << '"';
+    }
+    _out << "]}\n";
+}
+
+QString BatchRunner::escapeTsv(const QString &text)
+{
+    return escapeTsv(QStringRef(&text));
+}
+
+QString BatchRunner::escapeTsv(const QStringRef &text)
+{
+    QString escaped;
+    escaped.reserve(text.length());
+    for (int i = 0; i < text.length(); ++i)
+    {
+        QChar ch = text.at(i);
+        switch (ch.unicode())
+        {
+        case '\\': escaped += "\\\\"; break;
+        case '\t': escaped += "\\t"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        default: escaped += ch; break;
+        }
+    }
+    return escaped;
+}
+
+QString BatchRunner::escapeJson(const QString &text)
+{
+    return escapeJson(QStringRef(&text));
+}
+
+QString BatchRunner::escapeJson(const QStringRef &text)
+{
+    QString escaped;
+    escaped.reserve(text.length());
+    for (int i = 0; i < text.length(); ++i)
+    {
+        QChar ch = text.at(i);
+        switch (ch.unicode())
+        {
+        case '"': escaped += "\\\""; break;
+        case '\\': escaped += "\\\\"; break;
+        case '\t': escaped += "\\t"; break;
+        case '\n': escaped += "\\n"; break;
+        case '\r': escaped += "\\r"; break;
+        default:
+            if (ch.unicode() < 0x20)
+            {
+                escaped += QString("\\u%1").arg(ch.unicode(), 4, 16, QChar('0'));
+            }
+            else
+            {
+                escaped += ch;
+            }
+            break;
+        }
+    }
+    return escaped;
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+#include "regexpcontroller.h"
+
+/*
+ * Headless runner behind "--batch". Only needs a QCoreApplication:
+ *
+ *   QRegExpTester --batch [--exactMatch|--indexIn] [--parallel]
+ *                 [--max-matches N] [--max-time MS]
+ *                 [--format tsv|json] PATTERN.qregexp... [-- INPUT...]
+ *   QRegExpTester --batch --compile LIBRARY PATTERN.qregexp...
+ *
+ * Pattern files may also be precompiled libraries (see PatternLibrary),
+ * which --compile writes from the patterns of the text files given.
+ *
+ * --max-matches and --max-time bound the matches of one pattern in one
+ * input (see RegExpMatchIterator); a scan with a time limit runs
+ * sequentially.
+ *
+ * Without inputs, or with "-" as an input, the testee is read from stdin.
+ * Exits with 0 when anything matched, 1 when nothing did and 2 on errors.
+ */
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode
+    {
+        ExactMatch,
+        IndexIn
+    };
+
+    enum Format
+    {
+        Tsv,
+        Json
+    };
+
+    explicit BatchRunner(QObject *parent = 0);
+    static bool isBatchMode(int argc, char *argv[]);
+    int run(const QStringList &arguments);
+    static QString escapeTsv(const QString &text);
+    static QString escapeTsv(const QStringRef &text);
+    static QString escapeJson(const QString &text);
+    static QString escapeJson(const QStringRef &text);
+
+private:
+    bool parseArguments(const QStringList &arguments);
+    bool loadPatterns(QList<RegExpController *> &patterns, QStringList &labels);
+    void printUsage();
+    bool readInput(const QString &input, QString &testee);
+    int runPattern(RegExpController &regexp, const QString &patternFile,
+                   const QString &input, const QString &testee);
+    void writeMatch(const QString &patternFile, const QString &input,
+                    const QString &testee, const qint64 *spans, int captureCount);
+    void writeExactMatch(const QString &patternFile, const QString &input, const QString &testee,
+                         bool matched, const RegExpController &regexp);
+
+    Mode _mode;
+    Format _format;
+    bool _parallel;
+    int _maxMatches;
+    qint64 _maxMsecs;
+    QString _compileTo;
+    QStringList _patternFiles;
+    QStringList _inputs;
+    QTextStream _out;
+    QTextStream _err;
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,198 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QDateTime>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <qmath.h>
+#include "benchmark.h"
+
+#define NSECS_PER_SEC 1000000000.0
+#define BYTES_PER_MB (1024.0 * 1024.0)
+// Two-sided 95% quantile of the normal distribution.
+#define CONFIDENCE_Z 1.96
+
+BenchmarkResult::BenchmarkResult() :
+    warmup(0),
+    testeeBytes(0),
+    matchesPerPass(0),
+    unfilteredMedian(0)
+{
+}
+
+void BenchmarkResult::addSample(qint64 nsecs)
+{
+    _samples << nsecs;
+    _sorted.clear();
+}
+
+int BenchmarkResult::sampleCount() const
+{
+    return _samples.size();
+}
+
+qint64 BenchmarkResult::minimum() const
+{
+    return percentile(0.0);
+}
+
+qint64 BenchmarkResult::median() const
+{
+    return percentile(50.0);
+}
+
+qint64 BenchmarkResult::percentile(double p) const
+{
+    if (_samples.isEmpty())
+    {
+        return 0;
+    }
+    if (_sorted.size() != _samples.size())
+    {
+        _sorted = _samples;
+        std::sort(_sorted.begin(), _sorted.end());
+    }
+    // Nearest-rank percentile.
+    int rank = qBound(0, int(p / 100.0 * _sorted.size() + 0.999999) - 1, _sorted.size() - 1);
+    return _sorted.at(rank);
+}
+
+double BenchmarkResult::throughput() const
+{
+    qint64 nsecs = median();
+    return nsecs > 0 ? (testeeBytes / BYTES_PER_MB) / (nsecs / NSECS_PER_SEC) : 0.0;
+}
+
+double BenchmarkResult::matchesPerSecond() const
+{
+    qint64 nsecs = median();
+    return nsecs > 0 ? matchesPerPass / (nsecs / NSECS_PER_SEC) : 0.0;
+}
+
+double BenchmarkResult::prefilterSpeedup() const
+{
+    qint64 nsecs = median();
+    return (nsecs > 0 && unfilteredMedian > 0) ? double(unfilteredMedian) / nsecs : 0.0;
+}
+
+QString BenchmarkResult::csvHeader()
+{
+    return QString("timestamp,engine,pattern,warmup,passes,testee_bytes,matches_per_pass,"
+                   "min_ns,median_ns,p99_ns,mb_per_s,matches_per_s");
+}
+
+QString BenchmarkResult::toCsv() const
+{
+    QString quotedPattern = pattern;
+    quotedPattern.replace("\"", "\"\"");
+
+    QStringList fields;
+    fields << QDateTime::currentDateTime().toString(Qt::ISODate)
+           << engine
+           << QString("\"%1\"").arg(quotedPattern)
+           << QString::number(warmup)
+           << QString::number(sampleCount())
+           << QString::number(testeeBytes)
+           << QString::number(matchesPerPass)
+           << QString::number(minimum())
+           << QString::number(median())
+           << QString::number(percentile(99.0))
+           << QString::number(throughput(), 'f', 3)
+           << QString::number(matchesPerSecond(), 'f', 1);
+    return fields.join(",");
+}
+
+ComparisonResult::ComparisonResult() :
+    differenceCount(0)
+{
+}
+
+void ComparisonResult::addSamples(qint64 nsecsA, qint64 nsecsB)
+{
+    a.addSample(nsecsA);
+    b.addSample(nsecsB);
+    _logRatios << qLn(double(qMax(nsecsA, qint64(1))) / qMax(nsecsB, qint64(1)));
+}
+
+int ComparisonResult::sampleCount() const
+{
+    return _logRatios.size();
+}
+
+double ComparisonResult::speedup() const
+{
+    return qExp(meanLogRatio());
+}
+
+void ComparisonResult::speedupInterval(double &low, double &high) const
+{
+    double mean = meanLogRatio();
+    int n = _logRatios.size();
+    if (n < 2)
+    {
+        low = high = qExp(mean);
+        return;
+    }
+    double squares = 0.0;
+    foreach (double ratio, _logRatios)
+    {
+        squares += (ratio - mean) * (ratio - mean);
+    }
+    double margin = CONFIDENCE_Z * qSqrt(squares / (n - 1) / n);
+    low = qExp(mean - margin);
+    high = qExp(mean + margin);
+}
+
+/*
+ * True when the interval leaves out 1, i.e. one side is reliably faster.
+ */
+bool ComparisonResult::isSignificant() const
+{
+    double low;
+    double high;
+    speedupInterval(low, high);
+    return sampleCount() >= 2 && (low > 1.0 || high < 1.0);
+}
+
+double ComparisonResult::meanLogRatio() const
+{
+    double sum = 0.0;
+    foreach (double ratio, _logRatios)
+    {
+        sum += ratio;
+    }
+    return _logRatios.isEmpty() ? 0.0 : sum / _logRatios.size();
+}
+
+int Benchmark::scan(const RegExpController &regexp, const QString &testee)
+{
+    // Only the number of matches is kept.
+    RegExpMatchIterator it(regexp, testee);
+    while (it.next())
+    {
+    }
+    return it.matchCount();
+}
+
+bool Benchmark::appendToCsv(const QString &filename, const BenchmarkResult &result)
+{
+    // One summary row per run, so repeated exports build a history.
+    QFile file(filename);
+    bool writeHeader = !file.exists() || file.size() == 0;
+    if (!file.open(QFile::WriteOnly|QFile::Append|QFile::Text))
+    {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    if (writeHeader)
+    {
+        stream << BenchmarkResult::csvHeader() << endl;
+    }
+    stream << result.toCsv() << endl;
+    file.close();
+    return true;
+}
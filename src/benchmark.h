@@ -0,0 +1,105 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QtGlobal>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "regexpcontroller.h"
+
+/*
+ * Timing samples of a benchmark run. One sample is one full indexIn pass
+ * over the testee, measured with QElapsedTimer in nanoseconds; warm-up
+ * passes are not recorded.
+ *
+ * A prefiltered pattern is timed again with the prefilter turned off;
+ * unfilteredMedian is that run's median (0 when there was none).
+ */
+class BenchmarkResult
+{
+public:
+    BenchmarkResult();
+    void addSample(qint64 nsecs);
+    int sampleCount() const;
+    qint64 minimum() const;
+    qint64 median() const;
+    qint64 percentile(double p) const;
+    double throughput() const;
+    double matchesPerSecond() const;
+    double prefilterSpeedup() const;
+    static QString csvHeader();
+    QString toCsv() const;
+
+    QString engine;
+    QString pattern;
+    int warmup;
+    qint64 testeeBytes;
+    int matchesPerPass;
+    QString prefilter;
+    qint64 unfilteredMedian;
+
+private:
+    QVector<qint64> _samples;
+    mutable QVector<qint64> _sorted;
+};
+
+Q_DECLARE_METATYPE(BenchmarkResult)
+
+/*
+ * A position where the matches of two patterns differ. A side's captured
+ * texts are empty when it has no match starting there.
+ */
+struct MatchDifference
+{
+    int pos;
+    QStringList capturesA;
+    QStringList capturesB;
+};
+
+/*
+ * Interleaved timing of two patterns, A and B, on the same testee, and
+ * the positions where their matches differ. Each sample pair is one pass
+ * of A and one of B, run in alternating order so neither side always
+ * finds the caches warmed up by the other.
+ *
+ * speedup() is the geometric mean of the per-pair ratios A/B, above 1
+ * when B is faster; speedupInterval() is its 95% confidence interval from
+ * a normal approximation of the log ratios.
+ */
+class ComparisonResult
+{
+public:
+    ComparisonResult();
+    void addSamples(qint64 nsecsA, qint64 nsecsB);
+    int sampleCount() const;
+    double speedup() const;
+    void speedupInterval(double &low, double &high) const;
+    bool isSignificant() const;
+
+    BenchmarkResult a;
+    BenchmarkResult b;
+    int differenceCount;
+    QList<MatchDifference> differences;
+
+private:
+    double meanLogRatio() const;
+
+    QVector<double> _logRatios;
+};
+
+Q_DECLARE_METATYPE(ComparisonResult)
+
+class Benchmark
+{
+public:
+    static int scan(const RegExpController &regexp, const QString &testee);
+    static bool appendToCsv(const QString &filename, const BenchmarkResult &result);
+};
+
+#endif // BENCHMARK_H
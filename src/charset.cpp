@@ -0,0 +1,307 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <algorithm>
+#include "charset.h"
+
+// Candidates tried, in order, when a representative character is needed.
+#define SAMPLE_CHARS "a0 A_-.!#\x01"
+
+namespace
+{
+
+// What a character is to the classes: its \d, \w and \s membership.
+enum CharKind
+{
+    DigitKind = 0x01,
+    WordKind = 0x02,
+    SpaceKind = 0x04,
+    KIND_COUNT = 0x08
+};
+
+typedef QVector<QPair<ushort, ushort> > RangeList;
+
+int charKind(ushort ch)
+{
+    QChar c(ch);
+    return (c.isDigit() ? DigitKind : 0) | (CharSet::isWordChar(ch) ? WordKind : 0) | (c.isSpace() ? SpaceKind : 0);
+}
+
+QVector<RangeList> buildKindRanges()
+{
+    QVector<RangeList> ranges(KIND_COUNT);
+    for (uint ch = 0; ch <= 0xFFFF; ++ch)
+    {
+        RangeList &list = ranges[charKind(ushort(ch))];
+        if (!list.isEmpty() && list.last().second == ch - 1)
+        {
+            list.last().second = ushort(ch);
+        }
+        else
+        {
+            list.append(qMakePair(ushort(ch), ushort(ch)));
+        }
+    }
+    return ranges;
+}
+
+// The BMP split up by kind, built on first use.
+const QVector<RangeList> &kindRanges()
+{
+    static const QVector<RangeList> ranges = buildKindRanges();
+    return ranges;
+}
+
+bool rangeEndsBefore(const QPair<ushort, ushort> &range, uint ch)
+{
+    return range.second < ch;
+}
+
+// Whether a character of the kind lies in [first, end).
+bool hasKindIn(int kind, uint first, uint end)
+{
+    const RangeList &list = kindRanges().at(kind);
+    RangeList::const_iterator it = std::lower_bound(list.constBegin(), list.constEnd(), first, rangeEndsBefore);
+    return it != list.constEnd() && it->first < end;
+}
+
+}
+
+CharSet::CharSet() :
+    _classes(0),
+    _negated(false)
+{
+}
+
+CharSet CharSet::any()
+{
+    CharSet set;
+    set.setNegated(true);
+    return set;
+}
+
+CharSet CharSet::single(ushort ch)
+{
+    CharSet set;
+    set.addChar(ch);
+    return set;
+}
+
+CharSet CharSet::fromClass(CharSet::ClassFlag flag)
+{
+    CharSet set;
+    set.addClass(flag);
+    return set;
+}
+
+void CharSet::addChar(ushort ch)
+{
+    addRange(ch, ch);
+}
+
+void CharSet::addRange(ushort first, ushort last)
+{
+    if (first > last)
+    {
+        qSwap(first, last);
+    }
+    _ranges.append(qMakePair(first, last));
+}
+
+void CharSet::addClass(CharSet::ClassFlag flag)
+{
+    _classes |= flag;
+}
+
+void CharSet::setNegated(bool negated)
+{
+    _negated = negated;
+}
+
+bool CharSet::isNegated() const
+{
+    return _negated;
+}
+
+bool CharSet::isEmpty() const
+{
+    return !_negated && _classes == 0 && _ranges.isEmpty();
+}
+
+bool CharSet::isSingleChar() const
+{
+    return !_negated && _classes == 0 && _ranges.size() == 1 && _ranges.first().first == _ranges.first().second;
+}
+
+ushort CharSet::firstChar() const
+{
+    return _ranges.isEmpty() ? 0 : _ranges.first().first;
+}
+
+bool CharSet::contains(ushort ch) const
+{
+    return matchesItems(ch) != _negated;
+}
+
+/*
+ * Case-insensitively a character is in the set when one of its case forms
+ * is listed; in a complemented set, when none of them is.
+ */
+bool CharSet::contains(ushort ch, Qt::CaseSensitivity caseSensitivity) const
+{
+    if (caseSensitivity == Qt::CaseSensitive)
+    {
+        return contains(ch);
+    }
+    QChar c(ch);
+    bool found = matchesItems(ch) || matchesItems(c.toLower().unicode()) || matchesItems(c.toUpper().unicode());
+    return found != _negated;
+}
+
+// Whether a range or class lists ch, before any complement.
+bool CharSet::matchesItems(ushort ch) const
+{
+    return inRanges(ch) || (_classes != 0 && matchesClasses(charKind(ch)));
+}
+
+bool CharSet::inRanges(uint ch) const
+{
+    for (int i = 0; i < _ranges.size(); ++i)
+    {
+        if (ch >= _ranges.at(i).first && ch <= _ranges.at(i).second)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CharSet::matchesClasses(int kind) const
+{
+    return ((_classes & Digit) && (kind & DigitKind))
+           || ((_classes & NotDigit) && !(kind & DigitKind))
+           || ((_classes & Word) && (kind & WordKind))
+           || ((_classes & NotWord) && !(kind & WordKind))
+           || ((_classes & Space) && (kind & SpaceKind))
+           || ((_classes & NotSpace) && !(kind & SpaceKind));
+}
+
+/*
+ * The range bounds of both sets cut the BMP into segments in which range
+ * membership doesn't change, so within one both sets only depend on the
+ * kind of character; the sets meet in a segment holding a character of a
+ * kind both accept there.
+ */
+bool CharSet::intersects(const CharSet &other) const
+{
+    QVector<uint> bounds;
+    bounds << 0 << 0x10000;
+    for (int i = 0; i < _ranges.size(); ++i)
+    {
+        bounds << _ranges.at(i).first << uint(_ranges.at(i).second) + 1;
+    }
+    for (int i = 0; i < other._ranges.size(); ++i)
+    {
+        bounds << other._ranges.at(i).first << uint(other._ranges.at(i).second) + 1;
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+    for (int i = 0; i + 1 < bounds.size(); ++i)
+    {
+        uint first = bounds.at(i);
+        bool inThis = inRanges(first);
+        bool inOther = other.inRanges(first);
+        for (int kind = 0; kind < KIND_COUNT; ++kind)
+        {
+            if (((inThis || matchesClasses(kind)) != _negated)
+                && ((inOther || other.matchesClasses(kind)) != other._negated)
+                && hasKindIn(kind, first, bounds.at(i + 1)))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+ushort CharSet::sampleChar() const
+{
+    static const char *candidates = SAMPLE_CHARS;
+    for (const char *p = candidates; *p; ++p)
+    {
+        if (contains(ushort(*p)))
+        {
+            return ushort(*p);
+        }
+    }
+    if (!_ranges.isEmpty() && !_negated)
+    {
+        return _ranges.first().first;
+    }
+    for (uint ch = 0x20; ch <= 0xFFFF; ++ch)
+    {
+        if (contains(ushort(ch)))
+        {
+            return ushort(ch);
+        }
+    }
+    return 0;
+}
+
+ushort CharSet::sampleOutsideChar() const
+{
+    static const char *candidates = SAMPLE_CHARS;
+    for (const char *p = candidates; *p; ++p)
+    {
+        if (!contains(ushort(*p)))
+        {
+            return ushort(*p);
+        }
+    }
+    for (uint ch = 0x20; ch <= 0xFFFF; ++ch)
+    {
+        if (!contains(ushort(ch)))
+        {
+            return ushort(ch);
+        }
+    }
+    return 0;
+}
+
+bool CharSet::enumerate(QVector<ushort> &chars, int limit) const
+{
+    // Only plain ranges can be listed; classes and complements are huge.
+    if (_negated || _classes != 0)
+    {
+        return false;
+    }
+    chars.clear();
+    for (int i = 0; i < _ranges.size(); ++i)
+    {
+        for (uint ch = _ranges.at(i).first; ch <= _ranges.at(i).second; ++ch)
+        {
+            if (!chars.contains(ushort(ch)))
+            {
+                if (chars.size() == limit)
+                {
+                    return false;
+                }
+                chars << ushort(ch);
+            }
+        }
+    }
+    return true;
+}
+
+bool CharSet::operator==(const CharSet &other) const
+{
+    return _negated == other._negated && _classes == other._classes && _ranges == other._ranges;
+}
+
+bool CharSet::isWordChar(ushort ch)
+{
+    QChar c(ch);
+    return c.isLetterOrNumber() || c.isMark() || ch == '_';
+}
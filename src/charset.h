@@ -0,0 +1,63 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef CHARSET_H
+#define CHARSET_H
+
+#include <QtGlobal>
+#include <QChar>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+/*
+ * A set of UTF-16 code units as used by a pattern atom: explicit ranges
+ * plus the Unicode-aware \d, \w and \s classes (and their negations),
+ * optionally complemented as a whole ("[^...]").
+ */
+class CharSet
+{
+public:
+    enum ClassFlag
+    {
+        Digit = 0x01,
+        NotDigit = 0x02,
+        Word = 0x04,
+        NotWord = 0x08,
+        Space = 0x10,
+        NotSpace = 0x20
+    };
+
+    CharSet();
+    static CharSet any();
+    static CharSet single(ushort ch);
+    static CharSet fromClass(ClassFlag flag);
+    void addChar(ushort ch);
+    void addRange(ushort first, ushort last);
+    void addClass(ClassFlag flag);
+    void setNegated(bool negated);
+    bool isNegated() const;
+    bool isEmpty() const;
+    bool isSingleChar() const;
+    ushort firstChar() const;
+    bool contains(ushort ch) const;
+    bool contains(ushort ch, Qt::CaseSensitivity caseSensitivity) const;
+    bool intersects(const CharSet &other) const;
+    ushort sampleChar() const;
+    ushort sampleOutsideChar() const;
+    bool enumerate(QVector<ushort> &chars, int limit) const;
+    bool operator==(const CharSet &other) const;
+    static bool isWordChar(ushort ch);
+
+private:
+    bool matchesItems(ushort ch) const;
+    bool inRanges(uint ch) const;
+    bool matchesClasses(int kind) const;
+
+    QVector<QPair<ushort, ushort> > _ranges;
+    int _classes;
+    bool _negated;
+};
+
+#endif // CHARSET_H
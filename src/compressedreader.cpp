@@ -0,0 +1,292 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "compressedreader.h"
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define INPUT_BUFFER_BYTES (256 * 1024)
+// 15 window bits, plus 32 to accept a gzip (or zlib) header.
+#define GZIP_WINDOW_BITS (15 + 32)
+
+CompressedReader::CompressedReader() :
+    _format(Uncompressed),
+    _stream(NULL),
+    _inputPos(0),
+    _inputDone(false),
+    _midStream(false),
+    _atEnd(true),
+    _compressedPos(0)
+{
+}
+
+CompressedReader::~CompressedReader()
+{
+    close();
+}
+
+/*
+ * Tells the format by the file's magic bytes, not its extension.
+ */
+CompressedReader::Format CompressedReader::detectFormat(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return Uncompressed;
+    }
+    QByteArray magic = file.read(4);
+    if (magic.startsWith("\x1f\x8b"))
+    {
+        return Gzip;
+    }
+    if (magic == QByteArray("\x28\xb5\x2f\xfd", 4))
+    {
+        return Zstd;
+    }
+    return Uncompressed;
+}
+
+bool CompressedReader::isSupported(CompressedReader::Format format)
+{
+    switch (format)
+    {
+#ifdef HAVE_ZLIB
+    case Gzip:
+        return true;
+#endif
+#ifdef HAVE_ZSTD
+    case Zstd:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+QString CompressedReader::formatName(CompressedReader::Format format)
+{
+    switch (format)
+    {
+    case Gzip:
+        return "gzip";
+    case Zstd:
+        return "zstd";
+    default:
+        return tr("uncompressed");
+    }
+}
+
+bool CompressedReader::open(const QString &filename)
+{
+    close();
+    _error.clear();
+    _format = detectFormat(filename);
+    if (!isSupported(_format))
+    {
+        _error = QString(tr("%1 input is not supported by this build.")).arg(formatName(_format));
+        return false;
+    }
+
+    _file.setFileName(filename);
+    if (!_file.open(QIODevice::ReadOnly))
+    {
+        _error = _file.errorString();
+        return false;
+    }
+
+#ifdef HAVE_ZLIB
+    if (_format == Gzip)
+    {
+        z_stream *stream = new z_stream;
+        stream->zalloc = Z_NULL;
+        stream->zfree = Z_NULL;
+        stream->opaque = Z_NULL;
+        stream->next_in = Z_NULL;
+        stream->avail_in = 0;
+        if (inflateInit2(stream, GZIP_WINDOW_BITS) != Z_OK)
+        {
+            delete stream;
+            _error = tr("Can't initialize the gzip decoder.");
+            _file.close();
+            return false;
+        }
+        _stream = stream;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (_format == Zstd)
+    {
+        ZSTD_DStream *stream = ZSTD_createDStream();
+        if (stream == NULL || ZSTD_isError(ZSTD_initDStream(stream)))
+        {
+            ZSTD_freeDStream(stream);
+            _error = tr("Can't initialize the zstd decoder.");
+            _file.close();
+            return false;
+        }
+        _stream = stream;
+    }
+#endif
+
+    _inputPos = 0;
+    _inputDone = false;
+    _midStream = false;
+    _atEnd = false;
+    _compressedPos = 0;
+    return true;
+}
+
+void CompressedReader::close()
+{
+#ifdef HAVE_ZLIB
+    if (_stream != NULL && _format == Gzip)
+    {
+        z_stream *stream = static_cast<z_stream *>(_stream);
+        inflateEnd(stream);
+        delete stream;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (_stream != NULL && _format == Zstd)
+    {
+        ZSTD_freeDStream(static_cast<ZSTD_DStream *>(_stream));
+    }
+#endif
+    _stream = NULL;
+    _file.close();
+    _input.clear();
+    _atEnd = true;
+}
+
+/*
+ * Returns up to maxSize decompressed bytes; an empty result means the end
+ * of the data or an error (see getError()).
+ */
+QByteArray CompressedReader::read(int maxSize)
+{
+    QByteArray out(maxSize, Qt::Uninitialized);
+    int produced = 0;
+    while (produced < maxSize && !_atEnd)
+    {
+        if (_inputPos == _input.size() && !_inputDone)
+        {
+            _input = _file.read(INPUT_BUFFER_BYTES);
+            _inputPos = 0;
+            _inputDone = _input.isEmpty();
+            _compressedPos += _input.size();
+            if (_inputDone && _file.error() != QFile::NoError)
+            {
+                setError(_file.errorString());
+                break;
+            }
+        }
+
+        int producedBefore = produced;
+        int inputBefore = _inputPos;
+        if (!decompress(out.data(), maxSize, produced))
+        {
+            break;
+        }
+        if (_inputDone && produced == producedBefore && _inputPos == inputBefore)
+        {
+            if (_midStream)
+            {
+                setError(tr("The compressed data ends unexpectedly."));
+            }
+            _atEnd = true;
+        }
+    }
+    out.resize(produced);
+    return out;
+}
+
+bool CompressedReader::atEnd() const
+{
+    return _atEnd;
+}
+
+QString CompressedReader::getError() const
+{
+    return _error;
+}
+
+qint64 CompressedReader::compressedSize() const
+{
+    return _file.size();
+}
+
+qint64 CompressedReader::compressedPos() const
+{
+    return _compressedPos;
+}
+
+/*
+ * Runs the decoder once on the buffered input. A finished gzip member or
+ * zstd frame may be followed by another one, so the decoder is reset
+ * rather than stopped.
+ */
+bool CompressedReader::decompress(char *out, int maxSize, int &produced)
+{
+    int available = _input.size() - _inputPos;
+#ifdef HAVE_ZLIB
+    if (_format == Gzip)
+    {
+        z_stream *stream = static_cast<z_stream *>(_stream);
+        stream->next_in = reinterpret_cast<Bytef *>(_input.data() + _inputPos);
+        stream->avail_in = uInt(available);
+        stream->next_out = reinterpret_cast<Bytef *>(out + produced);
+        stream->avail_out = uInt(maxSize - produced);
+        _midStream = _midStream || available > 0;
+        int result = inflate(stream, Z_NO_FLUSH);
+        produced = maxSize - int(stream->avail_out);
+        _inputPos = _input.size() - int(stream->avail_in);
+        if (result == Z_STREAM_END)
+        {
+            _midStream = false;
+            inflateReset(stream);
+        }
+        else if (result != Z_OK && result != Z_BUF_ERROR)
+        {
+            setError(QString(tr("gzip: %1")).arg(stream->msg != NULL ? stream->msg : "corrupt data"));
+            return false;
+        }
+        return true;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (_format == Zstd)
+    {
+        ZSTD_inBuffer input = { _input.constData() + _inputPos, size_t(available), 0 };
+        ZSTD_outBuffer output = { out + produced, size_t(maxSize - produced), 0 };
+        size_t result = ZSTD_decompressStream(static_cast<ZSTD_DStream *>(_stream), &output, &input);
+        produced += int(output.pos);
+        _inputPos += int(input.pos);
+        if (ZSTD_isError(result))
+        {
+            setError(QString(tr("zstd: %1")).arg(ZSTD_getErrorName(result)));
+            return false;
+        }
+        // 0 means the frame is complete and fully flushed.
+        _midStream = (result != 0);
+        return true;
+    }
+#endif
+    Q_UNUSED(out);
+    Q_UNUSED(maxSize);
+    Q_UNUSED(produced);
+    Q_UNUSED(available);
+    setError(tr("No decoder for this input."));
+    return false;
+}
+
+void CompressedReader::setError(const QString &error)
+{
+    _error = error;
+    _atEnd = true;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef COMPRESSEDREADER_H
+#define COMPRESSEDREADER_H
+
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+/*
+ * Reads the decompressed contents of a gzip or zstd file piece by piece,
+ * so the whole file never has to be in memory. Concatenated gzip members
+ * and zstd frames are read one after the other, as the command line
+ * tools do. Each format is only available when its library (zlib or
+ * libzstd) was found at build time.
+ */
+class CompressedReader
+{
+    Q_DECLARE_TR_FUNCTIONS(CompressedReader)
+public:
+    enum Format
+    {
+        Uncompressed,
+        Gzip,
+        Zstd
+    };
+
+    CompressedReader();
+    ~CompressedReader();
+    static Format detectFormat(const QString &filename);
+    static bool isSupported(Format format);
+    static QString formatName(Format format);
+    bool open(const QString &filename);
+    void close();
+    QByteArray read(int maxSize);
+    bool atEnd() const;
+    QString getError() const;
+    qint64 compressedSize() const;
+    qint64 compressedPos() const;
+
+private:
+    Q_DISABLE_COPY(CompressedReader)
+
+    bool decompress(char *out, int maxSize, int &produced);
+    void setError(const QString &error);
+
+    QFile _file;
+    Format _format;
+    void *_stream;
+    QByteArray _input;
+    int _inputPos;
+    bool _inputDone;
+    bool _midStream;
+    bool _atEnd;
+    qint64 _compressedPos;
+    QString _error;
+};
+
+#endif // COMPRESSEDREADER_H
@@ -0,0 +1,104 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QMutexLocker>
+#include "compressedstream.h"
+#include "compressedreader.h"
+
+#define MAX_QUEUED_CHUNKS 2
+
+CompressedStream::CompressedStream(const QString &filename, int chunkSize, QObject *parent) :
+    QThread(parent),
+    _filename(filename),
+    _chunkSize(qMax(chunkSize, 1)),
+    _finished(false),
+    _canceled(false),
+    _compressedSize(0),
+    _compressedPos(0)
+{
+}
+
+CompressedStream::~CompressedStream()
+{
+    cancel();
+    wait();
+}
+
+/*
+ * Takes the next decompressed chunk, waiting for it if the decoder is
+ * behind. Returns false at the end of the data.
+ */
+bool CompressedStream::readChunk(QByteArray &chunk)
+{
+    QMutexLocker locker(&_mutex);
+    while (_chunks.isEmpty() && !_finished)
+    {
+        _chunkReady.wait(&_mutex);
+    }
+    if (_chunks.isEmpty())
+    {
+        chunk.clear();
+        return false;
+    }
+    chunk = _chunks.dequeue();
+    _chunkTaken.wakeOne();
+    return true;
+}
+
+void CompressedStream::cancel()
+{
+    QMutexLocker locker(&_mutex);
+    _canceled = true;
+    _chunkTaken.wakeOne();
+}
+
+QString CompressedStream::getError() const
+{
+    QMutexLocker locker(&_mutex);
+    return _error;
+}
+
+qint64 CompressedStream::compressedSize() const
+{
+    QMutexLocker locker(&_mutex);
+    return _compressedSize;
+}
+
+qint64 CompressedStream::compressedPos() const
+{
+    QMutexLocker locker(&_mutex);
+    return _compressedPos;
+}
+
+void CompressedStream::run()
+{
+    CompressedReader reader;
+    bool opened = reader.open(_filename);
+    {
+        QMutexLocker locker(&_mutex);
+        _compressedSize = opened ? reader.compressedSize() : 0;
+    }
+
+    while (opened)
+    {
+        QByteArray chunk = reader.read(_chunkSize);
+        QMutexLocker locker(&_mutex);
+        _compressedPos = reader.compressedPos();
+        if (chunk.isEmpty() || _canceled)
+        {
+            break;
+        }
+        while (_chunks.size() >= MAX_QUEUED_CHUNKS && !_canceled)
+        {
+            _chunkTaken.wait(&_mutex);
+        }
+        _chunks.enqueue(chunk);
+        _chunkReady.wakeOne();
+    }
+
+    QMutexLocker locker(&_mutex);
+    _error = reader.getError();
+    _finished = true;
+    _chunkReady.wakeAll();
+}
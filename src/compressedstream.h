@@ -0,0 +1,50 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef COMPRESSEDSTREAM_H
+#define COMPRESSEDSTREAM_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QWaitCondition>
+
+/*
+ * Decompresses a testee file on its own thread, staying up to
+ * MAX_QUEUED_CHUNKS chunks ahead of the matcher that takes them with
+ * readChunk(). Decoding the next chunks thus overlaps with matching the
+ * current one, while memory stays bounded by the chunk size.
+ */
+class CompressedStream : public QThread
+{
+    Q_OBJECT
+public:
+    CompressedStream(const QString &filename, int chunkSize, QObject *parent = 0);
+    ~CompressedStream();
+    bool readChunk(QByteArray &chunk);
+    void cancel();
+    QString getError() const;
+    qint64 compressedSize() const;
+    qint64 compressedPos() const;
+
+protected:
+    void run();
+
+private:
+    QString _filename;
+    int _chunkSize;
+    mutable QMutex _mutex;
+    QWaitCondition _chunkReady;
+    QWaitCondition _chunkTaken;
+    QQueue<QByteArray> _chunks;
+    bool _finished;
+    bool _canceled;
+    QString _error;
+    qint64 _compressedSize;
+    qint64 _compressedPos;
+};
+
+#endif // COMPRESSEDSTREAM_H
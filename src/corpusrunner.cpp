@@ -0,0 +1,457 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <cstdio>
+#include <cstring>
+#include "corpusrunner.h"
+#include "batchrunner.h"
+#include "patternlibrary.h"
+
+#define CORPUS_OPTION "--test"
+#define EXIT_PASSED 0
+#define EXIT_FAILED 1
+#define EXIT_ERROR 2
+// A case's time is the best of this many runs, to keep noise out of the gate.
+#define CASE_TIMING_RUNS 3
+
+namespace
+{
+
+struct FileTester
+{
+    typedef QList<CorpusPatternResult> result_type;
+
+    FileTester(double defaultBudget, bool crossCheck) :
+        _defaultBudget(defaultBudget),
+        _crossCheck(crossCheck)
+    {
+    }
+
+    QList<CorpusPatternResult> operator()(const QString &filename) const
+    {
+        return CorpusRunner::testFile(filename, _defaultBudget, _crossCheck);
+    }
+
+    double _defaultBudget;
+    bool _crossCheck;
+};
+
+}
+
+CorpusRunner::CorpusRunner(QObject *parent) :
+    QObject(parent),
+    _format(Tsv),
+    _jobs(0),
+    _defaultBudget(0.0),
+    _crossCheck(false),
+    _verbose(false),
+    _out(stdout, QIODevice::WriteOnly),
+    _err(stderr, QIODevice::WriteOnly)
+{
+    _out.setCodec("UTF-8");
+    _err.setCodec("UTF-8");
+}
+
+bool CorpusRunner::isCorpusMode(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], CORPUS_OPTION) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int CorpusRunner::run(const QStringList &arguments)
+{
+    if (!parseArguments(arguments))
+    {
+        printUsage();
+        return EXIT_ERROR;
+    }
+
+    QStringList files = collectFiles();
+    if (files.isEmpty())
+    {
+        _err << tr("No pattern files found.") << endl;
+        return EXIT_ERROR;
+    }
+    if (_jobs > 0)
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(_jobs);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<QList<CorpusPatternResult> > results =
+        QtConcurrent::blockingMapped<QList<QList<CorpusPatternResult> > >(files, FileTester(_defaultBudget, _crossCheck));
+
+    int patterns = 0;
+    int cases = 0;
+    int passed = 0;
+    int failed = 0;
+    int slow = 0;
+    int errors = 0;
+    foreach (const QList<CorpusPatternResult> &fileResults, results)
+    {
+        foreach (const CorpusPatternResult &pattern, fileResults)
+        {
+            patterns ++;
+            if (!pattern.error.isEmpty())
+            {
+                errors ++;
+                writeError(pattern);
+                continue;
+            }
+            for (int i = 0; i < pattern.cases.size(); ++i)
+            {
+                const CorpusCaseResult &result = pattern.cases.at(i);
+                cases ++;
+                if (!result.passed)
+                {
+                    failed ++;
+                    writeCase(pattern, i, "FAIL");
+                }
+                else if (result.overBudget)
+                {
+                    slow ++;
+                    writeCase(pattern, i, "SLOW");
+                }
+                else
+                {
+                    passed ++;
+                    if (_verbose)
+                    {
+                        writeCase(pattern, i, "PASS");
+                    }
+                }
+            }
+        }
+    }
+
+    _err << QString(tr("%1 pattern(s) in %2 file(s), %3 case(s): %4 passed, %5 failed, "
+                       "%6 over the latency budget, %7 error(s) in %8 ms."))
+            .arg(patterns).arg(files.size()).arg(cases).arg(passed).arg(failed).arg(slow).arg(errors)
+            .arg(timer.elapsed())
+         << endl;
+    _out.flush();
+    _err.flush();
+    if (errors > 0)
+    {
+        return EXIT_ERROR;
+    }
+    return (failed > 0 || slow > 0) ? EXIT_FAILED : EXIT_PASSED;
+}
+
+/*
+ * Tests every [Pattern] section of a file, or every pattern of a
+ * precompiled library, on the calling thread.
+ */
+QList<CorpusPatternResult> CorpusRunner::testFile(const QString &filename, double defaultBudget, bool crossCheck)
+{
+    QList<CorpusPatternResult> results;
+    if (PatternLibrary::isLibrary(filename))
+    {
+        PatternLibrary library;
+        if (!library.open(filename))
+        {
+            results << errorResult(filename, 0, library.getError());
+            return results;
+        }
+        for (int i = 0; i < library.count(); ++i)
+        {
+            RegExpController regexp;
+            if (!library.load(i, regexp))
+            {
+                results << errorResult(filename, i + 1, library.getError());
+                continue;
+            }
+            results << testPattern(regexp, filename, i + 1, defaultBudget, crossCheck);
+        }
+        return results;
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+    {
+        results << errorResult(filename, 0, file.errorString());
+        return results;
+    }
+    QTextStream stream(&file);
+    QList<QStringList> sections = RegExpController::readSections(stream);
+    file.close();
+
+    for (int i = 0; i < sections.size(); ++i)
+    {
+        RegExpController regexp;
+        if (!regexp.loadFromSection(sections.at(i)))
+        {
+            results << errorResult(filename, i + 1, regexp.getFileError());
+            continue;
+        }
+        results << testPattern(regexp, filename, i + 1, defaultBudget, crossCheck);
+    }
+    return results;
+}
+
+CorpusPatternResult CorpusRunner::testPattern(RegExpController &regexp, const QString &filename, int section,
+                                              double defaultBudget, bool crossCheck)
+{
+    if (!regexp.isPatternValid())
+    {
+        return errorResult(filename, section, regexp.errorString());
+    }
+
+    CorpusPatternResult result;
+    result.filename = filename;
+    result.section = section;
+    result.name = regexp.getName();
+    result.latencyBudget = regexp.getLatencyBudget() > 0.0 ? regexp.getLatencyBudget() : defaultBudget;
+    QList<RegExpController *> others = crossCheck ? otherEngines(regexp) : QList<RegExpController *>();
+    foreach (const RegExpTestCase &testCase, regexp.getTestCases())
+    {
+        CorpusCaseResult caseResult = runCase(regexp, testCase, result.latencyBudget);
+        for (int i = 0; caseResult.passed && i < others.size(); ++i)
+        {
+            // Only the pattern's own engine is held to the latency budget.
+            CorpusCaseResult other = runCase(*others.at(i), testCase, 0.0);
+            if (!other.passed)
+            {
+                caseResult.passed = false;
+                caseResult.detail = QString("%1: %2").arg(RegExpEngine::typeNames().at(others.at(i)->getEngine()))
+                                                     .arg(other.detail);
+            }
+        }
+        result.cases << caseResult;
+    }
+    qDeleteAll(others);
+    return result;
+}
+
+/*
+ * Copies of the pattern for every engine but its own; engines that can't
+ * compile it (e.g. std::regex in minimal mode) are left out.
+ */
+QList<RegExpController *> CorpusRunner::otherEngines(const RegExpController &regexp)
+{
+    QList<RegExpController *> others;
+    for (int type = 0; type < RegExpEngine::typeNames().size(); ++type)
+    {
+        if (type == regexp.getEngine())
+        {
+            continue;
+        }
+        RegExpController *other = new RegExpController();
+        other->copyFrom(regexp);
+        other->setEngine(RegExpEngine::Type(type));
+        if (!other->isPatternValid())
+        {
+            delete other;
+            continue;
+        }
+        others << other;
+    }
+    return others;
+}
+
+CorpusPatternResult CorpusRunner::errorResult(const QString &filename, int section, const QString &error)
+{
+    CorpusPatternResult result;
+    result.filename = filename;
+    result.section = section;
+    result.latencyBudget = 0.0;
+    result.error = error;
+    return result;
+}
+
+bool CorpusRunner::parseArguments(const QStringList &arguments)
+{
+    // arguments[0] is the program itself.
+    for (int i = 1; i < arguments.count(); ++i)
+    {
+        const QString &argument = arguments.at(i);
+        if (argument == CORPUS_OPTION)
+        {
+            continue;
+        }
+        else if (argument == "--verbose")
+        {
+            _verbose = true;
+        }
+        else if (argument == "--cross-check")
+        {
+            _crossCheck = true;
+        }
+        else if (argument == "--jobs" && i + 1 < arguments.count())
+        {
+            bool ok;
+            _jobs = arguments.at(++i).toInt(&ok);
+            if (!ok || _jobs < 1)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--budget" && i + 1 < arguments.count())
+        {
+            bool ok;
+            _defaultBudget = arguments.at(++i).toDouble(&ok);
+            if (!ok || _defaultBudget < 0.0)
+            {
+                return false;
+            }
+        }
+        else if (argument == "--format" && i + 1 < arguments.count())
+        {
+            QString format = arguments.at(++i);
+            if (format.compare("tsv", Qt::CaseInsensitive) == 0)
+            {
+                _format = Tsv;
+            }
+            else if (format.compare("json", Qt::CaseInsensitive) == 0)
+            {
+                _format = Json;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        else if (argument.startsWith("--"))
+        {
+            return false;
+        }
+        else
+        {
+            _paths << argument;
+        }
+    }
+    return !_paths.isEmpty();
+}
+
+void CorpusRunner::printUsage()
+{
+    _err << tr("Usage: QRegExpTester --test [--jobs N] [--budget MS] [--cross-check] [--verbose]\n"
+               "                     [--format tsv|json] (PATTERN.qregexp|DIR)...\n"
+               "Directories are searched for *.qregexp and *.qregexpc files.") << endl;
+}
+
+QStringList CorpusRunner::collectFiles() const
+{
+    QStringList files;
+    foreach (const QString &path, _paths)
+    {
+        if (!QFileInfo(path).isDir())
+        {
+            files << path;
+            continue;
+        }
+        QStringList found;
+        QDirIterator it(path, QStringList() << "*.qregexp" << "*.qregexpc", QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext())
+        {
+            found << it.next();
+        }
+        found.sort();
+        files << found;
+    }
+    return files;
+}
+
+CorpusCaseResult CorpusRunner::runCase(RegExpController &regexp, const RegExpTestCase &testCase, double budget)
+{
+    CorpusCaseResult result;
+    result.testCase = testCase;
+    result.passed = false;
+    result.overBudget = false;
+    result.msecs = 0.0;
+
+    bool matched = false;
+    qint64 best = -1;
+    QElapsedTimer timer;
+    for (int run = 0; run < CASE_TIMING_RUNS; ++run)
+    {
+        timer.start();
+        matched = regexp.isTestExactMatch() ? regexp.exactMatch(testCase.text)
+                                            : regexp.indexIn(testCase.text) != -1;
+        qint64 nsecs = timer.nsecsElapsed();
+        best = (best < 0) ? nsecs : qMin(best, nsecs);
+    }
+    result.msecs = best / 1000000.0;
+    result.overBudget = (budget > 0.0 && result.msecs > budget);
+
+    if (matched != testCase.mustMatch)
+    {
+        result.detail = matched ? tr("matched, expected no match") : tr("no match, expected a match");
+        return result;
+    }
+
+    QMapIterator<int, QString> it(testCase.captures);
+    while (it.hasNext())
+    {
+        it.next();
+        if (it.key() > regexp.captureCount())
+        {
+            result.detail = QString(tr("capture %1 expected, the pattern has %2")).arg(it.key()).arg(regexp.captureCount());
+            return result;
+        }
+        if (regexp.cap(it.key()) != it.value())
+        {
+            result.detail = QString(tr("capture %1 is \"%2\", expected \"%3\""))
+                            .arg(it.key()).arg(regexp.cap(it.key())).arg(it.value());
+            return result;
+        }
+    }
+    result.passed = true;
+    if (result.overBudget)
+    {
+        result.detail = QString(tr("took %1 ms, budget %2 ms")).arg(result.msecs, 0, 'f', 3).arg(budget);
+    }
+    return result;
+}
+
+void CorpusRunner::writeCase(const CorpusPatternResult &pattern, int index, const QString &status)
+{
+    const CorpusCaseResult &result = pattern.cases.at(index);
+    if (_format == Tsv)
+    {
+        _out << status << '\t' << BatchRunner::escapeTsv(pattern.filename) << '\t' << pattern.section
+             << '\t' << index + 1 << '\t' << QString::number(result.msecs, 'f', 3)
+             << '\t' << BatchRunner::escapeTsv(result.testCase.text)
+             << '\t' << BatchRunner::escapeTsv(result.detail) << '\n';
+        return;
+    }
+
+    _out << "{\"status\":\"" << status
+         << "\",\"file\":\"" << BatchRunner::escapeJson(pattern.filename)
+         << "\",\"pattern\":" << pattern.section
+         << ",\"name\":\"" << BatchRunner::escapeJson(pattern.name)
+         << "\",\"case\":" << index + 1
+         << ",\"mustMatch\":" << (result.testCase.mustMatch ? "true" : "false")
+         << ",\"text\":\"" << BatchRunner::escapeJson(result.testCase.text)
+         << "\",\"ms\":" << QString::number(result.msecs, 'f', 3)
+         << ",\"budgetMs\":" << pattern.latencyBudget
+         << ",\"detail\":\"" << BatchRunner::escapeJson(result.detail) << "\"}\n";
+}
+
+void CorpusRunner::writeError(const CorpusPatternResult &pattern)
+{
+    if (_format == Tsv)
+    {
+        _out << "ERROR\t" << BatchRunner::escapeTsv(pattern.filename) << '\t' << pattern.section
+             << "\t\t\t\t" << BatchRunner::escapeTsv(pattern.error) << '\n';
+        return;
+    }
+
+    _out << "{\"status\":\"ERROR\",\"file\":\"" << BatchRunner::escapeJson(pattern.filename)
+         << "\",\"pattern\":" << pattern.section
+         << ",\"detail\":\"" << BatchRunner::escapeJson(pattern.error) << "\"}\n";
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef CORPUSRUNNER_H
+#define CORPUSRUNNER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include "regexpcontroller.h"
+
+struct CorpusCaseResult
+{
+    RegExpTestCase testCase;
+    bool passed;
+    bool overBudget;
+    double msecs;
+    QString detail;
+};
+
+/*
+ * Outcome of the test cases of one [Pattern] section of a file; error is
+ * set when the section couldn't be loaded or its pattern is invalid.
+ */
+struct CorpusPatternResult
+{
+    QString filename;
+    int section;
+    QString name;
+    QString error;
+    double latencyBudget;
+    QList<CorpusCaseResult> cases;
+};
+
+/*
+ * Headless runner behind "--test", checking the test cases embedded in
+ * pattern files:
+ *
+ *   QRegExpTester --test [--jobs N] [--budget MS] [--cross-check] [--verbose]
+ *                 [--format tsv|json] (PATTERN.qregexp|DIR)...
+ *
+ * Directories are searched for *.qregexp files and precompiled *.qregexpc
+ * libraries (see PatternLibrary), which are tested in
+ * parallel on the global thread pool (N threads with --jobs). Every case
+ * is timed as the best of CASE_TIMING_RUNS runs and flagged when that goes
+ * over the pattern's latencyBudgetMs, or the --budget default for patterns
+ * without one. With --cross-check a case also has to pass on every other
+ * engine that accepts the pattern, so engines can't drift apart.
+ *
+ * Failing and slow cases are written to stdout (all cases with --verbose),
+ * the summary to stderr. Exits with 0 when every case passed within its
+ * budget, 1 when one did not and 2 on errors.
+ */
+class CorpusRunner : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format
+    {
+        Tsv,
+        Json
+    };
+
+    explicit CorpusRunner(QObject *parent = 0);
+    static bool isCorpusMode(int argc, char *argv[]);
+    int run(const QStringList &arguments);
+    static QList<CorpusPatternResult> testFile(const QString &filename, double defaultBudget, bool crossCheck);
+
+private:
+    bool parseArguments(const QStringList &arguments);
+    void printUsage();
+    QStringList collectFiles() const;
+    static CorpusPatternResult testPattern(RegExpController &regexp, const QString &filename, int section,
+                                           double defaultBudget, bool crossCheck);
+    static QList<RegExpController *> otherEngines(const RegExpController &regexp);
+    static CorpusPatternResult errorResult(const QString &filename, int section, const QString &error);
+    static CorpusCaseResult runCase(RegExpController &regexp, const RegExpTestCase &testCase, double budget);
+    void writeCase(const CorpusPatternResult &pattern, int index, const QString &status);
+    void writeError(const CorpusPatternResult &pattern);
+
+    Format _format;
+    int _jobs;
+    double _defaultBudget;
+    bool _crossCheck;
+    bool _verbose;
+    QStringList _paths;
+    QTextStream _out;
+    QTextStream _err;
+};
+
+#endif // CORPUSRUNNER_H
@@ -0,0 +1,118 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QMutexLocker>
+#include "enginecache.h"
+
+#define ENGINE_CACHE_CAPACITY 64
+
+Q_GLOBAL_STATIC(EngineCache, globalEngineCache)
+
+EngineCacheKey::EngineCacheKey(RegExpEngine::Type type, const QRegExp &options, QRegExp::CaretMode caretMode) :
+    pattern(options.pattern()),
+    syntax(options.patternSyntax()),
+    caretMode(caretMode),
+    caseSensitivity(options.caseSensitivity()),
+    minimal(options.isMinimal()),
+    type(type)
+{
+}
+
+bool EngineCacheKey::operator==(const EngineCacheKey &other) const
+{
+    return pattern == other.pattern && syntax == other.syntax && caretMode == other.caretMode &&
+           caseSensitivity == other.caseSensitivity && minimal == other.minimal && type == other.type;
+}
+
+uint qHash(const EngineCacheKey &key, uint seed)
+{
+    uint options = uint(key.syntax) | (uint(key.caretMode) << 4) | (uint(key.caseSensitivity) << 8) |
+                   (uint(key.minimal) << 9) | (uint(key.type) << 10);
+    return qHash(key.pattern, seed) ^ qHash(options, seed);
+}
+
+EngineCache::EngineCache(QObject *parent) :
+    QObject(parent),
+    _engines(ENGINE_CACHE_CAPACITY),
+    _hits(0),
+    _misses(0)
+{
+}
+
+EngineCache *EngineCache::instance()
+{
+    return globalEngineCache();
+}
+
+RegExpEngine *EngineCache::acquire(RegExpEngine::Type type, const QRegExp &options, QRegExp::CaretMode caretMode)
+{
+    EngineCacheKey key(type, options, caretMode);
+    RegExpEngine *engine;
+    int hits;
+    int misses;
+    int count;
+    {
+        QMutexLocker locker(&_mutex);
+        RegExpEngine *prototype = _engines.object(key);
+        if (prototype != NULL)
+        {
+            _hits ++;
+            engine = prototype->clone();
+        }
+        else
+        {
+            _misses ++;
+            prototype = RegExpEngine::create(type, options);
+            engine = prototype->clone();
+            // QCache takes ownership, even when it drops the entry at once.
+            _engines.insert(key, prototype);
+        }
+        hits = _hits;
+        misses = _misses;
+        count = _engines.count();
+    }
+    emit statisticsChanged(hits, misses, count);
+    return engine;
+}
+
+void EngineCache::setCapacity(int capacity)
+{
+    QMutexLocker locker(&_mutex);
+    _engines.setMaxCost(capacity);
+}
+
+int EngineCache::capacity() const
+{
+    QMutexLocker locker(&_mutex);
+    return _engines.maxCost();
+}
+
+int EngineCache::hits() const
+{
+    QMutexLocker locker(&_mutex);
+    return _hits;
+}
+
+int EngineCache::misses() const
+{
+    QMutexLocker locker(&_mutex);
+    return _misses;
+}
+
+int EngineCache::count() const
+{
+    QMutexLocker locker(&_mutex);
+    return _engines.count();
+}
+
+void EngineCache::clear()
+{
+    {
+        QMutexLocker locker(&_mutex);
+        _engines.clear();
+        _hits = 0;
+        _misses = 0;
+    }
+    emit statisticsChanged(0, 0, 0);
+}
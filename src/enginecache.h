@@ -0,0 +1,60 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef ENGINECACHE_H
+#define ENGINECACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QMutex>
+#include <QRegExp>
+#include <QString>
+#include "regexpengine.h"
+
+struct EngineCacheKey
+{
+    EngineCacheKey(RegExpEngine::Type type, const QRegExp &options, QRegExp::CaretMode caretMode);
+    bool operator==(const EngineCacheKey &other) const;
+
+    QString pattern;
+    QRegExp::PatternSyntax syntax;
+    QRegExp::CaretMode caretMode;
+    Qt::CaseSensitivity caseSensitivity;
+    bool minimal;
+    RegExpEngine::Type type;
+};
+
+uint qHash(const EngineCacheKey &key, uint seed = 0);
+
+/*
+ * Process-wide LRU cache of compiled engines shared by all tester windows,
+ * workers and batch runs. The cached engine is only a prototype: callers
+ * get a clone, which shares the compiled pattern but has its own match
+ * state, so acquire() is safe to call from any thread.
+ */
+class EngineCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EngineCache(QObject *parent = 0);
+    static EngineCache *instance();
+    RegExpEngine *acquire(RegExpEngine::Type type, const QRegExp &options, QRegExp::CaretMode caretMode);
+    void setCapacity(int capacity);
+    int capacity() const;
+    int hits() const;
+    int misses() const;
+    int count() const;
+    void clear();
+
+signals:
+    void statisticsChanged(int hits, int misses, int count);
+
+private:
+    mutable QMutex _mutex;
+    QCache<EngineCacheKey, RegExpEngine> _engines;
+    int _hits;
+    int _misses;
+};
+
+#endif // ENGINECACHE_H
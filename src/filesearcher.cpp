@@ -0,0 +1,286 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutexLocker>
+#include <algorithm>
+#include "filesearcher.h"
+#include "mappedtestee.h"
+
+// Matches beyond this are counted but not listed.
+#define MAX_ROWS_PER_FILE 1000
+#define MAX_ROW_TEXT 256
+// Bytes decoded at a time, and looked ahead into the next chunk.
+#define DEFAULT_CHUNK_SIZE (16 * 1024 * 1024)
+#define DEFAULT_OVERLAP_SIZE (64 * 1024)
+
+class FileSearcher::Worker : public QThread
+{
+public:
+    Worker(FileSearcher *searcher, int index, const RegExpController &controller) :
+        _searcher(searcher), _index(index), _regexp(new RegExpController()),
+        files(0), bytes(0), matches(0)
+    {
+        _regexp->copyFrom(controller);
+    }
+
+    ~Worker()
+    {
+        wait();
+        delete _regexp;
+    }
+
+protected:
+    void run()
+    {
+        QString filename;
+        while (_searcher->takeFile(_index, filename))
+        {
+            FileSearchResult result = _searcher->searchFile(*_regexp, filename);
+            files ++;
+            bytes += result.bytes;
+            matches += result.matches;
+            emit _searcher->fileSearched(result);
+        }
+    }
+
+private:
+    FileSearcher *_searcher;
+    int _index;
+    RegExpController *_regexp;
+
+public:
+    int files;
+    qint64 bytes;
+    int matches;
+};
+
+FileSearcher::FileSearcher(const RegExpController &controller, const QString &root, const QStringList &globs,
+                           QObject *parent) :
+    QThread(parent),
+    _root(root),
+    _chunkSize(DEFAULT_CHUNK_SIZE),
+    _overlapSize(DEFAULT_OVERLAP_SIZE),
+    _nextQueue(0),
+    _walkDone(false),
+    _canceled(0)
+{
+    qRegisterMetaType<FileSearchResult>("FileSearchResult");
+    foreach (const QString &glob, globs)
+    {
+        if (glob.startsWith('!'))
+        {
+            _excludes << glob.mid(1);
+        }
+        else
+        {
+            _includes << glob;
+        }
+    }
+    if (_includes.isEmpty())
+    {
+        _includes << "*";
+    }
+
+    int count = qMax(QThread::idealThreadCount(), 1);
+    for (int i = 0; i < count; ++i)
+    {
+        _workers << new Worker(this, i, controller);
+    }
+    _queues.resize(count);
+}
+
+FileSearcher::~FileSearcher()
+{
+    cancel();
+    wait();
+    qDeleteAll(_workers);
+}
+
+QString FileSearcher::getRoot() const
+{
+    return _root;
+}
+
+void FileSearcher::setChunking(qint64 chunkSize, qint64 overlapSize)
+{
+    _chunkSize = qBound(qint64(1), chunkSize, qint64(1024) * 1024 * 1024);
+    _overlapSize = qMax(overlapSize, qint64(0));
+}
+
+void FileSearcher::cancel()
+{
+    _canceled.fetchAndStoreOrdered(1);
+    QMutexLocker locker(&_mutex);
+    _workAvailable.wakeAll();
+}
+
+bool FileSearcher::isCanceled() const
+{
+    return _canceled.loadAcquire() != 0;
+}
+
+void FileSearcher::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+    foreach (Worker *worker, _workers)
+    {
+        worker->start();
+    }
+
+    walk();
+    {
+        QMutexLocker locker(&_mutex);
+        _walkDone = true;
+        _workAvailable.wakeAll();
+    }
+
+    int files = 0;
+    qint64 bytes = 0;
+    int matches = 0;
+    foreach (Worker *worker, _workers)
+    {
+        worker->wait();
+        files += worker->files;
+        bytes += worker->bytes;
+        matches += worker->matches;
+    }
+    if (!isCanceled())
+    {
+        emit searchFinished(files, bytes, matches, timer.nsecsElapsed());
+    }
+}
+
+void FileSearcher::walk()
+{
+    QDir root(_root);
+    QDirIterator it(_root, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    while (!isCanceled() && it.hasNext())
+    {
+        QString filename = it.next();
+        if (!QDir::match(_includes, it.fileName()) || QDir::match(_excludes, it.fileName()) ||
+            QDir::match(_excludes, root.relativeFilePath(filename)))
+        {
+            continue;
+        }
+        addFile(filename);
+    }
+}
+
+void FileSearcher::addFile(const QString &filename)
+{
+    QMutexLocker locker(&_mutex);
+    _queues[_nextQueue] << filename;
+    _nextQueue = (_nextQueue + 1) % _queues.size();
+    _workAvailable.wakeOne();
+}
+
+/*
+ * Hands a worker its next file, stealing one when its own deque is
+ * empty. Returns false once the walk is over and every deque is empty.
+ */
+bool FileSearcher::takeFile(int worker, QString &filename)
+{
+    QMutexLocker locker(&_mutex);
+    forever
+    {
+        if (isCanceled())
+        {
+            return false;
+        }
+        if (!_queues.at(worker).isEmpty())
+        {
+            filename = _queues[worker].takeFirst();
+            return true;
+        }
+        int victim = -1;
+        for (int i = 0; i < _queues.size(); ++i)
+        {
+            if (!_queues.at(i).isEmpty() && (victim < 0 || _queues.at(i).size() > _queues.at(victim).size()))
+            {
+                victim = i;
+            }
+        }
+        if (victim >= 0)
+        {
+            filename = _queues[victim].takeLast();
+            return true;
+        }
+        if (_walkDone)
+        {
+            return false;
+        }
+        _workAvailable.wait(&_mutex);
+    }
+}
+
+FileSearchResult FileSearcher::searchFile(RegExpController &regexp, const QString &filename) const
+{
+    FileSearchResult result;
+    result.filename = QDir(_root).relativeFilePath(filename);
+    result.bytes = 0;
+    result.matches = 0;
+    result.nsecs = 0;
+
+    MappedTestee testee;
+    if (!testee.open(filename))
+    {
+        result.error = testee.getError();
+        return result;
+    }
+    const char *data = testee.data();
+    qint64 size = testee.size();
+    result.bytes = size;
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 chunkStart = 0;
+    qint64 resumeByte = 0;
+    qint64 lineFromByte = 0;
+    int line = 1;
+    while (!isCanceled() && chunkStart < size)
+    {
+        qint64 chunkEnd = testee.alignToChar(chunkStart + _chunkSize);
+        if (chunkEnd <= chunkStart)
+        {
+            chunkEnd = qMin(size, chunkStart + _chunkSize);
+        }
+        qint64 overlapEnd = testee.alignToChar(chunkEnd + _overlapSize);
+        QString text = QString::fromUtf8(data + chunkStart, int(chunkEnd - chunkStart));
+        int ownLength = text.length();
+        text += QString::fromUtf8(data + chunkEnd, int(overlapEnd - chunkEnd));
+
+        // Only the first chunk starts at the real beginning of the file.
+        RegExpMatchIterator it(regexp, text, MappedTestee::utf16Length(data + chunkStart, resumeByte - chunkStart));
+        if (chunkStart > 0)
+        {
+            it.setCaretMode(QRegExp::CaretWontMatch);
+        }
+        int cursorChar = 0;
+        qint64 cursorByte = chunkStart;
+        while (!isCanceled() && it.next() && it.pos() < ownLength)
+        {
+            int pos = it.pos();
+            int len = it.matchedLength();
+            cursorByte += MappedTestee::utf8Length(text.constData() + cursorChar, pos - cursorChar);
+            cursorChar = pos;
+            if (result.matches < MAX_ROWS_PER_FILE)
+            {
+                line += int(std::count(data + lineFromByte, data + cursorByte, '\n'));
+                lineFromByte = cursorByte;
+                result.rows << MatchResultRow(QString(tr("line %1")).arg(line), text.mid(pos, qMin(len, MAX_ROW_TEXT)));
+            }
+            resumeByte = cursorByte + MappedTestee::utf8Length(text.constData() + pos, len);
+            result.matches ++;
+        }
+        resumeByte = qMax(resumeByte, chunkEnd);
+        chunkStart = chunkEnd;
+    }
+    result.nsecs = timer.nsecsElapsed();
+    return result;
+}
@@ -0,0 +1,93 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef FILESEARCHER_H
+#define FILESEARCHER_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QList>
+#include <QMetaType>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
+#include "regexpcontroller.h"
+#include "matchworker.h"
+
+struct FileSearchResult
+{
+    QString filename;
+    QString error;
+    qint64 bytes;
+    int matches;
+    qint64 nsecs;
+    MatchResultRows rows;
+};
+
+Q_DECLARE_METATYPE(FileSearchResult)
+
+/*
+ * Runs indexIn over every file below a root directory whose name matches
+ * one of the include globs and whose name or relative path matches none
+ * of the exclude globs (the ones given with a leading "!").
+ *
+ * The searcher thread walks the tree and deals the files out round-robin
+ * to one deque per worker thread. A worker takes files from the front of
+ * its own deque and, once that runs dry, steals from the back of the
+ * longest other one, so a few huge files don't leave the other workers
+ * idle. Every worker matches with its own RegExpController clone.
+ *
+ * Files are mapped (MappedTestee) and decoded one chunk at a time, each
+ * with a look-ahead overlap into the next one, like a mapped testee in
+ * MatchWorker, so no file is held twice or limited by QString's size. A
+ * match running past the overlap is cut short.
+ *
+ * Each searched file is reported with fileSearched(), carrying its match
+ * count, timing and up to MAX_ROWS_PER_FILE result rows built right away,
+ * since the file contents aren't kept.
+ */
+class FileSearcher : public QThread
+{
+    Q_OBJECT
+public:
+    FileSearcher(const RegExpController &controller, const QString &root, const QStringList &globs,
+                 QObject *parent = 0);
+    ~FileSearcher();
+    QString getRoot() const;
+    void setChunking(qint64 chunkSize, qint64 overlapSize);
+    void cancel();
+    bool isCanceled() const;
+
+signals:
+    void fileSearched(const FileSearchResult &result);
+    void searchFinished(int files, qint64 bytes, int matches, qint64 nsecs);
+
+protected:
+    void run();
+
+private:
+    class Worker;
+
+    void walk();
+    void addFile(const QString &filename);
+    bool takeFile(int worker, QString &filename);
+    FileSearchResult searchFile(RegExpController &regexp, const QString &filename) const;
+
+    QString _root;
+    QStringList _includes;
+    QStringList _excludes;
+    qint64 _chunkSize;
+    qint64 _overlapSize;
+    QList<Worker *> _workers;
+    QMutex _mutex;
+    QWaitCondition _workAvailable;
+    QVector<QStringList> _queues;
+    int _nextQueue;
+    bool _walkDone;
+    QAtomicInt _canceled;
+};
+
+#endif // FILESEARCHER_H
@@ -0,0 +1,366 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "fixedstringmatcher.h"
+#include <QtAlgorithms>
+#include <QByteArray>
+#include <QChar>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIXEDSTRING_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(FIXEDSTRING_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define FIXEDSTRING_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 code in functions that ask for it.
+#if defined(FIXEDSTRING_AVX2) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace
+{
+
+// What the kernels need to know about the needle.
+struct Probe
+{
+    const ushort *needle;
+    int length;
+    bool folded;
+    const ushort *first;
+    const ushort *last;
+};
+
+inline ushort foldChar(ushort ch)
+{
+    return QChar(ch).toLower().unicode();
+}
+
+// Every code unit keyed by what it folds to: (folded << 16) | unit, sorted.
+QVector<uint> buildFoldTable()
+{
+    QVector<uint> table(0x10000);
+    for (uint ch = 0; ch <= 0xFFFF; ++ch)
+    {
+        table[int(ch)] = (uint(foldChar(ushort(ch))) << 16) | ch;
+    }
+    std::sort(table.begin(), table.end());
+    return table;
+}
+
+// Built on first use and shared by every matcher.
+const QVector<uint> &foldTable()
+{
+    static const QVector<uint> table = buildFoldTable();
+    return table;
+}
+
+inline bool verifyAt(const Probe &probe, const ushort *text)
+{
+    if (!probe.folded)
+    {
+        return memcmp(text, probe.needle, probe.length * sizeof(ushort)) == 0;
+    }
+    for (int i = 0; i < probe.length; ++i)
+    {
+        if (foldChar(text[i]) != probe.needle[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int searchScalar(const Probe &probe, const ushort *text, int length, int from)
+{
+    for (int i = from; i + probe.length <= length; ++i)
+    {
+        if (verifyAt(probe, text + i))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+#ifdef FIXEDSTRING_SSE2
+int searchSse2(const Probe &probe, const ushort *text, int length, int from)
+{
+    const int last = probe.length - 1;
+    __m128i first0 = _mm_set1_epi16(short(probe.first[0]));
+    __m128i first1 = _mm_set1_epi16(short(probe.first[1]));
+    __m128i first2 = _mm_set1_epi16(short(probe.first[2]));
+    __m128i last0 = _mm_set1_epi16(short(probe.last[0]));
+    __m128i last1 = _mm_set1_epi16(short(probe.last[1]));
+    __m128i last2 = _mm_set1_epi16(short(probe.last[2]));
+
+    int i = from;
+    for (; i + last + 8 <= length; i += 8)
+    {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i + last));
+        __m128i headHits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(head, first0), _mm_cmpeq_epi16(head, first1)),
+                                        _mm_cmpeq_epi16(head, first2));
+        __m128i tailHits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(tail, last0), _mm_cmpeq_epi16(tail, last1)),
+                                        _mm_cmpeq_epi16(tail, last2));
+        // Two mask bits per code unit.
+        uint mask = uint(_mm_movemask_epi8(_mm_and_si128(headHits, tailHits)));
+        while (mask != 0)
+        {
+            int bit = qCountTrailingZeroBits(mask);
+            if (verifyAt(probe, text + i + bit / 2))
+            {
+                return i + bit / 2;
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+    return searchScalar(probe, text, length, i);
+}
+#endif
+
+#ifdef FIXEDSTRING_AVX2
+TARGET_AVX2 int searchAvx2(const Probe &probe, const ushort *text, int length, int from)
+{
+    const int last = probe.length - 1;
+    __m256i first0 = _mm256_set1_epi16(short(probe.first[0]));
+    __m256i first1 = _mm256_set1_epi16(short(probe.first[1]));
+    __m256i first2 = _mm256_set1_epi16(short(probe.first[2]));
+    __m256i last0 = _mm256_set1_epi16(short(probe.last[0]));
+    __m256i last1 = _mm256_set1_epi16(short(probe.last[1]));
+    __m256i last2 = _mm256_set1_epi16(short(probe.last[2]));
+
+    int i = from;
+    for (; i + last + 16 <= length; i += 16)
+    {
+        __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i));
+        __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + i + last));
+        __m256i headHits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(head, first0), _mm256_cmpeq_epi16(head, first1)),
+                                           _mm256_cmpeq_epi16(head, first2));
+        __m256i tailHits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(tail, last0), _mm256_cmpeq_epi16(tail, last1)),
+                                           _mm256_cmpeq_epi16(tail, last2));
+        uint mask = uint(_mm256_movemask_epi8(_mm256_and_si256(headHits, tailHits)));
+        while (mask != 0)
+        {
+            int bit = qCountTrailingZeroBits(mask);
+            if (verifyAt(probe, text + i + bit / 2))
+            {
+                return i + bit / 2;
+            }
+            mask &= ~(3u << bit);
+        }
+    }
+    return searchScalar(probe, text, length, i);
+}
+#endif
+
+} // namespace
+
+FixedStringMatcher::FixedStringMatcher() :
+    _folded(false),
+    _kernel(Scalar)
+{
+}
+
+FixedStringMatcher::FixedStringMatcher(const QString &needle, Qt::CaseSensitivity caseSensitivity) :
+    _needle(needle),
+    _folded(caseSensitivity == Qt::CaseInsensitive),
+    _kernel(Scalar)
+{
+    if (_needle.isEmpty())
+    {
+        return;
+    }
+    if (!_folded)
+    {
+        for (int i = 0; i < MAX_FOLD_VARIANTS; ++i)
+        {
+            _first[i] = _needle.at(0).unicode();
+            _last[i] = _needle.at(_needle.length() - 1).unicode();
+        }
+        _kernel = supportedKernel();
+        return;
+    }
+
+    for (int i = 0; i < _needle.length(); ++i)
+    {
+        _needle[i] = QChar(foldChar(_needle.at(i).unicode()));
+    }
+    if (foldVariants(_needle.at(0).unicode(), _first) > 0
+        && foldVariants(_needle.at(_needle.length() - 1).unicode(), _last) > 0)
+    {
+        _kernel = supportedKernel();
+    }
+}
+
+int FixedStringMatcher::length() const
+{
+    return _needle.length();
+}
+
+FixedStringMatcher::Kernel FixedStringMatcher::kernel() const
+{
+    return _kernel;
+}
+
+int FixedStringMatcher::indexIn(const QString &text, int from) const
+{
+    return indexIn(text.utf16(), text.length(), from);
+}
+
+/*
+ * Returns the first occurrence starting at or after from, or -1.
+ */
+int FixedStringMatcher::indexIn(const ushort *text, int length, int from) const
+{
+    if (from < 0 || from > length)
+    {
+        return -1;
+    }
+    if (_needle.isEmpty())
+    {
+        return from;
+    }
+
+    Probe probe;
+    probe.needle = _needle.utf16();
+    probe.length = _needle.length();
+    probe.folded = _folded;
+    probe.first = _first;
+    probe.last = _last;
+
+    switch (_kernel)
+    {
+#ifdef FIXEDSTRING_AVX2
+    case Avx2:
+        return searchAvx2(probe, text, length, from);
+#endif
+#ifdef FIXEDSTRING_SSE2
+    case Sse2:
+        return searchSse2(probe, text, length, from);
+#endif
+    default:
+        return searchScalar(probe, text, length, from);
+    }
+}
+
+/*
+ * Returns the last occurrence starting at or after from, or -1.
+ */
+int FixedStringMatcher::lastIndexIn(const ushort *text, int length, int from) const
+{
+    if (_needle.isEmpty())
+    {
+        return (from >= 0 && from <= length) ? length : -1;
+    }
+    int found = -1;
+    for (int pos = indexIn(text, length, from); pos >= 0; pos = indexIn(text, length, pos + 1))
+    {
+        found = pos;
+    }
+    return found;
+}
+
+bool FixedStringMatcher::matchesAt(const ushort *text) const
+{
+    Probe probe;
+    probe.needle = _needle.utf16();
+    probe.length = _needle.length();
+    probe.folded = _folded;
+    return verifyAt(probe, text);
+}
+
+FixedStringMatcher::Kernel FixedStringMatcher::supportedKernel()
+{
+    static const Kernel kernel = detectKernel();
+    return kernel;
+}
+
+QString FixedStringMatcher::kernelName(FixedStringMatcher::Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Avx2:
+        return "AVX2";
+    case Sse2:
+        return "SSE2";
+    default:
+        return "scalar";
+    }
+}
+
+FixedStringMatcher::Kernel FixedStringMatcher::detectKernel()
+{
+    QByteArray cap = qgetenv("QREGEXPTESTER_SIMD").toLower();
+    if (cap == "scalar")
+    {
+        return Scalar;
+    }
+
+#if defined(FIXEDSTRING_AVX2) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (cap != "sse2" && __builtin_cpu_supports("avx2"))
+    {
+        return Avx2;
+    }
+#elif defined(FIXEDSTRING_AVX2) && defined(_MSC_VER)
+    // AVX2 needs the CPU flag and the OS saving the YMM registers.
+    int info[4];
+    __cpuid(info, 0);
+    if (cap != "sse2" && info[0] >= 7)
+    {
+        __cpuid(info, 1);
+        bool osSavesYmm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        if (osSavesYmm && (info[1] & (1 << 5)))
+        {
+            return Avx2;
+        }
+    }
+#endif
+
+#ifdef FIXEDSTRING_SSE2
+    return Sse2;
+#else
+    return Scalar;
+#endif
+}
+
+/*
+ * Lists the code units that fold to folded, padded with repeats. Returns
+ * 0 when there are too many for the vector kernels.
+ */
+int FixedStringMatcher::foldVariants(ushort folded, ushort *variants)
+{
+    const QVector<uint> &table = foldTable();
+    QVector<uint>::const_iterator it = std::lower_bound(table.constBegin(), table.constEnd(), uint(folded) << 16);
+    int count = 0;
+    for (; it != table.constEnd() && (*it >> 16) == folded; ++it)
+    {
+        if (count == MAX_FOLD_VARIANTS)
+        {
+            return 0;
+        }
+        variants[count++] = ushort(*it & 0xFFFF);
+    }
+    if (count == 0)
+    {
+        return 0;
+    }
+    for (int i = count; i < MAX_FOLD_VARIANTS; ++i)
+    {
+        variants[i] = variants[0];
+    }
+    return count;
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef FIXEDSTRINGMATCHER_H
+#define FIXEDSTRINGMATCHER_H
+
+#include <QtGlobal>
+#include <QString>
+
+// Code units folding to the same one the vector kernels can look for.
+#define MAX_FOLD_VARIANTS 3
+
+/*
+ * Search for a fixed needle in UTF-16 text. The SSE2 and AVX2 kernels
+ * compare the needle's first and last code units against 8 or 16
+ * positions at once and only verify the positions where both fit. The
+ * widest kernel the CPU supports is picked at runtime (capped by the
+ * QREGEXPTESTER_SIMD environment variable: "scalar" or "sse2"), with a
+ * scalar loop as the fallback.
+ *
+ * Case-insensitive search compares lower-cased code units, as QRegExp
+ * does. It stays vectorized as long as few code units fold to the
+ * needle's first and last ones, which always holds for ASCII.
+ */
+class FixedStringMatcher
+{
+public:
+    enum Kernel
+    {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    FixedStringMatcher();
+    FixedStringMatcher(const QString &needle, Qt::CaseSensitivity caseSensitivity);
+    int length() const;
+    Kernel kernel() const;
+    int indexIn(const QString &text, int from) const;
+    int indexIn(const ushort *text, int length, int from) const;
+    int lastIndexIn(const ushort *text, int length, int from) const;
+    bool matchesAt(const ushort *text) const;
+    static Kernel supportedKernel();
+    static QString kernelName(Kernel kernel);
+
+private:
+    static Kernel detectKernel();
+    static int foldVariants(ushort folded, ushort *variants);
+
+    QString _needle;
+    bool _folded;
+    Kernel _kernel;
+    ushort _first[MAX_FOLD_VARIANTS];
+    ushort _last[MAX_FOLD_VARIANTS];
+};
+
+#endif // FIXEDSTRINGMATCHER_H
@@ -0,0 +1,292 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "globregexpengine.h"
+#include "patternparser.h"
+
+GlobRegExpEngine::GlobRegExpEngine(const QRegExp &options) :
+    _options(options),
+    _matchPos(-1),
+    _matchLength(-1)
+{
+    compile(options, _segments);
+}
+
+/*
+ * Tells whether options describe a pattern this engine can run: a fixed
+ * string or wildcard that translates to sets and ".*" only.
+ */
+bool GlobRegExpEngine::supports(const QRegExp &options)
+{
+    QVector<Segment> segments;
+    return compile(options, segments);
+}
+
+RegExpEngine::Type GlobRegExpEngine::type() const
+{
+    return LegacyQRegExp;
+}
+
+QString GlobRegExpEngine::name() const
+{
+    FixedStringMatcher::Kernel kernel = FixedStringMatcher::Scalar;
+    foreach (const Segment &segment, _segments)
+    {
+        if (segment.literal && segment.matcher.length() > 0)
+        {
+            kernel = qMax(kernel, segment.matcher.kernel());
+        }
+    }
+    QString kernelName = FixedStringMatcher::kernelName(kernel);
+    if (_options.patternSyntax() == QRegExp::FixedString)
+    {
+        return tr("QRegExp (%1 substring search)").arg(kernelName);
+    }
+    return tr("QRegExp (glob matcher, %1)").arg(kernelName);
+}
+
+RegExpEngine *GlobRegExpEngine::clone() const
+{
+    GlobRegExpEngine *engine = new GlobRegExpEngine(*this);
+    engine->setMatch(QString(), -1, -1);
+    return engine;
+}
+
+bool GlobRegExpEngine::isValid() const
+{
+    return !_segments.isEmpty();
+}
+
+QString GlobRegExpEngine::errorString() const
+{
+    return _options.errorString();
+}
+
+bool GlobRegExpEngine::exactMatch(const QString &str)
+{
+    setMatch(str, -1, -1);
+    const ushort *text = str.utf16();
+    int length = str.length();
+    const Segment &head = _segments.first();
+    int end = head.sets.size();
+    if (end > length || !matchesAt(head, text))
+    {
+        return false;
+    }
+    if (_segments.size() == 1)
+    {
+        if (end != length)
+        {
+            return false;
+        }
+        setMatch(str, 0, length);
+        return true;
+    }
+
+    // The last segment sits at the very end, the others fit in between.
+    const Segment &tail = _segments.last();
+    int tailStart = length - tail.sets.size();
+    if (tailStart < end || !matchesAt(tail, text + tailStart))
+    {
+        return false;
+    }
+    for (int i = 1; i < _segments.size() - 1; ++i)
+    {
+        const Segment &segment = _segments.at(i);
+        int at = find(segment, text, tailStart, end);
+        if (at < 0)
+        {
+            return false;
+        }
+        end = at + segment.sets.size();
+    }
+    setMatch(str, 0, length);
+    return true;
+}
+
+int GlobRegExpEngine::indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode)
+{
+    // Wildcards have no '^', so the caret mode doesn't matter.
+    Q_UNUSED(caretMode);
+    setMatch(str, -1, -1);
+    const ushort *text = str.utf16();
+    int length = str.length();
+    if (offset < 0)
+    {
+        offset += length;
+    }
+    if (offset < 0 || offset > length)
+    {
+        return -1;
+    }
+
+    const Segment &head = _segments.first();
+    int start = find(head, text, length, offset);
+    if (start < 0)
+    {
+        return -1;
+    }
+    int end = start + head.sets.size();
+    for (int i = 1; i < _segments.size(); ++i)
+    {
+        const Segment &segment = _segments.at(i);
+        bool longest = (i == _segments.size() - 1) && !_options.isMinimal();
+        int at = longest ? findLast(segment, text, length, end) : find(segment, text, length, end);
+        if (at < 0)
+        {
+            return -1;
+        }
+        end = at + segment.sets.size();
+    }
+    setMatch(str, start, end - start);
+    return start;
+}
+
+int GlobRegExpEngine::captureCount() const
+{
+    return 0;
+}
+
+int GlobRegExpEngine::pos(int nth) const
+{
+    return nth == 0 ? _matchPos : -1;
+}
+
+int GlobRegExpEngine::capturedLength(int nth) const
+{
+    return nth == 0 ? _matchLength : 0;
+}
+
+QString GlobRegExpEngine::cap(int nth) const
+{
+    return (nth == 0 && _matchPos >= 0) ? _subject.mid(_matchPos, _matchLength) : QString();
+}
+
+bool GlobRegExpEngine::searchesLiterals() const
+{
+    return true;
+}
+
+bool GlobRegExpEngine::compile(const QRegExp &options, QVector<GlobRegExpEngine::Segment> &segments)
+{
+    QRegExp::PatternSyntax syntax = options.patternSyntax();
+    if (syntax != QRegExp::FixedString && syntax != QRegExp::Wildcard && syntax != QRegExp::WildcardUnix)
+    {
+        return false;
+    }
+    PatternParser parser(options);
+    if (!parser.isValid())
+    {
+        return false;
+    }
+
+    // The translated pattern is a sequence of sets and ".*" stars.
+    QList<const PatternNode *> nodes;
+    const PatternNode *root = parser.root();
+    if (root->type == PatternNode::Sequence)
+    {
+        foreach (const PatternNode *child, root->children)
+        {
+            nodes << child;
+        }
+    }
+    else if (root->type != PatternNode::Empty)
+    {
+        nodes << root;
+    }
+
+    segments.clear();
+    segments.resize(1);
+    foreach (const PatternNode *node, nodes)
+    {
+        if (node->type == PatternNode::Set)
+        {
+            segments.last().sets << node->set;
+        }
+        else if (node->type == PatternNode::Repeat && node->min == 0 && node->max < 0
+                 && node->children.first()->type == PatternNode::Set
+                 && node->children.first()->set == CharSet::any())
+        {
+            segments.resize(segments.size() + 1);
+        }
+        else
+        {
+            segments.clear();
+            return false;
+        }
+    }
+
+    for (int i = 0; i < segments.size(); ++i)
+    {
+        Segment &segment = segments[i];
+        QString literal;
+        segment.literal = true;
+        foreach (const CharSet &set, segment.sets)
+        {
+            segment.literal = segment.literal && set.isSingleChar();
+            literal += QChar(set.firstChar());
+        }
+        if (segment.literal)
+        {
+            segment.matcher = FixedStringMatcher(literal, parser.caseSensitivity());
+        }
+    }
+    return true;
+}
+
+bool GlobRegExpEngine::matchesAt(const GlobRegExpEngine::Segment &segment, const ushort *text) const
+{
+    if (segment.literal)
+    {
+        return segment.matcher.matchesAt(text);
+    }
+    Qt::CaseSensitivity caseSensitivity = _options.caseSensitivity();
+    for (int i = 0; i < segment.sets.size(); ++i)
+    {
+        if (!segment.sets.at(i).contains(text[i], caseSensitivity))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int GlobRegExpEngine::find(const GlobRegExpEngine::Segment &segment, const ushort *text, int length, int from) const
+{
+    if (segment.literal)
+    {
+        return segment.matcher.indexIn(text, length, from);
+    }
+    for (int i = from; i + segment.sets.size() <= length; ++i)
+    {
+        if (matchesAt(segment, text + i))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int GlobRegExpEngine::findLast(const GlobRegExpEngine::Segment &segment, const ushort *text, int length, int from) const
+{
+    if (segment.literal)
+    {
+        return segment.matcher.lastIndexIn(text, length, from);
+    }
+    for (int i = length - segment.sets.size(); i >= from; --i)
+    {
+        if (matchesAt(segment, text + i))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void GlobRegExpEngine::setMatch(const QString &str, int pos, int length)
+{
+    _subject = str;
+    _matchPos = pos;
+    _matchLength = length;
+}
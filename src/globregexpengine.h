@@ -0,0 +1,66 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef GLOBREGEXPENGINE_H
+#define GLOBREGEXPENGINE_H
+
+#include <QCoreApplication>
+#include <QVector>
+#include "charset.h"
+#include "fixedstringmatcher.h"
+#include "regexpengine.h"
+
+/*
+ * Stands in for QRegExp on FixedString, Wildcard and WildcardUnix
+ * patterns, which need no backtracking. The pattern is split on its stars
+ * into segments of single-character sets; purely literal segments are
+ * searched with FixedStringMatcher's vector kernels.
+ *
+ * QRegExp's leftmost-longest match is then found directly: the first
+ * segment at its leftmost fit, every middle segment at its earliest fit
+ * after the one before, and the last segment at its last fit (its first
+ * fit with minimal matching). When the middle segments don't fit after
+ * the leftmost start they don't fit after any later one either.
+ */
+class GlobRegExpEngine : public RegExpEngine
+{
+    Q_DECLARE_TR_FUNCTIONS(GlobRegExpEngine)
+public:
+    explicit GlobRegExpEngine(const QRegExp &options);
+    static bool supports(const QRegExp &options);
+    Type type() const;
+    QString name() const;
+    RegExpEngine *clone() const;
+    bool isValid() const;
+    QString errorString() const;
+    bool exactMatch(const QString &str);
+    int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode);
+    int captureCount() const;
+    int pos(int nth) const;
+    int capturedLength(int nth) const;
+    QString cap(int nth) const;
+    bool searchesLiterals() const;
+
+private:
+    struct Segment
+    {
+        QVector<CharSet> sets;
+        bool literal;
+        FixedStringMatcher matcher;
+    };
+
+    static bool compile(const QRegExp &options, QVector<Segment> &segments);
+    bool matchesAt(const Segment &segment, const ushort *text) const;
+    int find(const Segment &segment, const ushort *text, int length, int from) const;
+    int findLast(const Segment &segment, const ushort *text, int length, int from) const;
+    void setMatch(const QString &str, int pos, int length);
+
+    QRegExp _options;
+    QVector<Segment> _segments;
+    QString _subject;
+    int _matchPos;
+    int _matchLength;
+};
+
+#endif // GLOBREGEXPENGINE_H
@@ -0,0 +1,532 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "lazydfa.h"
+#include <algorithm>
+
+// Counted repetitions are expanded, so bound what a pattern may grow to.
+#define MAX_NFA_STATES 10000
+// Characters below this get a transition table, the rest a hash.
+#define ASCII_TRANSITIONS 128
+// Rough cost of a cached state besides its key, and of a hashed transition.
+#define DFA_STATE_OVERHEAD (int(sizeof(DfaState)) + ASCII_TRANSITIONS * int(sizeof(int)) + 64)
+#define OTHER_TRANSITION_BYTES 32
+// State cache size per DFA unless setCacheLimit() says otherwise.
+#define DEFAULT_CACHE_KILOBYTES 4096
+#define MIN_CACHE_KILOBYTES 64
+
+QAtomicInt LazyDfa::_cacheLimit(DEFAULT_CACHE_KILOBYTES);
+
+Nfa::Nfa() :
+    _start(-1),
+    _caseSensitivity(Qt::CaseSensitive),
+    _reversed(false)
+{
+}
+
+bool Nfa::build(const PatternNode *root, Qt::CaseSensitivity caseSensitivity, bool reversed)
+{
+    _states.clear();
+    _errorString.clear();
+    _caseSensitivity = caseSensitivity;
+    _reversed = reversed;
+    int match = addState(State::Match);
+    _start = compile(root, match);
+    return _start >= 0;
+}
+
+QString Nfa::errorString() const
+{
+    return _errorString;
+}
+
+const QVector<Nfa::State> &Nfa::states() const
+{
+    return _states;
+}
+
+int Nfa::start() const
+{
+    return _start;
+}
+
+Qt::CaseSensitivity Nfa::caseSensitivity() const
+{
+    return _caseSensitivity;
+}
+
+/*
+ * Compiles node so that it continues with state next, and returns the
+ * node's entry state, or -1 when it can't be compiled.
+ */
+int Nfa::compile(const PatternNode *node, int next)
+{
+    switch (node->type)
+    {
+    case PatternNode::Empty:
+        return next;
+    case PatternNode::Set:
+    {
+        int state = addState(State::Char, next);
+        if (state >= 0)
+        {
+            _states[state].set = node->set;
+        }
+        return state;
+    }
+    case PatternNode::Sequence:
+        // Built back to front; a reversed sequence runs front to back.
+        for (int i = 0; next >= 0 && i < node->children.size(); ++i)
+        {
+            const PatternNode *child = node->children.at(_reversed ? i : node->children.size() - 1 - i);
+            next = compile(child, next);
+        }
+        return next;
+    case PatternNode::Alternation:
+    {
+        int entry = -1;
+        for (int i = node->children.size() - 1; i >= 0; --i)
+        {
+            int branch = compile(node->children.at(i), next);
+            if (branch < 0)
+            {
+                return -1;
+            }
+            entry = (entry < 0) ? branch : addState(State::Split, branch, entry);
+        }
+        return entry;
+    }
+    case PatternNode::Group:
+        return compile(node->children.first(), next);
+    case PatternNode::Repeat:
+    {
+        const PatternNode *body = node->children.first();
+        int entry = next;
+        if (node->max < 0)
+        {
+            int loop = addState(State::Split);
+            int bodyEntry = (loop < 0) ? -1 : compile(body, loop);
+            if (bodyEntry < 0)
+            {
+                return -1;
+            }
+            _states[loop].out = bodyEntry;
+            _states[loop].out1 = next;
+            entry = loop;
+        }
+        else
+        {
+            // x{0,2} is (x(x)?)?: each optional copy may skip to next.
+            for (int i = node->min; entry >= 0 && i < node->max; ++i)
+            {
+                int bodyEntry = compile(body, entry);
+                entry = (bodyEntry < 0) ? -1 : addState(State::Split, bodyEntry, next);
+            }
+        }
+        for (int i = 0; entry >= 0 && i < node->min; ++i)
+        {
+            entry = compile(body, entry);
+        }
+        return entry;
+    }
+    case PatternNode::LineStart:
+        return addState(_reversed ? State::EndAnchor : State::StartAnchor, next);
+    case PatternNode::LineEnd:
+        return addState(_reversed ? State::StartAnchor : State::EndAnchor, next);
+    case PatternNode::WordBoundary:
+        return addState(State::WordBoundary, next);
+    case PatternNode::NonWordBoundary:
+        return addState(State::NonWordBoundary, next);
+    case PatternNode::Lookahead:
+    case PatternNode::NegativeLookahead:
+        _errorString = tr("lookahead needs a backtracking engine");
+        return -1;
+    case PatternNode::BackReference:
+        _errorString = tr("back references need a backtracking engine");
+        return -1;
+    default:
+        return -1;
+    }
+}
+
+int Nfa::addState(Nfa::State::Kind kind, int out, int out1)
+{
+    if (_states.size() >= MAX_NFA_STATES)
+    {
+        _errorString = tr("the pattern expands to more than %1 NFA states").arg(MAX_NFA_STATES);
+        return -1;
+    }
+    State state;
+    state.kind = kind;
+    state.out = out;
+    state.out1 = out1;
+    _states.append(state);
+    return _states.size() - 1;
+}
+
+LazyDfa::Context::Context(bool atStart, bool atEnd, bool prevWord, bool nextWord) :
+    atStart(atStart),
+    atEnd(atEnd),
+    prevWord(prevWord),
+    nextWord(nextWord)
+{
+}
+
+LazyDfa::LazyDfa(const Nfa &nfa, bool minimal) :
+    _nfa(nfa),
+    _minimal(minimal),
+    _startsOnlyAtStart(false),
+    _bytes(0),
+    _flushes(0),
+    _marks(nfa.states().size(), 0),
+    _generation(0)
+{
+    // Patterns like "^abc" can't begin anywhere once the first position
+    // is behind, which lets an unanchored scan give up early.
+    QVector<int> seeds(1, _nfa.start());
+    QVector<int> out;
+    ++_generation;
+    closure(seeds, Context(false, false, false, false), false, out);
+    _startsOnlyAtStart = out.isEmpty();
+}
+
+const Nfa &LazyDfa::nfa() const
+{
+    return _nfa;
+}
+
+bool LazyDfa::isMinimal() const
+{
+    return _minimal;
+}
+
+/*
+ * State for a scan beginning here: atStart tells whether the start anchor
+ * holds, prevWord whether the character before is a word character.
+ * Anchored scans follow one start only and never settle on a match.
+ */
+int LazyDfa::startState(bool anchored, bool atStart, bool prevWord)
+{
+    QVector<int> seeds(1, _nfa.start());
+    QVector<int> out;
+    ++_generation;
+    closure(seeds, Context(atStart, false, prevWord, false), false, out);
+
+    Groups groups;
+    if (!out.isEmpty())
+    {
+        groups << out;
+    }
+    int flags = (anchored ? Anchored : 0) | (atStart ? AtStart : 0) | (prevWord ? PrevWord : 0);
+    if (groups.isEmpty() && (anchored || _startsOnlyAtStart))
+    {
+        flags |= Dead;
+    }
+    return intern(encode(flags, groups));
+}
+
+/*
+ * Steps over ch. The returned index replaces state: a flush may have
+ * invalidated every other one.
+ */
+int LazyDfa::next(int state, ushort ch)
+{
+    const DfaState &current = _states.at(state);
+    int target = (ch < ASCII_TRANSITIONS) ? current.asciiNext.at(ch) : current.otherNext.value(ch, -1);
+    if (target >= 0)
+    {
+        return target;
+    }
+
+    int flushes = _flushes;
+    target = intern(step(current.key, ch));
+    if (_flushes == flushes)
+    {
+        DfaState &source = _states[state];
+        if (ch < ASCII_TRANSITIONS)
+        {
+            source.asciiNext[ch] = target;
+        }
+        else
+        {
+            source.otherNext.insert(ch, target);
+            _bytes += OTHER_TRANSITION_BYTES;
+        }
+    }
+    return target;
+}
+
+bool LazyDfa::matchesBefore(int state) const
+{
+    return _states.at(state).flags & MatchBefore;
+}
+
+bool LazyDfa::isDead(int state) const
+{
+    return _states.at(state).flags & Dead;
+}
+
+bool LazyDfa::matchesAtEnd(int state, bool atEnd, bool nextWord)
+{
+    Groups groups;
+    int flags = decode(_states.at(state).key, groups);
+    if (flags & Dead)
+    {
+        return false;
+    }
+    resolve(groups, Context(flags & AtStart, atEnd, flags & PrevWord, nextWord));
+    foreach (const QVector<int> &group, groups)
+    {
+        if (containsMatch(group))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int LazyDfa::flushCount() const
+{
+    return _flushes;
+}
+
+int LazyDfa::cacheLimit()
+{
+    return _cacheLimit.load();
+}
+
+void LazyDfa::setCacheLimit(int kilobytes)
+{
+    _cacheLimit.store(qMax(kilobytes, MIN_CACHE_KILOBYTES));
+}
+
+QVector<int> LazyDfa::encode(int flags, const LazyDfa::Groups &groups)
+{
+    QVector<int> key;
+    key << flags;
+    foreach (const QVector<int> &group, groups)
+    {
+        key << group.size();
+        key += group;
+    }
+    return key;
+}
+
+int LazyDfa::decode(const QVector<int> &key, LazyDfa::Groups &groups)
+{
+    groups.clear();
+    for (int i = 1; i < key.size(); i += key.at(i) + 1)
+    {
+        groups << key.mid(i + 1, key.at(i));
+    }
+    return key.first();
+}
+
+/*
+ * Adds the states reachable from seeds without consuming a character to
+ * out, skipping those already reached in this generation. Pending
+ * assertions are kept as they are, or evaluated when resolving.
+ */
+void LazyDfa::closure(const QVector<int> &seeds, const LazyDfa::Context &context, bool resolve, QVector<int> &out)
+{
+    const QVector<Nfa::State> &states = _nfa.states();
+    _stack.clear();
+    for (int i = seeds.size() - 1; i >= 0; --i)
+    {
+        _stack << seeds.at(i);
+    }
+
+    while (!_stack.isEmpty())
+    {
+        int index = _stack.takeLast();
+        if (_marks.at(index) == _generation)
+        {
+            continue;
+        }
+        _marks[index] = _generation;
+
+        const Nfa::State &state = states.at(index);
+        bool holds = false;
+        switch (state.kind)
+        {
+        case Nfa::State::Char:
+        case Nfa::State::Match:
+            out << index;
+            continue;
+        case Nfa::State::Split:
+            _stack << state.out1 << state.out;
+            continue;
+        case Nfa::State::Epsilon:
+            _stack << state.out;
+            continue;
+        case Nfa::State::StartAnchor:
+            holds = context.atStart;
+            break;
+        case Nfa::State::EndAnchor:
+            holds = context.atEnd;
+            break;
+        case Nfa::State::WordBoundary:
+            holds = context.prevWord != context.nextWord;
+            break;
+        case Nfa::State::NonWordBoundary:
+            holds = context.prevWord == context.nextWord;
+            break;
+        }
+
+        if (!resolve && state.kind != Nfa::State::StartAnchor)
+        {
+            out << index;
+        }
+        else if (holds)
+        {
+            _stack << state.out;
+        }
+    }
+    std::sort(out.begin(), out.end());
+}
+
+void LazyDfa::resolve(LazyDfa::Groups &groups, const LazyDfa::Context &context)
+{
+    Groups resolved;
+    QVector<int> out;
+    ++_generation;
+    foreach (const QVector<int> &group, groups)
+    {
+        out.clear();
+        closure(group, context, true, out);
+        if (!out.isEmpty())
+        {
+            resolved << out;
+        }
+    }
+    groups = resolved;
+}
+
+/*
+ * Looks for a match ending here. The earliest start that has one wins
+ * over every later start; longest matching keeps its threads running to
+ * extend it, minimal matching is done with it.
+ */
+bool LazyDfa::settleMatches(LazyDfa::Groups &groups, int &flags) const
+{
+    if (flags & Anchored)
+    {
+        return !groups.isEmpty() && containsMatch(groups.first());
+    }
+    for (int i = 0; i < groups.size(); ++i)
+    {
+        if (containsMatch(groups.at(i)))
+        {
+            groups.resize(_minimal ? i : i + 1);
+            flags |= MatchSeen;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LazyDfa::containsMatch(const QVector<int> &group) const
+{
+    foreach (int index, group)
+    {
+        if (_nfa.states().at(index).kind == Nfa::State::Match)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+QVector<int> LazyDfa::step(const QVector<int> &key, ushort ch)
+{
+    Groups groups;
+    int flags = decode(key, groups);
+    bool nextWord = CharSet::isWordChar(ch);
+    resolve(groups, Context(flags & AtStart, false, flags & PrevWord, nextWord));
+
+    int nextFlags = flags & (Anchored | MatchSeen);
+    if (settleMatches(groups, nextFlags))
+    {
+        nextFlags |= MatchBefore;
+    }
+
+    const QVector<Nfa::State> &states = _nfa.states();
+    Context inside(false, false, false, false);
+    Groups stepped;
+    QVector<int> seeds;
+    QVector<int> out;
+    ++_generation;
+    foreach (const QVector<int> &group, groups)
+    {
+        seeds.clear();
+        foreach (int index, group)
+        {
+            const Nfa::State &state = states.at(index);
+            if (state.kind == Nfa::State::Char && state.set.contains(ch, _nfa.caseSensitivity()))
+            {
+                seeds << state.out;
+            }
+        }
+        out.clear();
+        closure(seeds, inside, false, out);
+        if (!out.isEmpty())
+        {
+            stepped << out;
+        }
+    }
+
+    // Once a match is known, later starts can't be leftmost any more.
+    if (!(nextFlags & (Anchored | MatchSeen)))
+    {
+        seeds.fill(_nfa.start(), 1);
+        out.clear();
+        closure(seeds, inside, false, out);
+        if (!out.isEmpty())
+        {
+            stepped << out;
+        }
+    }
+
+    if (nextWord)
+    {
+        nextFlags |= PrevWord;
+    }
+    if (stepped.isEmpty() && ((nextFlags & (Anchored | MatchSeen)) || _startsOnlyAtStart))
+    {
+        nextFlags |= Dead;
+    }
+    return encode(nextFlags, stepped);
+}
+
+int LazyDfa::intern(const QVector<int> &key)
+{
+    QHash<QVector<int>, int>::const_iterator it = _index.constFind(key);
+    if (it != _index.constEnd())
+    {
+        return it.value();
+    }
+
+    qint64 cost = DFA_STATE_OVERHEAD + qint64(key.size()) * sizeof(int) * 2;
+    if (!_states.isEmpty() && _bytes + cost > qint64(cacheLimit()) * 1024)
+    {
+        flush();
+    }
+
+    DfaState state;
+    state.flags = key.first();
+    state.key = key;
+    state.asciiNext.fill(-1, ASCII_TRANSITIONS);
+    _states.append(state);
+    _index.insert(key, _states.size() - 1);
+    _bytes += cost;
+    return _states.size() - 1;
+}
+
+void LazyDfa::flush()
+{
+    _states.clear();
+    _index.clear();
+    _bytes = 0;
+    ++_flushes;
+}
@@ -0,0 +1,152 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef LAZYDFA_H
+#define LAZYDFA_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include "charset.h"
+#include "patternparser.h"
+
+/*
+ * Thompson NFA of a parsed pattern, optionally reversed so it can be run
+ * from the end of a match back to its start. Captures and greediness are
+ * gone: it only knows which texts match. ^ and $ become anchors on the
+ * start and end of a scan (swapped when reversed), \b and \B assertions
+ * on the characters around the current position.
+ */
+class Nfa
+{
+    Q_DECLARE_TR_FUNCTIONS(Nfa)
+public:
+    struct State
+    {
+        enum Kind
+        {
+            Char,
+            Split,
+            Epsilon,
+            StartAnchor,
+            EndAnchor,
+            WordBoundary,
+            NonWordBoundary,
+            Match
+        };
+
+        Kind kind;
+        CharSet set;    // Char
+        int out;
+        int out1;       // Split
+    };
+
+    Nfa();
+    bool build(const PatternNode *root, Qt::CaseSensitivity caseSensitivity, bool reversed);
+    QString errorString() const;
+    const QVector<State> &states() const;
+    int start() const;
+    Qt::CaseSensitivity caseSensitivity() const;
+
+private:
+    int compile(const PatternNode *node, int next);
+    int addState(State::Kind kind, int out = -1, int out1 = -1);
+
+    QVector<State> _states;
+    int _start;
+    Qt::CaseSensitivity _caseSensitivity;
+    bool _reversed;
+    QString _errorString;
+};
+
+/*
+ * Subset construction run lazily: a DFA state is built the first time a
+ * scan reaches it and kept in a cache of limited size, which is simply
+ * flushed when it fills up. A step costs at most one pass over the NFA,
+ * so every scan is linear in the text whatever the pattern.
+ *
+ * An unanchored state is the ordered list of NFA thread sets still alive,
+ * one per start position, earliest first (a thread already alive for an
+ * earlier start is dropped from later ones). That is enough to tell where
+ * the leftmost match ends, longest or shortest as QRegExp's minimal flag
+ * asks; its start then comes from an anchored scan of the reversed NFA.
+ *
+ * \b, \B and end anchors depend on the next character, so they stay
+ * pending in a state and are resolved by the following step. Matches are
+ * therefore reported one step late: the state reached by the step over
+ * the character at p tells whether a match ends at p, matchesAtEnd()
+ * whether one ends after the last character.
+ */
+class LazyDfa
+{
+public:
+    LazyDfa(const Nfa &nfa, bool minimal);
+    const Nfa &nfa() const;
+    bool isMinimal() const;
+    int startState(bool anchored, bool atStart, bool prevWord);
+    int next(int state, ushort ch);
+    bool matchesBefore(int state) const;
+    bool isDead(int state) const;
+    bool matchesAtEnd(int state, bool atEnd, bool nextWord);
+    int flushCount() const;
+    static int cacheLimit();
+    static void setCacheLimit(int kilobytes);
+
+private:
+    enum Flag
+    {
+        Anchored = 0x01,
+        AtStart = 0x02,
+        PrevWord = 0x04,
+        MatchSeen = 0x08,
+        MatchBefore = 0x10,
+        Dead = 0x20
+    };
+
+    struct Context
+    {
+        Context(bool atStart, bool atEnd, bool prevWord, bool nextWord);
+        bool atStart;
+        bool atEnd;
+        bool prevWord;
+        bool nextWord;
+    };
+
+    struct DfaState
+    {
+        int flags;
+        QVector<int> key;
+        QVector<int> asciiNext;
+        QHash<ushort, int> otherNext;
+    };
+
+    typedef QVector<QVector<int> > Groups;
+
+    static QVector<int> encode(int flags, const Groups &groups);
+    static int decode(const QVector<int> &key, Groups &groups);
+    void closure(const QVector<int> &seeds, const Context &context, bool resolve, QVector<int> &out);
+    void resolve(Groups &groups, const Context &context);
+    bool settleMatches(Groups &groups, int &flags) const;
+    bool containsMatch(const QVector<int> &group) const;
+    QVector<int> step(const QVector<int> &key, ushort ch);
+    int intern(const QVector<int> &key);
+    void flush();
+
+    Nfa _nfa;
+    bool _minimal;
+    bool _startsOnlyAtStart;
+    QVector<DfaState> _states;
+    QHash<QVector<int>, int> _index;
+    qint64 _bytes;
+    int _flushes;
+    QVector<int> _marks;
+    int _generation;
+    QVector<int> _stack;
+    static QAtomicInt _cacheLimit;
+};
+
+#endif // LAZYDFA_H
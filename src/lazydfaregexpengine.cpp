@@ -0,0 +1,267 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "lazydfaregexpengine.h"
+#include "charset.h"
+#include "patternparser.h"
+
+LazyDfaRegExpEngine::LazyDfaRegExpEngine(const QRegExp &options) :
+    _options(options),
+    _backtracker(new LegacyRegExpEngine(options)),
+    _forward(NULL),
+    _reverse(NULL),
+    _matchPos(-1),
+    _matchLength(-1),
+    _backtrackerMatched(false)
+{
+    if (!_backtracker->isValid())
+    {
+        return;
+    }
+
+    PatternParser parser(options);
+    if (!parser.isValid())
+    {
+        _fallbackReason = parser.errorString();
+        return;
+    }
+    Nfa forward;
+    Nfa reverse;
+    if (!forward.build(parser.root(), parser.caseSensitivity(), false))
+    {
+        _fallbackReason = forward.errorString();
+        return;
+    }
+    reverse.build(parser.root(), parser.caseSensitivity(), true);
+    _forward = new LazyDfa(forward, options.isMinimal());
+    _reverse = new LazyDfa(reverse, false);
+}
+
+LazyDfaRegExpEngine::LazyDfaRegExpEngine(const LazyDfaRegExpEngine &other) :
+    RegExpEngine(),
+    _options(other._options),
+    _backtracker(new LegacyRegExpEngine(other._options)),
+    _forward(NULL),
+    _reverse(NULL),
+    _fallbackReason(other._fallbackReason),
+    _matchPos(-1),
+    _matchLength(-1),
+    _backtrackerMatched(false)
+{
+    // The NFAs are shared work; the state caches start out empty.
+    if (other._forward != NULL)
+    {
+        _forward = new LazyDfa(other._forward->nfa(), other._forward->isMinimal());
+        _reverse = new LazyDfa(other._reverse->nfa(), false);
+    }
+}
+
+LazyDfaRegExpEngine::~LazyDfaRegExpEngine()
+{
+    delete _forward;
+    delete _reverse;
+    delete _backtracker;
+}
+
+RegExpEngine::Type LazyDfaRegExpEngine::type() const
+{
+    return LinearLazyDfa;
+}
+
+QString LazyDfaRegExpEngine::name() const
+{
+    if (usesDfa() || !_backtracker->isValid())
+    {
+        return RegExpEngine::name();
+    }
+    return tr("QRegExp (Lazy DFA fallback: %1)").arg(_fallbackReason);
+}
+
+RegExpEngine *LazyDfaRegExpEngine::clone() const
+{
+    return new LazyDfaRegExpEngine(*this);
+}
+
+bool LazyDfaRegExpEngine::isValid() const
+{
+    return _backtracker->isValid();
+}
+
+QString LazyDfaRegExpEngine::errorString() const
+{
+    return _backtracker->errorString();
+}
+
+bool LazyDfaRegExpEngine::exactMatch(const QString &str)
+{
+    if (!usesDfa())
+    {
+        _backtrackerMatched = true;
+        return _backtracker->exactMatch(str);
+    }
+
+    clearMatch(str);
+    const ushort *data = str.utf16();
+    int length = str.length();
+    int state = _forward->startState(true, true, false);
+    int p = 0;
+    for (; p < length && !_forward->isDead(state); ++p)
+    {
+        state = _forward->next(state, data[p]);
+    }
+    if (_forward->isDead(state) || !_forward->matchesAtEnd(state, true, false))
+    {
+        return false;
+    }
+
+    _matchPos = 0;
+    _matchLength = length;
+    if (captureCount() > 0)
+    {
+        _backtrackerMatched = _backtracker->exactMatch(str);
+    }
+    return true;
+}
+
+/*
+ * A forward scan finds where the leftmost match ends, an anchored scan
+ * of the reversed pattern back from there where it starts.
+ */
+int LazyDfaRegExpEngine::indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode)
+{
+    if (!usesDfa())
+    {
+        _backtrackerMatched = true;
+        return _backtracker->indexIn(str, offset, caretMode);
+    }
+
+    clearMatch(str);
+    const ushort *data = str.utf16();
+    int length = str.length();
+    if (offset < 0)
+    {
+        offset += length;
+    }
+    if (offset < 0 || offset > length)
+    {
+        return -1;
+    }
+    int caretPos = -1;
+    if (caretMode == QRegExp::CaretAtZero)
+    {
+        caretPos = 0;
+    }
+    else if (caretMode == QRegExp::CaretAtOffset)
+    {
+        caretPos = offset;
+    }
+    bool wordBefore = offset > 0 && CharSet::isWordChar(data[offset - 1]);
+
+    int end = -1;
+    int state = _forward->startState(false, offset == caretPos, wordBefore);
+    int p = offset;
+    for (; p < length && !_forward->isDead(state); ++p)
+    {
+        state = _forward->next(state, data[p]);
+        if (_forward->matchesBefore(state))
+        {
+            end = p;
+        }
+    }
+    if (p == length && !_forward->isDead(state) && _forward->matchesAtEnd(state, true, false))
+    {
+        end = length;
+    }
+    if (end < 0)
+    {
+        return -1;
+    }
+
+    int start = -1;
+    state = _reverse->startState(true, end == length, end < length && CharSet::isWordChar(data[end]));
+    int q = end;
+    for (; q > offset && !_reverse->isDead(state); --q)
+    {
+        state = _reverse->next(state, data[q - 1]);
+        if (_reverse->matchesBefore(state))
+        {
+            start = q;
+        }
+    }
+    if (q == offset && !_reverse->isDead(state) && _reverse->matchesAtEnd(state, offset == caretPos, wordBefore))
+    {
+        start = offset;
+    }
+    if (start < 0)
+    {
+        // Both scans run the same NFA, so this can't happen; stay correct anyway.
+        _backtrackerMatched = true;
+        return _backtracker->indexIn(str, offset, caretMode);
+    }
+
+    _matchPos = start;
+    _matchLength = end - start;
+    if (captureCount() > 0)
+    {
+        // '^' can't hold at a later start, so only pass CaretAtOffset on
+        // when the match starts at the offset itself.
+        QRegExp::CaretMode mode = caretMode;
+        if (caretMode == QRegExp::CaretAtOffset && start != offset)
+        {
+            mode = QRegExp::CaretWontMatch;
+        }
+        _backtrackerMatched = (_backtracker->indexIn(str, start, mode) == start);
+    }
+    return start;
+}
+
+int LazyDfaRegExpEngine::captureCount() const
+{
+    return _backtracker->captureCount();
+}
+
+int LazyDfaRegExpEngine::pos(int nth) const
+{
+    if (_backtrackerMatched)
+    {
+        return _backtracker->pos(nth);
+    }
+    return nth == 0 ? _matchPos : -1;
+}
+
+int LazyDfaRegExpEngine::capturedLength(int nth) const
+{
+    if (_backtrackerMatched)
+    {
+        return _backtracker->capturedLength(nth);
+    }
+    return nth == 0 ? _matchLength : 0;
+}
+
+QString LazyDfaRegExpEngine::cap(int nth) const
+{
+    if (_backtrackerMatched)
+    {
+        return _backtracker->cap(nth);
+    }
+    return (nth == 0 && _matchPos >= 0) ? _subject.mid(_matchPos, _matchLength) : QString();
+}
+
+bool LazyDfaRegExpEngine::usesDfa() const
+{
+    return _forward != NULL;
+}
+
+QString LazyDfaRegExpEngine::fallbackReason() const
+{
+    return _fallbackReason;
+}
+
+void LazyDfaRegExpEngine::clearMatch(const QString &str)
+{
+    _subject = str;
+    _matchPos = -1;
+    _matchLength = -1;
+    _backtrackerMatched = false;
+}
@@ -0,0 +1,58 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef LAZYDFAREGEXPENGINE_H
+#define LAZYDFAREGEXPENGINE_H
+
+#include <QCoreApplication>
+#include "lazydfa.h"
+#include "legacyregexpengine.h"
+#include "regexpengine.h"
+
+/*
+ * Linear-time backend: a lazy DFA compiled from PatternParser's tree finds
+ * QRegExp's match (leftmost-longest, or leftmost-shortest when minimal)
+ * without backtracking, so no pattern can blow up on a long testee. The
+ * DFA can't tell where groups matched; when the pattern has captures,
+ * QRegExp fills them in with a single attempt at the start the DFA found.
+ *
+ * Back references and lookahead need a backtracker, so such patterns run
+ * on QRegExp altogether, and name() says so.
+ */
+class LazyDfaRegExpEngine : public RegExpEngine
+{
+    Q_DECLARE_TR_FUNCTIONS(LazyDfaRegExpEngine)
+public:
+    explicit LazyDfaRegExpEngine(const QRegExp &options);
+    ~LazyDfaRegExpEngine();
+    Type type() const;
+    QString name() const;
+    RegExpEngine *clone() const;
+    bool isValid() const;
+    QString errorString() const;
+    bool exactMatch(const QString &str);
+    int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode);
+    int captureCount() const;
+    int pos(int nth) const;
+    int capturedLength(int nth) const;
+    QString cap(int nth) const;
+    bool usesDfa() const;
+    QString fallbackReason() const;
+
+private:
+    LazyDfaRegExpEngine(const LazyDfaRegExpEngine &other);
+    void clearMatch(const QString &str);
+
+    QRegExp _options;
+    LegacyRegExpEngine *_backtracker;
+    LazyDfa *_forward;
+    LazyDfa *_reverse;
+    QString _fallbackReason;
+    QString _subject;
+    int _matchPos;
+    int _matchLength;
+    bool _backtrackerMatched;
+};
+
+#endif // LAZYDFAREGEXPENGINE_H
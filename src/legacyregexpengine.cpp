@@ -0,0 +1,71 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "legacyregexpengine.h"
+
+LegacyRegExpEngine::LegacyRegExpEngine(const QRegExp &options) :
+    _regexp(options)
+{
+}
+
+RegExpEngine::Type LegacyRegExpEngine::type() const
+{
+    return LegacyQRegExp;
+}
+
+RegExpEngine *LegacyRegExpEngine::clone() const
+{
+    return new LegacyRegExpEngine(_regexp);
+}
+
+bool LegacyRegExpEngine::isValid() const
+{
+    return _regexp.isValid();
+}
+
+QString LegacyRegExpEngine::errorString() const
+{
+    return _regexp.errorString();
+}
+
+bool LegacyRegExpEngine::exactMatch(const QString &str)
+{
+    return _regexp.exactMatch(str);
+}
+
+int LegacyRegExpEngine::indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode)
+{
+    return _regexp.indexIn(str, offset, caretMode);
+}
+
+int LegacyRegExpEngine::captureCount() const
+{
+    return _regexp.captureCount();
+}
+
+int LegacyRegExpEngine::pos(int nth) const
+{
+    return _regexp.pos(nth);
+}
+
+int LegacyRegExpEngine::capturedLength(int nth) const
+{
+    // Groups have no length accessor, see the class comment.
+    return nth == 0 ? _regexp.matchedLength() : _regexp.cap(nth).length();
+}
+
+QString LegacyRegExpEngine::cap(int nth) const
+{
+    return _regexp.cap(nth);
+}
+
+QStringList LegacyRegExpEngine::capturedTexts() const
+{
+    return _regexp.capturedTexts();
+}
+
+int LegacyRegExpEngine::matchedLength() const
+{
+    return _regexp.matchedLength();
+}
@@ -0,0 +1,37 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef LEGACYREGEXPENGINE_H
+#define LEGACYREGEXPENGINE_H
+
+#include "regexpengine.h"
+
+/*
+ * The original backend: Qt's own backtracking QRegExp. It understands
+ * every pattern syntax natively. QRegExp tells where a capture starts but
+ * not where it ends, so capturedLength() of a capture group copies its
+ * text; only the whole match's length comes without a copy.
+ */
+class LegacyRegExpEngine : public RegExpEngine
+{
+public:
+    explicit LegacyRegExpEngine(const QRegExp &options);
+    Type type() const;
+    RegExpEngine *clone() const;
+    bool isValid() const;
+    QString errorString() const;
+    bool exactMatch(const QString &str);
+    int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode);
+    int captureCount() const;
+    int pos(int nth) const;
+    int capturedLength(int nth) const;
+    QString cap(int nth) const;
+    QStringList capturedTexts() const;
+    int matchedLength() const;
+
+private:
+    QRegExp _regexp;
+};
+
+#endif // LEGACYREGEXPENGINE_H
@@ -3,10 +3,26 @@
  * file 'LICENSE.txt', which is part of this source code package.
  */
 #include "mainwindow.h"
+#include "batchrunner.h"
+#include "corpusrunner.h"
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    if (BatchRunner::isBatchMode(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        BatchRunner runner;
+        return runner.run(a.arguments());
+    }
+    if (CorpusRunner::isCorpusMode(argc, argv))
+    {
+        QCoreApplication a(argc, argv);
+        CorpusRunner runner;
+        return runner.run(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
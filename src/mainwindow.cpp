@@ -6,9 +6,12 @@
 #include <QFileDialog>
 #include <QDebug>
 #include <QMessageBox>
+#include <QInputDialog>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "regextesterwindow.h"
+#include "enginecache.h"
+#include "spanarena.h"
 
 #define APP_TITLE "QRegExpTester"
 #define APP_VERSION "0.9a"
@@ -19,9 +22,17 @@ const QString MainWindow::aboutInfo(APP_TITLE " " APP_VERSION " (" APP_DATE ")\n
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    _engineCacheLabel(new QLabel(this)),
+    _resultMemoryLabel(new QLabel(this))
 {
     ui->setupUi(this);
+    statusBar()->addPermanentWidget(_resultMemoryLabel);
+    statusBar()->addPermanentWidget(_engineCacheLabel);
+    onResultMemoryChanged();
+    EngineCache *cache = EngineCache::instance();
+    connect(cache, SIGNAL(statisticsChanged(int,int,int)), this, SLOT(onEngineCacheStatisticsChanged(int,int,int)));
+    onEngineCacheStatisticsChanged(cache->hits(), cache->misses(), cache->count());
     ui->actionNewTester->trigger();
 }
 
@@ -41,20 +52,29 @@ RegexTesterWindow *MainWindow::getActiveTesterWindow()
     return qobject_cast<RegexTesterWindow *>(subWindow->widget());
 }
 
-void MainWindow::on_actionNewTester_triggered()
+PatternSetWindow *MainWindow::getActivePatternSetWindow()
 {
-    RegexTesterWindow *subWindow = new RegexTesterWindow(this);
-    subWindow->setAttribute(Qt::WA_DeleteOnClose);
-    ui->mdiArea->addSubWindow(subWindow);    
-    if (ui->mdiArea->subWindowList().count() == 1)
-    {
-        subWindow->showMaximized();
-    }
-    else
+    QMdiSubWindow *subWindow = ui->mdiArea->activeSubWindow();
+    if (subWindow == NULL)
     {
-        subWindow->show();
+        return NULL;
     }
-    subWindow->activateWindow();
+
+    return qobject_cast<PatternSetWindow *>(subWindow->widget());
+}
+
+void MainWindow::on_actionNewTester_triggered()
+{
+    RegexTesterWindow *window = new RegexTesterWindow(this);
+    connect(window, SIGNAL(resultMemoryChanged()), this, SLOT(onResultMemoryChanged()));
+    // The results are freed after destroyed() is emitted, so update later.
+    connect(window, SIGNAL(destroyed()), this, SLOT(onResultMemoryChanged()), Qt::QueuedConnection);
+    showSubWindow(window);
+}
+
+void MainWindow::on_actionNewPatternSet_triggered()
+{
+    showSubWindow(new PatternSetWindow(this));
 }
 
 void MainWindow::on_actionExit_triggered()
@@ -70,6 +90,13 @@ void MainWindow::on_actionClear_triggered()
         return;
     }
 
+    PatternSetWindow *patternSetWindow = getActivePatternSetWindow();
+    if (patternSetWindow != NULL)
+    {
+        patternSetWindow->clear();
+        return;
+    }
+
     RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
     if (regexpTesterWindow == NULL)
     {
@@ -80,6 +107,13 @@ void MainWindow::on_actionClear_triggered()
 
 void MainWindow::on_actionRun_triggered()
 {
+    PatternSetWindow *patternSetWindow = getActivePatternSetWindow();
+    if (patternSetWindow != NULL)
+    {
+        patternSetWindow->run();
+        return;
+    }
+
     RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
     if (regexpTesterWindow == NULL)
     {
@@ -91,7 +125,8 @@ void MainWindow::on_actionRun_triggered()
 void MainWindow::on_action_Import_Testee_triggered()
 {
     RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
-    if (regexpTesterWindow == NULL)
+    PatternSetWindow *patternSetWindow = getActivePatternSetWindow();
+    if (regexpTesterWindow == NULL && patternSetWindow == NULL)
     {
         return;
     }
@@ -101,11 +136,36 @@ void MainWindow::on_action_Import_Testee_triggered()
     {
         return;
     }
+    if (patternSetWindow != NULL)
+    {
+        patternSetWindow->loadTesteeFromFile(testeeFilename);
+        return;
+    }
     regexpTesterWindow->loadTesteeFromFile(testeeFilename);
 }
 
 void MainWindow::on_actionSave_triggered()
 {
+    PatternSetWindow *patternSetWindow = getActivePatternSetWindow();
+    if (patternSetWindow != NULL)
+    {
+        if (patternSetWindow->isPatternEmpty())
+        {
+            QMessageBox::warning(this, "Empty Pattern", "Pattern can't be empty.");
+            return;
+        }
+
+        QString filename = QFileDialog::getSaveFileName(this, tr("Save to file"), patternSetWindow->getFilename(), tr("Pattern File (*.qregexp);;All files (*.*)"));
+        if (filename.isEmpty())
+        {
+            return;
+        }
+
+        statusBar()->showMessage(patternSetWindow->saveToFile(filename) ?
+                                     tr("Save file successfully.") : tr("Save file failed."));
+        return;
+    }
+
     RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
     if (regexpTesterWindow == NULL)
     {
@@ -136,11 +196,33 @@ void MainWindow::on_actionSave_triggered()
 
 void MainWindow::on_actionLoad_triggered()
 {
-    QString filename = QFileDialog::getOpenFileName(this, tr("Load from file"), QString(), tr("Pattern File (*.qregexp);;All files (*.*)"));
+    QString filename = QFileDialog::getOpenFileName(this, tr("Load from file"), QString(), tr("Pattern File (*.qregexp *.qregexpc);;All files (*.*)"));
     if (filename.isEmpty())
     {
         return;
     }
+
+    // Files with several [Pattern] sections open as a pattern set.
+    if (PatternSet::sectionCount(filename) > 1)
+    {
+        ui->actionNewPatternSet->trigger();
+        PatternSetWindow *patternSetWindow = getActivePatternSetWindow();
+        if (patternSetWindow == NULL)
+        {
+            return;
+        }
+
+        if (!patternSetWindow->loadFromFile(filename))
+        {
+            statusBar()->showMessage(QString("Pattern loadded fail! ") + patternSetWindow->getFileError());
+        }
+        else
+        {
+            statusBar()->showMessage("Pattern loadded successfully!");
+        }
+        return;
+    }
+
     ui->actionNewTester->trigger();
     RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
     if (regexpTesterWindow == NULL)
@@ -158,8 +240,101 @@ void MainWindow::on_actionLoad_triggered()
     }
 }
 
+void MainWindow::on_actionExportMatches_triggered()
+{
+    RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
+    if (regexpTesterWindow == NULL)
+    {
+        return;
+    }
+
+    // In the order of MatchExporter::Format.
+    QStringList filters;
+    filters << tr("CSV File (*.csv)") << tr("JSON Lines File (*.jsonl)") << tr("Binary Span File (*.qrxm)");
+    QString filter;
+    QString filename = QFileDialog::getSaveFileName(this, tr("Export Matches"), QString(), filters.join(";;"), &filter);
+    if (filename.isEmpty())
+    {
+        return;
+    }
+    int format = qMax(filters.indexOf(filter), 0);
+    regexpTesterWindow->exportMatches(filename, MatchExporter::Format(format));
+}
+
+void MainWindow::on_actionSearchFiles_triggered()
+{
+    RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
+    if (regexpTesterWindow == NULL)
+    {
+        return;
+    }
+
+    QString root = QFileDialog::getExistingDirectory(this, tr("Search Files In"));
+    if (root.isEmpty())
+    {
+        return;
+    }
+    bool ok = false;
+    QString globs = QInputDialog::getText(this, tr("Search Files"),
+                                          tr("File name globs, \"!\" in front excludes (e.g. *.log !*.gz):"),
+                                          QLineEdit::Normal, "*", &ok);
+    if (!ok)
+    {
+        return;
+    }
+    regexpTesterWindow->searchFiles(root, globs.split(QRegExp("\\s+"), QString::SkipEmptyParts));
+}
+
+/*
+ * Compares the active tester window's pattern (A) with the one of another
+ * tester window (B), on the active window's testee.
+ */
+void MainWindow::on_actionCompare_triggered()
+{
+    RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
+    if (regexpTesterWindow == NULL)
+    {
+        return;
+    }
+
+    QList<RegexTesterWindow *> others;
+    QStringList titles;
+    foreach (QMdiSubWindow *subWindow, ui->mdiArea->subWindowList())
+    {
+        RegexTesterWindow *other = qobject_cast<RegexTesterWindow *>(subWindow->widget());
+        if (other != NULL && other != regexpTesterWindow)
+        {
+            others << other;
+            // Numbered, as several windows may be "Untitled".
+            titles << QString("%1: %2").arg(others.size()).arg(other->windowTitle());
+        }
+    }
+    if (others.isEmpty())
+    {
+        QMessageBox::warning(this, tr("Compare Patterns"), tr("Open the other pattern in a second tester window first."));
+        return;
+    }
+
+    bool ok = false;
+    QString title = QInputDialog::getItem(this, tr("Compare Patterns"),
+                                          tr("Compare this window's pattern (A) with the pattern of (B):"),
+                                          titles, 0, false, &ok);
+    if (!ok)
+    {
+        return;
+    }
+    regexpTesterWindow->compareWith(others.at(qMax(titles.indexOf(title), 0)));
+}
+
 void MainWindow::on_actionClearTestee_triggered()
 {
+    PatternSetWindow *patternSetWindow = getActivePatternSetWindow();
+    if (patternSetWindow != NULL)
+    {
+        patternSetWindow->clearTestee();
+        return;
+    }
+
     RegexTesterWindow *regexpTesterWindow = getActiveTesterWindow();
     if (regexpTesterWindow == NULL)
     {
@@ -187,3 +362,33 @@ void MainWindow::on_actionHelp_triggered()
 {
     QMessageBox::warning(this, "Help", "Not implement yet!");
 }
+
+void MainWindow::onEngineCacheStatisticsChanged(int hits, int misses, int count)
+{
+    _engineCacheLabel->setText(QString(tr("Pattern cache: %1 hits, %2 misses, %3/%4 compiled"))
+                               .arg(hits)
+                               .arg(misses)
+                               .arg(count)
+                               .arg(EngineCache::instance()->capacity()));
+}
+
+void MainWindow::onResultMemoryChanged()
+{
+    _resultMemoryLabel->setText(QString(tr("Results: %1 MB"))
+                                .arg(double(SpanArena::totalBytes()) / (1024 * 1024), 0, 'f', 1));
+}
+
+void MainWindow::showSubWindow(QWidget *widget)
+{
+    widget->setAttribute(Qt::WA_DeleteOnClose);
+    ui->mdiArea->addSubWindow(widget);
+    if (ui->mdiArea->subWindowList().count() == 1)
+    {
+        widget->showMaximized();
+    }
+    else
+    {
+        widget->show();
+    }
+    widget->activateWindow();
+}
@@ -6,7 +6,9 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QLabel>
 #include "regextesterwindow.h"
+#include "patternsetwindow.h"
 
 namespace Ui {
 class MainWindow;
@@ -20,9 +22,11 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
     RegexTesterWindow *getActiveTesterWindow();
+    PatternSetWindow *getActivePatternSetWindow();
 
 private slots:
     void on_actionNewTester_triggered();
+    void on_actionNewPatternSet_triggered();
     void on_actionExit_triggered();
     void on_actionClear_triggered();
     void on_actionRun_triggered();
@@ -33,6 +37,12 @@ private slots:
 
     void on_actionLoad_triggered();
 
+    void on_actionExportMatches_triggered();
+
+    void on_actionSearchFiles_triggered();
+
+    void on_actionCompare_triggered();
+
     void on_actionClearTestee_triggered();
 
     void on_actionGeneratePatternForCoding_triggered();
@@ -41,8 +51,15 @@ private slots:
 
     void on_actionHelp_triggered();
 
+    void onEngineCacheStatisticsChanged(int hits, int misses, int count);
+    void onResultMemoryChanged();
+
 private:
+    void showSubWindow(QWidget *widget);
+
     Ui::MainWindow *ui;
+    QLabel *_engineCacheLabel;
+    QLabel *_resultMemoryLabel;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,158 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "mappedtestee.h"
+
+#define IS_UTF8_CONTINUATION(_byte_) ((uchar(_byte_) & 0xC0) == 0x80)
+
+MappedTestee::MappedTestee() :
+    _data(NULL),
+    _size(0)
+{
+}
+
+MappedTestee::~MappedTestee()
+{
+    close();
+}
+
+bool MappedTestee::open(const QString &filename)
+{
+    close();
+    _error.clear();
+
+    _file.setFileName(filename);
+    if (!_file.open(QIODevice::ReadOnly))
+    {
+        _error = _file.errorString();
+        return false;
+    }
+
+    _size = _file.size();
+    if (_size == 0)
+    {
+        _data = "";
+        return true;
+    }
+
+    uchar *mapped = _file.map(0, _size);
+    if (mapped == NULL)
+    {
+        _error = _file.errorString();
+        _file.close();
+        _size = 0;
+        return false;
+    }
+    _data = reinterpret_cast<const char *>(mapped);
+    return true;
+}
+
+void MappedTestee::close()
+{
+    if (_file.isOpen())
+    {
+        if (_size > 0)
+        {
+            _file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(_data)));
+        }
+        _file.close();
+    }
+    _data = NULL;
+    _size = 0;
+}
+
+bool MappedTestee::isOpen() const
+{
+    return _data != NULL;
+}
+
+QString MappedTestee::getFilename() const
+{
+    return _file.fileName();
+}
+
+QString MappedTestee::getError() const
+{
+    return _error;
+}
+
+qint64 MappedTestee::size() const
+{
+    return _size;
+}
+
+const char *MappedTestee::data() const
+{
+    return _data;
+}
+
+qint64 MappedTestee::alignToChar(qint64 offset) const
+{
+    return alignToChar(_data, _size, offset);
+}
+
+qint64 MappedTestee::alignToChar(const char *data, qint64 size, qint64 offset)
+{
+    // Step back over continuation bytes so a range never splits a character.
+    offset = qBound(qint64(0), offset, size);
+    qint64 limit = qMax(qint64(0), offset - 3);
+    while (offset < size && offset > limit && IS_UTF8_CONTINUATION(data[offset]))
+    {
+        offset --;
+    }
+    return offset;
+}
+
+QString MappedTestee::text(qint64 offset, qint64 length) const
+{
+    if (_data == NULL || offset < 0 || offset >= _size)
+    {
+        return QString();
+    }
+    length = qMin(length, _size - offset);
+    return QString::fromUtf8(_data + offset, int(length));
+}
+
+int MappedTestee::utf8Length(const QChar *chars, int count)
+{
+    int length = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        ushort unit = chars[i].unicode();
+        if (unit < 0x80)
+        {
+            length += 1;
+        }
+        else if (unit < 0x800)
+        {
+            length += 2;
+        }
+        else if (QChar::isHighSurrogate(unit) && i + 1 < count && QChar::isLowSurrogate(chars[i + 1].unicode()))
+        {
+            length += 4;
+            ++i;
+        }
+        else
+        {
+            length += 3;
+        }
+    }
+    return length;
+}
+
+int MappedTestee::utf16Length(const char *bytes, qint64 count)
+{
+    int length = 0;
+    for (qint64 i = 0; i < count; ++i)
+    {
+        uchar byte = uchar(bytes[i]);
+        if (IS_UTF8_CONTINUATION(byte))
+        {
+            continue;
+        }
+        // Four-byte sequences decode to a surrogate pair.
+        length += (byte >= 0xF0) ? 2 : 1;
+    }
+    return length;
+}
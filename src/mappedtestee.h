@@ -0,0 +1,47 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef MAPPEDTESTEE_H
+#define MAPPEDTESTEE_H
+
+#include <QtGlobal>
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+
+/*
+ * A UTF-8 testee file mapped into memory. Nothing is decoded up front;
+ * callers decode the byte ranges they need, and matches on a mapped
+ * testee are addressed by byte offset instead of QString index.
+ */
+class MappedTestee
+{
+public:
+    MappedTestee();
+    ~MappedTestee();
+    bool open(const QString &filename);
+    void close();
+    bool isOpen() const;
+    QString getFilename() const;
+    QString getError() const;
+    qint64 size() const;
+    const char *data() const;
+    qint64 alignToChar(qint64 offset) const;
+    QString text(qint64 offset, qint64 length) const;
+    static qint64 alignToChar(const char *data, qint64 size, qint64 offset);
+    static int utf8Length(const QChar *chars, int count);
+    static int utf16Length(const char *bytes, qint64 count);
+
+private:
+    Q_DISABLE_COPY(MappedTestee)
+
+    QFile _file;
+    const char *_data;
+    qint64 _size;
+    QString _error;
+};
+
+typedef QSharedPointer<MappedTestee> MappedTesteePtr;
+
+#endif // MAPPEDTESTEE_H
@@ -0,0 +1,140 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+#include "matchdensitymap.h"
+
+#define MATCH_DENSITY_BUCKETS 512
+#define MATCH_DENSITY_WIDTH 18
+
+MatchDensityMap::MatchDensityMap(QWidget *parent) :
+    QWidget(parent),
+    _counts(MATCH_DENSITY_BUCKETS, 0),
+    _maxCount(0),
+    _total(0),
+    _scanned(0)
+{
+    setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
+    setCursor(Qt::PointingHandCursor);
+}
+
+void MatchDensityMap::reset(qint64 total)
+{
+    _counts.fill(0);
+    _maxCount = 0;
+    _total = qMax(total, qint64(0));
+    _scanned = 0;
+    update();
+}
+
+/*
+ * Counts each match of a flat (pos, length) span vector in the bucket
+ * its start falls into.
+ */
+void MatchDensityMap::addMatches(const QVector<qint64> &spans, int stride)
+{
+    if (_total <= 0 || stride <= 0)
+    {
+        return;
+    }
+    for (int i = 0; i + stride <= spans.size(); i += stride)
+    {
+        qint64 pos = qBound(qint64(0), spans.at(i), _total - 1);
+        int &count = _counts[int(pos * MATCH_DENSITY_BUCKETS / _total)];
+        count ++;
+        _maxCount = qMax(_maxCount, count);
+    }
+    update();
+}
+
+void MatchDensityMap::setScanned(qint64 scanned)
+{
+    _scanned = qBound(qint64(0), scanned, _total);
+    update();
+}
+
+QSize MatchDensityMap::sizeHint() const
+{
+    return QSize(MATCH_DENSITY_WIDTH, 0);
+}
+
+bool MatchDensityMap::event(QEvent *event)
+{
+    if (event->type() != QEvent::ToolTip || _total <= 0)
+    {
+        return QWidget::event(event);
+    }
+    QHelpEvent *help = static_cast<QHelpEvent *>(event);
+    int bucket = bucketAt(help->pos().y());
+    QToolTip::showText(help->globalPos(), QString(tr("%1 - %2: %3 match(es)"))
+                       .arg(bucketStart(bucket))
+                       .arg(bucketStart(bucket + 1))
+                       .arg(_counts.at(bucket)), this);
+    return true;
+}
+
+/*
+ * Every bucket is a band whose bar grows with its share of the busiest
+ * bucket; several buckets share a pixel row when the strip is short.
+ */
+void MatchDensityMap::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    if (_total <= 0)
+    {
+        return;
+    }
+
+    int scannedY = int(_scanned * height() / _total);
+    painter.fillRect(0, scannedY, width(), height() - scannedY, palette().window());
+    if (_maxCount == 0)
+    {
+        return;
+    }
+
+    QColor color(palette().highlight().color());
+    for (int y = 0; y < height(); ++y)
+    {
+        int first = y * MATCH_DENSITY_BUCKETS / height();
+        int last = qMax(first, (y + 1) * MATCH_DENSITY_BUCKETS / height() - 1);
+        int count = 0;
+        for (int bucket = first; bucket <= last; ++bucket)
+        {
+            count = qMax(count, _counts.at(bucket));
+        }
+        if (count > 0)
+        {
+            // Any match at all stays visible as at least one pixel.
+            int barWidth = qMax(1, int(qint64(count) * width() / _maxCount));
+            painter.fillRect(width() - barWidth, y, barWidth, 1, color);
+        }
+    }
+}
+
+void MatchDensityMap::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || _total <= 0)
+    {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+    int bucket = bucketAt(event->pos().y());
+    emit bucketClicked(bucketStart(bucket), bucketStart(bucket + 1));
+}
+
+int MatchDensityMap::bucketAt(int y) const
+{
+    int bucket = height() > 0 ? int(qint64(y) * MATCH_DENSITY_BUCKETS / height()) : 0;
+    return qBound(0, bucket, MATCH_DENSITY_BUCKETS - 1);
+}
+
+qint64 MatchDensityMap::bucketStart(int bucket) const
+{
+    return qint64(bucket) * _total / MATCH_DENSITY_BUCKETS;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef MATCHDENSITYMAP_H
+#define MATCHDENSITYMAP_H
+
+#include <QWidget>
+#include <QVector>
+
+/*
+ * A narrow strip beside the testee showing where in it the matches are.
+ * The testee is split into a fixed number of buckets that only count the
+ * matches starting in them, so the map takes the same memory for any
+ * file size and is filled as the spans come in, while the scan runs. The
+ * part not scanned yet is shaded.
+ *
+ * Positions are those of the spans: characters of the testee, or bytes of
+ * a mapped file. Clicking a bucket emits the range it covers.
+ */
+class MatchDensityMap : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit MatchDensityMap(QWidget *parent = 0);
+    void reset(qint64 total);
+    void addMatches(const QVector<qint64> &spans, int stride);
+    void setScanned(qint64 scanned);
+    QSize sizeHint() const;
+
+signals:
+    void bucketClicked(qint64 from, qint64 to);
+
+protected:
+    bool event(QEvent *event);
+    void paintEvent(QPaintEvent *event);
+    void mousePressEvent(QMouseEvent *event);
+
+private:
+    int bucketAt(int y) const;
+    qint64 bucketStart(int bucket) const;
+
+    QVector<int> _counts;
+    int _maxCount;
+    qint64 _total;
+    qint64 _scanned;
+};
+
+#endif // MATCHDENSITYMAP_H
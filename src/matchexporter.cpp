@@ -0,0 +1,323 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QtEndian>
+#include <QMutexLocker>
+#include "matchexporter.h"
+
+// The buffer is written out once it holds this much.
+#define WRITE_BUFFER_BYTES (4 * 1024 * 1024)
+// enqueue() blocks while this many span values wait for the I/O thread.
+#define MAX_QUEUED_VALUES (4 * 1024 * 1024)
+#define BINARY_MAGIC "QRXM"
+#define BINARY_VERSION 1
+#define BINARY_FLAG_BYTE_OFFSETS 1
+
+MatchExporter::MatchExporter(const QString &filename, MatchExporter::Format format, QObject *parent) :
+    QThread(parent),
+    _file(filename),
+    _format(format),
+    _captureCount(0),
+    _matches(0),
+    _started(false),
+    _queuedValues(0),
+    _finishing(false)
+{
+}
+
+MatchExporter::~MatchExporter()
+{
+    finish();
+    wait();
+    if (!_started && _file.isOpen())
+    {
+        // Nothing was ever exported, don't leave an empty file behind.
+        _file.remove();
+    }
+}
+
+bool MatchExporter::open()
+{
+    if (!_file.open(QFile::WriteOnly | QFile::Truncate))
+    {
+        _error = _file.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString MatchExporter::getFilename() const
+{
+    return _file.fileName();
+}
+
+QString MatchExporter::getError() const
+{
+    QMutexLocker locker(&_mutex);
+    return _error;
+}
+
+void MatchExporter::setTestee(const QString &testee)
+{
+    _testee = testee;
+    _mappedTestee.clear();
+}
+
+void MatchExporter::setMappedTestee(const MappedTesteePtr &testee)
+{
+    _testee.clear();
+    _mappedTestee = testee;
+}
+
+void MatchExporter::setCaptureCount(int captureCount)
+{
+    _captureCount = qMax(captureCount, 0);
+}
+
+/*
+ * Called from the match worker. Once writing has failed the spans are
+ * dropped, so the worker never waits on a dead file.
+ */
+void MatchExporter::enqueue(const QVector<qint64> &spans)
+{
+    QMutexLocker locker(&_mutex);
+    while (_queuedValues >= MAX_QUEUED_VALUES && _error.isEmpty())
+    {
+        _queueNotFull.wait(&_mutex);
+    }
+    if (!_error.isEmpty() || _finishing)
+    {
+        return;
+    }
+    _queue.enqueue(spans);
+    _queuedValues += spans.size();
+    _queueNotEmpty.wakeOne();
+}
+
+/*
+ * No more spans will come; the I/O thread writes what is queued, closes
+ * the file and emits exportFinished().
+ */
+void MatchExporter::finish()
+{
+    QMutexLocker locker(&_mutex);
+    _finishing = true;
+    _queueNotEmpty.wakeOne();
+}
+
+void MatchExporter::run()
+{
+    _started = true;
+    _buffer.reserve(WRITE_BUFFER_BYTES + 64 * 1024);
+    writeHeader();
+
+    int stride = 2 * (_captureCount + 1);
+    forever
+    {
+        QVector<qint64> spans;
+        {
+            QMutexLocker locker(&_mutex);
+            while (_queue.isEmpty() && !_finishing)
+            {
+                _queueNotEmpty.wait(&_mutex);
+            }
+            if (_queue.isEmpty())
+            {
+                break;
+            }
+            spans = _queue.dequeue();
+            _queuedValues -= spans.size();
+            _queueNotFull.wakeAll();
+        }
+
+        for (int i = 0; i + stride <= spans.size(); i += stride)
+        {
+            writeMatch(spans.constData() + i);
+            if (_buffer.size() >= WRITE_BUFFER_BYTES)
+            {
+                flushBuffer();
+            }
+        }
+    }
+    flushBuffer();
+    _file.close();
+    emit exportFinished(_matches, getError());
+}
+
+void MatchExporter::writeHeader()
+{
+    if (_format == Binary)
+    {
+        _buffer.append(BINARY_MAGIC);
+        appendBinary(BINARY_VERSION, 4);
+        appendBinary(_captureCount, 4);
+        appendBinary(_mappedTestee.isNull() ? 0 : BINARY_FLAG_BYTE_OFFSETS, 4);
+    }
+    else if (_format == Csv)
+    {
+        _buffer.append("pos,length");
+        for (int i = 0; i <= _captureCount; ++i)
+        {
+            _buffer.append(",cap");
+            appendNumber(i);
+        }
+        _buffer.append("\r\n");
+    }
+}
+
+void MatchExporter::writeMatch(const qint64 *spans)
+{
+    _matches ++;
+    if (_format == Binary)
+    {
+        for (int i = 0; i < 2 * (_captureCount + 1); ++i)
+        {
+            appendBinary(spans[i], 8);
+        }
+        return;
+    }
+
+    bool csv = (_format == Csv);
+    _buffer.append(csv ? "" : "{\"pos\":");
+    appendNumber(spans[0]);
+    _buffer.append(csv ? "," : ",\"length\":");
+    appendNumber(spans[1]);
+    _buffer.append(csv ? "" : ",\"captures\":[");
+    for (int i = 0; i <= _captureCount; ++i)
+    {
+        _buffer.append(csv || i > 0 ? ",\"" : "\"");
+        appendText(spans[i * 2], spans[i * 2 + 1]);
+        _buffer.append('"');
+    }
+    _buffer.append(csv ? "\r\n" : "]}\n");
+}
+
+/*
+ * Appends a span of the testee as quoted UTF-8, escaped for the format.
+ */
+void MatchExporter::appendText(qint64 pos, qint64 length)
+{
+    if (pos < 0)
+    {
+        return;
+    }
+    if (!_mappedTestee.isNull())
+    {
+        // Already UTF-8; only the ASCII characters may need escaping.
+        const char *bytes = _mappedTestee->data() + pos;
+        for (qint64 i = 0; i < length; ++i)
+        {
+            uchar byte = uchar(bytes[i]);
+            if (byte < 0x80)
+            {
+                appendChar(byte);
+            }
+            else
+            {
+                _buffer.append(char(byte));
+            }
+        }
+        return;
+    }
+
+    const ushort *text = _testee.utf16() + pos;
+    for (qint64 i = 0; i < length; ++i)
+    {
+        uint ch = text[i];
+        if (QChar::isHighSurrogate(ch) && i + 1 < length && QChar::isLowSurrogate(text[i + 1]))
+        {
+            ch = QChar::surrogateToUcs4(ushort(ch), text[++i]);
+        }
+        appendChar(ch);
+    }
+}
+
+void MatchExporter::appendChar(uint ch)
+{
+    if (ch < 0x80)
+    {
+        if (ch == '"')
+        {
+            _buffer.append(_format == Csv ? "\"\"" : "\\\"");
+        }
+        else if (_format == Jsonl && ch == '\\')
+        {
+            _buffer.append("\\\\");
+        }
+        else if (_format == Jsonl && ch < 0x20)
+        {
+            static const char hex[] = "0123456789abcdef";
+            _buffer.append("\\u00");
+            _buffer.append(hex[ch >> 4]);
+            _buffer.append(hex[ch & 0xF]);
+        }
+        else
+        {
+            _buffer.append(char(ch));
+        }
+    }
+    else if (ch < 0x800)
+    {
+        _buffer.append(char(0xC0 | (ch >> 6)));
+        _buffer.append(char(0x80 | (ch & 0x3F)));
+    }
+    else if (ch < 0x10000)
+    {
+        _buffer.append(char(0xE0 | (ch >> 12)));
+        _buffer.append(char(0x80 | ((ch >> 6) & 0x3F)));
+        _buffer.append(char(0x80 | (ch & 0x3F)));
+    }
+    else
+    {
+        _buffer.append(char(0xF0 | (ch >> 18)));
+        _buffer.append(char(0x80 | ((ch >> 12) & 0x3F)));
+        _buffer.append(char(0x80 | ((ch >> 6) & 0x3F)));
+        _buffer.append(char(0x80 | (ch & 0x3F)));
+    }
+}
+
+void MatchExporter::appendNumber(qint64 value)
+{
+    char digits[24];
+    int count = 0;
+    quint64 magnitude = value < 0 ? quint64(-(value + 1)) + 1 : quint64(value);
+    do
+    {
+        digits[count++] = char('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0)
+    {
+        _buffer.append('-');
+    }
+    while (count > 0)
+    {
+        _buffer.append(digits[--count]);
+    }
+}
+
+void MatchExporter::appendBinary(qint64 value, int bytes)
+{
+    uchar data[8];
+    qToLittleEndian(quint64(value), data);
+    _buffer.append(reinterpret_cast<const char *>(data), bytes);
+}
+
+void MatchExporter::flushBuffer()
+{
+    if (!_buffer.isEmpty() && getError().isEmpty() && _file.write(_buffer) != _buffer.size())
+    {
+        setError(_file.errorString());
+    }
+    _buffer.resize(0);
+}
+
+void MatchExporter::setError(const QString &error)
+{
+    QMutexLocker locker(&_mutex);
+    _error = error;
+    _queue.clear();
+    _queuedValues = 0;
+    _queueNotFull.wakeAll();
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef MATCHEXPORTER_H
+#define MATCHEXPORTER_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include "mappedtestee.h"
+
+/*
+ * Writes match spans to a file on its own I/O thread. The match worker
+ * hands over its span batches with enqueue(), which only blocks while
+ * too much is still waiting to be written, so a long export runs at disk
+ * speed without going through the result table. Spans are formatted into
+ * a large buffer that is written out whenever it fills up.
+ *
+ * Csv and Jsonl list every match with its position, length and the text
+ * of the match and each capture, like the batch mode. Binary is a
+ * "QRXM" header (four magic bytes, then version, capture count and flags
+ * as little-endian quint32; flag 1 means byte offsets into a mapped
+ * testee) followed by the raw (pos, length) spans as little-endian
+ * qint64, pos -1 marking an unmatched capture.
+ */
+class MatchExporter : public QThread
+{
+    Q_OBJECT
+public:
+    enum Format
+    {
+        Csv,
+        Jsonl,
+        Binary
+    };
+
+    MatchExporter(const QString &filename, Format format, QObject *parent = 0);
+    ~MatchExporter();
+    bool open();
+    QString getFilename() const;
+    QString getError() const;
+    void setTestee(const QString &testee);
+    void setMappedTestee(const MappedTesteePtr &testee);
+    void setCaptureCount(int captureCount);
+    void enqueue(const QVector<qint64> &spans);
+    void finish();
+
+signals:
+    void exportFinished(qint64 matches, const QString &error);
+
+protected:
+    void run();
+
+private:
+    void writeHeader();
+    void writeMatch(const qint64 *spans);
+    void appendText(qint64 pos, qint64 length);
+    void appendChar(uint ch);
+    void appendNumber(qint64 value);
+    void appendBinary(qint64 value, int bytes);
+    void flushBuffer();
+    void setError(const QString &error);
+
+    QFile _file;
+    Format _format;
+    QString _testee;
+    MappedTesteePtr _mappedTestee;
+    int _captureCount;
+    QByteArray _buffer;
+    qint64 _matches;
+    bool _started;
+    mutable QMutex _mutex;
+    QWaitCondition _queueNotEmpty;
+    QWaitCondition _queueNotFull;
+    QQueue<QVector<qint64> > _queue;
+    int _queuedValues;
+    bool _finishing;
+    QString _error;
+};
+
+typedef QSharedPointer<MatchExporter> MatchExporterPtr;
+
+#endif // MATCHEXPORTER_H
@@ -0,0 +1,109 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QTextDocument>
+#include <QTextBlock>
+#include "matchhighlighter.h"
+
+// Blocks rehighlighted per event loop pass.
+#define HIGHLIGHT_BATCH_BLOCKS 256
+
+MatchHighlighter::MatchHighlighter(QTextDocument *document) :
+    QSyntaxHighlighter(document),
+    _stride(2),
+    _pendingFrom(0),
+    _pendingTo(0),
+    _timer(new QTimer(this))
+{
+    _matchFormat.setBackground(QColor(255, 236, 139));
+    _captureFormat.setBackground(QColor(255, 196, 87));
+    _captureFormat.setFontUnderline(true);
+    _timer->setSingleShot(true);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(rehighlightPending()));
+}
+
+void MatchHighlighter::setMatches(const QVector<qint64> &spans, int captureCount, int from, int to)
+{
+    _spans = spans;
+    _stride = 2 * (captureCount + 1);
+
+    if (_timer->isActive())
+    {
+        _pendingFrom = qMin(_pendingFrom, from);
+        _pendingTo = qMax(_pendingTo, to);
+    }
+    else
+    {
+        _pendingFrom = from;
+        _pendingTo = to;
+    }
+    _timer->start(0);
+}
+
+void MatchHighlighter::clearMatches()
+{
+    setMatches(QVector<qint64>(), 0, 0, document()->characterCount());
+}
+
+void MatchHighlighter::highlightBlock(const QString &text)
+{
+    qint64 blockStart = currentBlock().position();
+    qint64 blockEnd = blockStart + text.length();
+
+    for (int i = firstMatchEndingAfter(blockStart); i >= 0 && i + _stride <= _spans.size(); i += _stride)
+    {
+        if (_spans.at(i) >= blockEnd)
+        {
+            break;
+        }
+        for (int nth = 0; nth < _stride / 2; ++nth)
+        {
+            qint64 pos = _spans.at(i + nth * 2);
+            qint64 length = _spans.at(i + nth * 2 + 1);
+            qint64 start = qMax(pos, blockStart);
+            qint64 end = qMin(pos + length, blockEnd);
+            if (pos >= 0 && end > start)
+            {
+                setFormat(int(start - blockStart), int(end - start), nth == 0 ? _matchFormat : _captureFormat);
+            }
+        }
+    }
+}
+
+void MatchHighlighter::rehighlightPending()
+{
+    QTextBlock block = document()->findBlock(_pendingFrom);
+    for (int i = 0; i < HIGHLIGHT_BATCH_BLOCKS && block.isValid() && block.position() <= _pendingTo; ++i)
+    {
+        rehighlightBlock(block);
+        block = block.next();
+    }
+
+    if (block.isValid() && block.position() <= _pendingTo)
+    {
+        _pendingFrom = block.position();
+        _timer->start(0);
+    }
+}
+
+int MatchHighlighter::firstMatchEndingAfter(qint64 position) const
+{
+    // Matches don't overlap, so both their starts and ends are sorted.
+    int low = 0;
+    int high = _spans.size() / _stride;
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        int i = middle * _stride;
+        if (_spans.at(i) + _spans.at(i + 1) <= position)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low * _stride;
+}
@@ -0,0 +1,45 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef MATCHHIGHLIGHTER_H
+#define MATCHHIGHLIGHTER_H
+
+#include <QSyntaxHighlighter>
+#include <QTextCharFormat>
+#include <QTimer>
+#include <QVector>
+
+/*
+ * Marks matches and their captures inside the testee editor. Spans use the
+ * flat (pos, length) layout of MatchResultModel, with document positions.
+ * Only the blocks of a changed range are rehighlighted, a batch per event
+ * loop pass, so a large testee doesn't freeze typing.
+ */
+class MatchHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+public:
+    explicit MatchHighlighter(QTextDocument *document);
+    void setMatches(const QVector<qint64> &spans, int captureCount, int from, int to);
+    void clearMatches();
+
+protected:
+    void highlightBlock(const QString &text);
+
+private slots:
+    void rehighlightPending();
+
+private:
+    int firstMatchEndingAfter(qint64 position) const;
+
+    QVector<qint64> _spans;
+    int _stride;
+    int _pendingFrom;
+    int _pendingTo;
+    QTimer *_timer;
+    QTextCharFormat _matchFormat;
+    QTextCharFormat _captureFormat;
+};
+
+#endif // MATCHHIGHLIGHTER_H
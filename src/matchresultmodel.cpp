@@ -0,0 +1,249 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "matchresultmodel.h"
+
+#define MAX_DISPLAY_LENGTH 1024
+#define DEFAULT_MEMORY_BUDGET (qint64(1024) * 1024 * 1024)
+
+MatchResultModel::MatchResultModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    _captureCount(0),
+    _memoryBudget(DEFAULT_MEMORY_BUDGET)
+{
+}
+
+void MatchResultModel::clear()
+{
+    beginResetModel();
+    _textRows.clear();
+    _spans.clear();
+    endResetModel();
+}
+
+void MatchResultModel::setTestee(const QString &testee)
+{
+    _testee = testee;
+    _mappedTestee.clear();
+}
+
+void MatchResultModel::setMappedTestee(const MappedTesteePtr &testee)
+{
+    _testee.clear();
+    _mappedTestee = testee;
+}
+
+void MatchResultModel::setCaptureCount(int captureCount)
+{
+    beginResetModel();
+    _captureCount = qMax(captureCount, 0);
+    _spans.clear();
+    endResetModel();
+}
+
+int MatchResultModel::getCaptureCount() const
+{
+    return _captureCount;
+}
+
+void MatchResultModel::appendTextRows(const MatchResultRows &rows)
+{
+    if (rows.isEmpty())
+    {
+        return;
+    }
+    // Text rows are listed before the matches.
+    int first = _textRows.count();
+    beginInsertRows(QModelIndex(), first, first + rows.count() - 1);
+    _textRows << rows;
+    endInsertRows();
+}
+
+/*
+ * Appends as many whole matches as the memory budget leaves room for, and
+ * returns false when that wasn't all of them.
+ */
+bool MatchResultModel::appendMatches(const QVector<qint64> &spans)
+{
+    int stride = spanStride();
+    qint64 room = _memoryBudget / qint64(sizeof(qint64)) - _spans.size();
+    int count = int(qMin(qint64(spans.size() / stride), qMax(room, qint64(0)) / stride));
+    if (count > 0)
+    {
+        int first = rowCount();
+        beginInsertRows(QModelIndex(), first, first + count - 1);
+        _spans.append(spans.constData(), count * stride);
+        endInsertRows();
+    }
+    return count == spans.size() / stride;
+}
+
+void MatchResultModel::setMemoryBudget(qint64 bytes)
+{
+    _memoryBudget = bytes;
+}
+
+qint64 MatchResultModel::getMemoryBudget() const
+{
+    return _memoryBudget;
+}
+
+qint64 MatchResultModel::memoryUsage() const
+{
+    return _spans.byteSize();
+}
+
+int MatchResultModel::matchCount() const
+{
+    return int(_spans.size() / spanStride());
+}
+
+qint64 MatchResultModel::matchPos(int match, int nth) const
+{
+    return _spans.at(qint64(match) * spanStride() + nth * 2);
+}
+
+qint64 MatchResultModel::matchLength(int match, int nth) const
+{
+    return _spans.at(qint64(match) * spanStride() + nth * 2 + 1);
+}
+
+/*
+ * Index of the first match starting at or after pos, or -1; matches are
+ * kept in the order of their positions.
+ */
+int MatchResultModel::firstMatchFrom(qint64 pos) const
+{
+    int low = 0;
+    int high = matchCount();
+    while (low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if (matchPos(middle) < pos)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low < matchCount() ? low : -1;
+}
+
+int MatchResultModel::matchRow(int match) const
+{
+    return _textRows.count() + match;
+}
+
+QVector<qint64> MatchResultModel::spans() const
+{
+    return _spans.toVector();
+}
+
+int MatchResultModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return _textRows.count() + matchCount();
+}
+
+int MatchResultModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return 2 + _captureCount;
+}
+
+QVariant MatchResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::ToolTipRole))
+    {
+        return QVariant();
+    }
+
+    int row = index.row();
+    int column = index.column();
+    if (row < _textRows.count())
+    {
+        const MatchResultRow &textRow = _textRows.at(row);
+        if (column == 0)
+        {
+            return textRow.first;
+        }
+        else if (column == 1)
+        {
+            return textRow.second;
+        }
+        return QVariant();
+    }
+
+    int match = row - _textRows.count();
+    qint64 pos = matchPos(match);
+    qint64 len = matchLength(match);
+    if (column == 0)
+    {
+        QString title = _mappedTestee.isNull() ? tr("Testee[%1, %2]") : tr("Bytes[%1, %2]");
+        return title.arg(pos).arg(pos + len - 1);
+    }
+    else if (column == 1)
+    {
+        return spanText(pos, len);
+    }
+    int nth = column - 1;
+    if (matchPos(match, nth) < 0)
+    {
+        return QVariant();
+    }
+    return spanText(matchPos(match, nth), matchLength(match, nth));
+}
+
+QVariant MatchResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+    if (orientation == Qt::Vertical)
+    {
+        return section + 1;
+    }
+    if (section == 0)
+    {
+        return tr("Item");
+    }
+    else if (section == 1)
+    {
+        return tr("Result");
+    }
+    return QString(tr("cap(%1)")).arg(section - 1);
+}
+
+int MatchResultModel::spanStride() const
+{
+    return 2 * (_captureCount + 1);
+}
+
+QString MatchResultModel::spanText(qint64 pos, qint64 length) const
+{
+    if (!_mappedTestee.isNull())
+    {
+        // A character is at most four UTF-8 bytes.
+        QString text = _mappedTestee->text(pos, qMin(length, qint64(MAX_DISPLAY_LENGTH * 4)));
+        if (text.length() > MAX_DISPLAY_LENGTH || length > MAX_DISPLAY_LENGTH * 4)
+        {
+            return text.left(MAX_DISPLAY_LENGTH) + QString("...");
+        }
+        return text;
+    }
+    if (length > MAX_DISPLAY_LENGTH)
+    {
+        return _testee.mid(int(pos), MAX_DISPLAY_LENGTH) + QString("...");
+    }
+    return _testee.mid(int(pos), int(length));
+}
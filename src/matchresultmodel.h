@@ -0,0 +1,66 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef MATCHRESULTMODEL_H
+#define MATCHRESULTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <QVector>
+#include "matchworker.h"
+#include "mappedtestee.h"
+#include "spanarena.h"
+
+/*
+ * Result table model. Free-form rows (the exactMatch summary) are kept as
+ * strings and listed first; matches, including a successful exactMatch,
+ * are kept as a flat vector of (pos, length) spans, one span for the
+ * whole match plus one per capture, and only turned into strings when the
+ * view asks for a visible cell.
+ * Spans index the QString testee, or hold byte offsets when the matches
+ * come from a mapped testee file.
+ *
+ * The spans live in a SpanArena, and appendMatches() stops taking new
+ * ones once the arena would grow past the memory budget.
+ */
+class MatchResultModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    explicit MatchResultModel(QObject *parent = 0);
+    void clear();
+    void setTestee(const QString &testee);
+    void setMappedTestee(const MappedTesteePtr &testee);
+    void setCaptureCount(int captureCount);
+    int getCaptureCount() const;
+    void appendTextRows(const MatchResultRows &rows);
+    bool appendMatches(const QVector<qint64> &spans);
+    void setMemoryBudget(qint64 bytes);
+    qint64 getMemoryBudget() const;
+    qint64 memoryUsage() const;
+    int matchCount() const;
+    qint64 matchPos(int match, int nth = 0) const;
+    qint64 matchLength(int match, int nth = 0) const;
+    int firstMatchFrom(qint64 pos) const;
+    int matchRow(int match) const;
+    QVector<qint64> spans() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+private:
+    int spanStride() const;
+    QString spanText(qint64 pos, qint64 length) const;
+
+    QString _testee;
+    MappedTesteePtr _mappedTestee;
+    int _captureCount;
+    MatchResultRows _textRows;
+    SpanArena _spans;
+    qint64 _memoryBudget;
+};
+
+#endif // MATCHRESULTMODEL_H
@@ -0,0 +1,840 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <qmath.h>
+#include "matchworker.h"
+#include "parallelscanner.h"
+#include "patternanalyzer.h"
+#include "prefilter.h"
+#include "compressedstream.h"
+
+#define FLUSH_INTERVAL_MS 100
+#define FLUSH_MAX_SPANS 8192
+// Growth probe: attempts are repeated until they add up to the sample
+// time, and probing stops once a single attempt exceeds the budget.
+#define PROBE_SAMPLE_NS (2 * 1000 * 1000)
+#define PROBE_BUDGET_NS (250 * 1000 * 1000)
+// Shorter timings are too noisy to fit a growth exponent on.
+#define PROBE_RESOLUTION_NS (20 * 1000)
+// Matches of a compressed testee beyond this are counted but not listed.
+#define MAX_STREAMED_ROWS 100000
+#define MAX_STREAMED_ROW_TEXT 1024
+// A comparison lists at most this many differing positions.
+#define MAX_COMPARE_DIFFERENCES 10000
+// The profiler recurses once per repeated character.
+#define PROFILE_STACK_BYTES (64 * 1024 * 1024)
+
+MatchWorker::MatchWorker(const RegExpController &controller, QObject *parent) :
+    QThread(parent),
+    _regexp(new RegExpController()),
+    _other(NULL),
+    _mode(ExactMatch),
+    _chunkSize(0),
+    _overlapSize(0),
+    _parallel(false),
+    _benchmarkPasses(0),
+    _benchmarkWarmup(0),
+    _liveFrom(0),
+    _liveLimit(0),
+    _maxMatches(0),
+    _maxMsecs(0),
+    _canceled(0),
+    _lastFlush(0)
+{
+    qRegisterMetaType<MatchResultRows>("MatchResultRows");
+    qRegisterMetaType<QVector<qint64> >("QVector<qint64>");
+    qRegisterMetaType<BenchmarkResult>("BenchmarkResult");
+    qRegisterMetaType<PatternProfile>("PatternProfile");
+    qRegisterMetaType<ComparisonResult>("ComparisonResult");
+    _regexp->copyFrom(controller);
+}
+
+MatchWorker::~MatchWorker()
+{
+    wait();
+    delete _regexp;
+    delete _other;
+}
+
+void MatchWorker::setMode(MatchWorker::Mode mode)
+{
+    _mode = mode;
+    if (_mode == Profile)
+    {
+        setStackSize(PROFILE_STACK_BYTES);
+    }
+}
+
+MatchWorker::Mode MatchWorker::getMode() const
+{
+    return _mode;
+}
+
+void MatchWorker::setTestee(const QString &testee)
+{
+    _testee = testee;
+}
+
+void MatchWorker::setMappedTestee(const MappedTesteePtr &testee, qint64 chunkSize, qint64 overlapSize)
+{
+    _mappedTestee = testee;
+    _chunkSize = qMax(chunkSize, qint64(1));
+    _overlapSize = qMax(overlapSize, qint64(0));
+}
+
+void MatchWorker::setCompressedTestee(const QString &filename, qint64 chunkSize, qint64 overlapSize)
+{
+    _compressedTestee = filename;
+    _chunkSize = qBound(qint64(1), chunkSize, qint64(1024) * 1024 * 1024);
+    _overlapSize = qMax(overlapSize, qint64(0));
+}
+
+void MatchWorker::setParallel(bool parallel)
+{
+    _parallel = parallel;
+}
+
+void MatchWorker::setBenchmark(int passes, int warmup)
+{
+    _benchmarkPasses = passes;
+    _benchmarkWarmup = warmup;
+}
+
+void MatchWorker::setMatchLimits(int maxMatches, qint64 maxMsecs)
+{
+    _maxMatches = maxMatches;
+    _maxMsecs = maxMsecs;
+}
+
+void MatchWorker::setComparison(const RegExpController &other)
+{
+    delete _other;
+    _other = new RegExpController();
+    _other->copyFrom(other);
+}
+
+void MatchWorker::setLiveRange(int from, int limit, const QVector<qint64> &head, const QVector<qint64> &tail)
+{
+    _liveFrom = from;
+    _liveLimit = limit;
+    _liveHead = head;
+    _liveTail = tail;
+}
+
+void MatchWorker::setExporter(const MatchExporterPtr &exporter)
+{
+    _exporter = exporter;
+}
+
+void MatchWorker::cancel()
+{
+    _canceled.fetchAndStoreOrdered(1);
+}
+
+bool MatchWorker::isCanceled() const
+{
+    return _canceled.loadAcquire() != 0;
+}
+
+void MatchWorker::run()
+{
+    _pendingRows.clear();
+    _pendingSpans.clear();
+    _lastFlush = 0;
+    _timer.start();
+
+    if (_mode == ExactMatch)
+    {
+        doExactMatch();
+    }
+    else if (_mode == BenchmarkIndexIn)
+    {
+        doBenchmark();
+        return;
+    }
+    else if (_mode == GrowthProbe)
+    {
+        doGrowthProbe();
+        flushResults(true);
+        return;
+    }
+    else if (_mode == Profile)
+    {
+        doProfile();
+        return;
+    }
+    else if (_mode == Compare)
+    {
+        doCompare();
+        return;
+    }
+    else if (_mode == LiveIndexIn)
+    {
+        doLiveIndexIn();
+    }
+    else if (!_compressedTestee.isEmpty())
+    {
+        doCompressedIndexIn();
+    }
+    else if (!_mappedTestee.isNull())
+    {
+        doMappedIndexIn();
+    }
+    // Slices can't share a time limit, so only the match limit is kept.
+    else if (_parallel && _maxMsecs == 0 && ParallelScanner::isSupported(*_regexp))
+    {
+        doParallelIndexIn();
+    }
+    else
+    {
+        doIndexIn();
+    }
+    qint64 nsecs = _timer.nsecsElapsed();
+    flushResults(true);
+    if (!_exporter.isNull())
+    {
+        _exporter->finish();
+    }
+    if (!isCanceled())
+    {
+        // Timings are kept per engine name, so with and without the
+        // prefilter show up side by side.
+        QString engine = _regexp->engine()->name();
+        if (_mode != ExactMatch && _regexp->isPrefiltered())
+        {
+            engine += tr(" + prefilter");
+        }
+        emit matchingFinished(engine, nsecs);
+    }
+}
+
+void MatchWorker::doExactMatch()
+{
+    bool matchResult = _regexp->exactMatch(_testee);
+
+    _pendingRows << MatchResultRow(tr("exactMatch(...)"), matchResult ? QString("true") : QString("false"));
+    _pendingRows << MatchResultRow(tr("matchedLength"), QString::number(_regexp->matchedLength()));
+    _pendingRows << MatchResultRow(tr("captureCount"), QString::number(_regexp->captureCount()));
+    // The captures are listed as a match row, read from the testee on display.
+    if (matchResult)
+    {
+        _regexp->appendSpans(_pendingSpans);
+    }
+    emit progressChanged(_testee.length(), _testee.length(), matchResult ? 1 : 0);
+}
+
+void MatchWorker::doIndexIn()
+{
+    RegExpMatchIterator it(*_regexp, _testee);
+    bool open = applyLimits(it, 0);
+
+    while (open && !isCanceled() && it.next())
+    {
+        _regexp->appendSpans(_pendingSpans);
+        if (isFlushDue())
+        {
+            flushResults(false);
+            emit progressChanged(it.nextFrom(), _testee.length(), it.matchCount());
+        }
+    }
+    if (!open || it.isLimited())
+    {
+        warnLimited(it.matchCount());
+    }
+    bool stopped = isCanceled() || !open || it.isLimited();
+    emit progressChanged(stopped ? qMin(it.nextFrom(), _testee.length()) : _testee.length(),
+                         _testee.length(), it.matchCount());
+}
+
+void MatchWorker::doParallelIndexIn()
+{
+    ParallelScanner scanner(*_regexp);
+    scanner.setTestee(_testee);
+    scanner.setMaxMatches(_maxMatches);
+    scanner.start();
+    while (!scanner.isFinished())
+    {
+        if (isCanceled())
+        {
+            scanner.cancel();
+        }
+        msleep(FLUSH_INTERVAL_MS / 4);
+        emit progressChanged(scanner.scannedLength(), _testee.length(), 0);
+    }
+
+    _pendingSpans = scanner.result();
+    int matches = _pendingSpans.size() / _regexp->spanStride();
+    if (_maxMatches > 0 && matches >= _maxMatches)
+    {
+        warnLimited(matches);
+    }
+    emit progressChanged(_testee.length(), _testee.length(), matches);
+}
+
+void MatchWorker::doLiveIndexIn()
+{
+    int stride = _regexp->spanStride();
+    int matches = _liveHead.size() / stride;
+    int to = _testee.length();
+    int tailIndex = 0;
+
+    // A rescan from inside the text must not anchor '^' where it starts.
+    if (_liveFrom > 0 && _regexp->getCaretMode() == QRegExp::CaretAtOffset)
+    {
+        _regexp->setCaretMode(QRegExp::CaretWontMatch);
+    }
+    RegExpMatchIterator it(*_regexp, _testee, _liveFrom);
+    bool open = applyLimits(it, matches);
+
+    _pendingSpans = _liveHead;
+    while (open && !isCanceled() && it.next())
+    {
+        int pos = it.pos();
+        int len = it.matchedLength();
+        if (pos >= _liveLimit)
+        {
+            while (tailIndex < _liveTail.size() && _liveTail.at(tailIndex) < pos)
+            {
+                tailIndex += stride;
+            }
+            if (tailIndex < _liveTail.size() && _liveTail.at(tailIndex) == pos && _liveTail.at(tailIndex + 1) == len)
+            {
+                _pendingSpans += _liveTail.mid(tailIndex);
+                matches += (_liveTail.size() - tailIndex) / stride;
+                to = pos;
+                break;
+            }
+        }
+
+        _regexp->appendSpans(_pendingSpans);
+        matches ++;
+
+        if (isFlushDue())
+        {
+            flushResults(false);
+            emit progressChanged(it.nextFrom(), _testee.length(), matches);
+        }
+    }
+    if (!open || it.isLimited())
+    {
+        warnLimited(matches);
+    }
+
+    flushResults(false);
+    emit progressChanged(_testee.length(), _testee.length(), matches);
+    if (!isCanceled())
+    {
+        emit rescanFinished(_liveFrom, to);
+    }
+}
+
+void MatchWorker::doMappedIndexIn()
+{
+    const char *data = _mappedTestee->data();
+    qint64 size = _mappedTestee->size();
+    qint64 chunkStart = 0;
+    qint64 resumeByte = 0;
+    int matches = 0;
+    int truncated = 0;
+    int captureCount = _regexp->captureCount();
+    // '^' may only match at the real beginning of the testee.
+    bool anchored = (_regexp->getCaretMode() != QRegExp::CaretWontMatch);
+
+    while (!isCanceled() && chunkStart < size)
+    {
+        qint64 chunkEnd = _mappedTestee->alignToChar(chunkStart + _chunkSize);
+        if (chunkEnd <= chunkStart)
+        {
+            chunkEnd = qMin(size, chunkStart + _chunkSize);
+        }
+        qint64 overlapEnd = _mappedTestee->alignToChar(chunkEnd + _overlapSize);
+        QString text = QString::fromUtf8(data + chunkStart, int(chunkEnd - chunkStart));
+        int ownLength = text.length();
+        text += QString::fromUtf8(data + chunkEnd, int(overlapEnd - chunkEnd));
+
+        // Only the first chunk starts at the real beginning of the testee.
+        if (chunkStart > 0 && anchored)
+        {
+            _regexp->setCaretMode(QRegExp::CaretWontMatch);
+        }
+
+        RegExpMatchIterator it(*_regexp, text, MappedTestee::utf16Length(data + chunkStart, resumeByte - chunkStart));
+        if (!applyLimits(it, matches))
+        {
+            warnLimited(matches);
+            break;
+        }
+        int cursorChar = 0;
+        qint64 cursorByte = chunkStart;
+        while (!isCanceled() && it.next() && it.pos() < ownLength)
+        {
+            int pos = it.pos();
+            int len = it.matchedLength();
+            cursorByte += MappedTestee::utf8Length(text.constData() + cursorChar, pos - cursorChar);
+            cursorChar = pos;
+            for (int i = 0; i <= captureCount; ++i)
+            {
+                int capPos = _regexp->pos(i);
+                int capLen = _regexp->capturedLength(i);
+                if (capPos < 0)
+                {
+                    _pendingSpans << -1 << 0;
+                    continue;
+                }
+                _pendingSpans << cursorByte + MappedTestee::utf8Length(text.constData() + pos, capPos - pos)
+                              << MappedTestee::utf8Length(text.constData() + capPos, capLen);
+            }
+            if (pos + len >= text.length() && overlapEnd < size)
+            {
+                truncated ++;
+            }
+            resumeByte = cursorByte + MappedTestee::utf8Length(text.constData() + pos, len);
+            matches ++;
+
+            if (isFlushDue())
+            {
+                flushResults(false);
+                emit progressChanged(chunkStart, size, matches);
+            }
+        }
+
+        resumeByte = qMax(resumeByte, chunkEnd);
+        chunkStart = chunkEnd;
+        flushResults(false);
+        emit progressChanged(chunkStart, size, matches);
+        if (it.isLimited())
+        {
+            warnLimited(matches);
+            break;
+        }
+    }
+
+    if (truncated > 0)
+    {
+        emit truncatedMatchesFound(truncated);
+    }
+}
+
+void MatchWorker::doCompressedIndexIn()
+{
+    CompressedStream stream(_compressedTestee, int(_chunkSize));
+    stream.start();
+    QByteArray window;
+    QByteArray chunk;
+    qint64 windowStart = 0;
+    qint64 nextByte = 0;
+    int matches = 0;
+    int truncated = 0;
+    bool atEnd = false;
+    // '^' may only match at the real beginning of the testee.
+    bool anchored = (_regexp->getCaretMode() != QRegExp::CaretWontMatch);
+
+    while (!isCanceled() && !atEnd)
+    {
+        atEnd = !stream.readChunk(chunk);
+        window += chunk;
+        chunk.clear();
+
+        // Matches have to start in front of the overlap, so they can run
+        // on into it, unless this is the end of the data.
+        int decodedEnd = atEnd ? window.size() : int(MappedTestee::alignToChar(window.constData(), window.size(), window.size()));
+        int ownEnd = atEnd ? window.size() : int(MappedTestee::alignToChar(window.constData(), window.size(), window.size() - _overlapSize));
+        int from = int(nextByte - windowStart);
+        if (ownEnd <= from && !atEnd)
+        {
+            continue;
+        }
+        if (windowStart > 0 && anchored)
+        {
+            _regexp->setCaretMode(QRegExp::CaretWontMatch);
+        }
+
+        QString text = QString::fromUtf8(window.constData(), decodedEnd);
+        int ownLength = MappedTestee::utf16Length(window.constData(), ownEnd);
+        int cursorChar = MappedTestee::utf16Length(window.constData(), from);
+        qint64 cursorByte = from;
+        RegExpMatchIterator it(*_regexp, text, cursorChar);
+        if (!applyLimits(it, matches))
+        {
+            warnLimited(matches);
+            break;
+        }
+        while (!isCanceled() && it.next() && it.pos() < ownLength)
+        {
+            int pos = it.pos();
+            int len = it.matchedLength();
+            cursorByte += MappedTestee::utf8Length(text.constData() + cursorChar, pos - cursorChar);
+            cursorChar = pos;
+            if (matches < MAX_STREAMED_ROWS)
+            {
+                int byteLen = MappedTestee::utf8Length(text.constData() + pos, len);
+                _pendingRows << MatchResultRow(QString(tr("Bytes[%1, %2]"))
+                                               .arg(windowStart + cursorByte)
+                                               .arg(windowStart + cursorByte + byteLen - 1),
+                                               text.mid(pos, qMin(len, MAX_STREAMED_ROW_TEXT)));
+            }
+            if (pos + len >= text.length() && !atEnd)
+            {
+                truncated ++;
+            }
+            int step = qMin(it.nextFrom(), text.length()) - pos;
+            nextByte = windowStart + cursorByte + MappedTestee::utf8Length(text.constData() + pos, step);
+            matches ++;
+
+            if (isFlushDue())
+            {
+                flushResults(false);
+                emit progressChanged(stream.compressedPos(), stream.compressedSize(), matches);
+            }
+        }
+
+        // The unscanned rest of the window starts the next one.
+        nextByte = qMax(nextByte, windowStart + ownEnd);
+        window = window.mid(int(nextByte - windowStart));
+        windowStart = nextByte;
+        flushResults(false);
+        emit progressChanged(stream.compressedPos(), stream.compressedSize(), matches);
+        if (it.isLimited())
+        {
+            warnLimited(matches);
+            break;
+        }
+    }
+
+    stream.cancel();
+    if (!stream.getError().isEmpty())
+    {
+        emit warningRaised(QString(tr("ERROR: %1")).arg(stream.getError()));
+    }
+    if (truncated > 0)
+    {
+        emit truncatedMatchesFound(truncated);
+    }
+    if (matches > MAX_STREAMED_ROWS)
+    {
+        emit warningRaised(QString(tr("%1 matches found, only the first %2 are listed.")).arg(matches).arg(MAX_STREAMED_ROWS));
+    }
+}
+
+void MatchWorker::doBenchmark()
+{
+    BenchmarkResult result;
+    BenchmarkResult unfiltered;
+    QElapsedTimer passTimer;
+    int passes = _benchmarkWarmup + _benchmarkPasses;
+    // A prefiltered pattern runs a second series without the prefilter.
+    bool compare = _regexp->isPrefiltered();
+    int total = compare ? 2 * passes : passes;
+
+    result.engine = _regexp->engine()->name();
+    result.pattern = _regexp->getPattern();
+    result.warmup = _benchmarkWarmup;
+    result.testeeBytes = MappedTestee::utf8Length(_testee.constData(), _testee.length());
+    if (compare)
+    {
+        result.prefilter = _regexp->prefilter()->description();
+    }
+
+    for (int i = 0; i < total && !isCanceled(); ++i)
+    {
+        if (i == passes)
+        {
+            _regexp->setPrefilterEnabled(false);
+        }
+        passTimer.start();
+        result.matchesPerPass = Benchmark::scan(*_regexp, _testee);
+        qint64 nsecs = passTimer.nsecsElapsed();
+        if (i % passes >= _benchmarkWarmup)
+        {
+            (i < passes ? result : unfiltered).addSample(nsecs);
+        }
+        if (isFlushDue() || i == total - 1)
+        {
+            _lastFlush = _timer.elapsed();
+            emit progressChanged(i + 1, total, result.matchesPerPass);
+        }
+    }
+    _regexp->setPrefilterEnabled(true);
+    result.unfilteredMedian = unfiltered.median();
+
+    if (!isCanceled())
+    {
+        emit benchmarkFinished(result);
+    }
+}
+
+void MatchWorker::doCompare()
+{
+    ComparisonResult result;
+    QElapsedTimer passTimer;
+    int passes = _benchmarkWarmup + _benchmarkPasses;
+    qint64 testeeBytes = MappedTestee::utf8Length(_testee.constData(), _testee.length());
+    RegExpController *sides[2] = { _regexp, _other };
+    BenchmarkResult *results[2] = { &result.a, &result.b };
+
+    for (int side = 0; side < 2; ++side)
+    {
+        results[side]->engine = sides[side]->engine()->name();
+        results[side]->pattern = sides[side]->getPattern();
+        results[side]->warmup = _benchmarkWarmup;
+        results[side]->testeeBytes = testeeBytes;
+    }
+
+    for (int i = 0; i < passes && !isCanceled(); ++i)
+    {
+        qint64 nsecs[2];
+        for (int j = 0; j < 2; ++j)
+        {
+            // Odd passes run B first.
+            int side = (i % 2 == 0) ? j : 1 - j;
+            passTimer.start();
+            results[side]->matchesPerPass = Benchmark::scan(*sides[side], _testee);
+            nsecs[side] = passTimer.nsecsElapsed();
+        }
+        if (i >= _benchmarkWarmup)
+        {
+            result.addSamples(nsecs[0], nsecs[1]);
+        }
+        if (isFlushDue() || i == passes - 1)
+        {
+            _lastFlush = _timer.elapsed();
+            emit progressChanged(i + 1, passes, result.a.matchesPerPass);
+        }
+    }
+
+    if (!isCanceled())
+    {
+        compareMatches(result);
+    }
+    if (!isCanceled())
+    {
+        emit comparisonFinished(result);
+    }
+}
+
+/*
+ * Steps through the matches of both sides as Benchmark::scan() finds
+ * them. A position differs when only one side matches there or the match
+ * texts differ; when both have the same number of captures, those have to
+ * agree too.
+ */
+void MatchWorker::compareMatches(ComparisonResult &result)
+{
+    const RegExpController &a = *_regexp;
+    const RegExpController &b = *_other;
+    bool sameCaptures = (a.captureCount() == b.captureCount());
+    RegExpMatchIterator itA(a, _testee);
+    RegExpMatchIterator itB(b, _testee);
+    int posA = itA.next() ? itA.pos() : -1;
+    int posB = itB.next() ? itB.pos() : -1;
+    while ((posA != -1 || posB != -1) && !isCanceled())
+    {
+        bool atA = (posA != -1 && (posB == -1 || posA <= posB));
+        bool atB = (posB != -1 && (posA == -1 || posB <= posA));
+        QStringList capturesA = atA ? a.capturedTexts() : QStringList();
+        QStringList capturesB = atB ? b.capturedTexts() : QStringList();
+        bool differs = (atA != atB) ||
+                       (sameCaptures ? capturesA != capturesB : capturesA.value(0) != capturesB.value(0));
+        if (differs)
+        {
+            result.differenceCount ++;
+            if (result.differences.size() < MAX_COMPARE_DIFFERENCES)
+            {
+                MatchDifference difference;
+                difference.pos = atA ? posA : posB;
+                difference.capturesA = capturesA;
+                difference.capturesB = capturesB;
+                result.differences << difference;
+            }
+        }
+        if (atA)
+        {
+            posA = itA.next() ? itA.pos() : -1;
+        }
+        if (atB)
+        {
+            posB = itB.next() ? itB.pos() : -1;
+        }
+    }
+}
+
+void MatchWorker::doGrowthProbe()
+{
+    static const int pumpCounts[] = {4, 8, 12, 16, 20, 24, 28, 32, 48, 64, 96, 128, 256, 512, 1024, 2048, 4096};
+    const int probes = int(sizeof(pumpCounts) / sizeof(pumpCounts[0]));
+    PatternAnalyzer analyzer(*_regexp);
+    QElapsedTimer attemptTimer;
+    double nsecsPerStep = 0.0;
+    double lastNsecs = 0.0;
+    int lastLength = 0;
+    double exponent = 0.0;
+
+    // Probe inputs often lack the required literal; time the engine itself.
+    _regexp->setPrefilterEnabled(false);
+    for (int i = 0; i < probes && !isCanceled(); ++i)
+    {
+        QString input = analyzer.probeInput(pumpCounts[i]);
+        int attempts = 0;
+        attemptTimer.start();
+        do
+        {
+            _regexp->indexIn(input, 0);
+            attempts ++;
+        } while (attemptTimer.nsecsElapsed() < PROBE_SAMPLE_NS && !isCanceled());
+        double nsecs = double(attemptTimer.nsecsElapsed()) / attempts;
+
+        // The shortest input is assumed to be scanned in linear time.
+        if (nsecsPerStep == 0.0)
+        {
+            nsecsPerStep = qMax(nsecs / input.length(), 1.0);
+        }
+        if (lastNsecs >= PROBE_RESOLUTION_NS)
+        {
+            exponent = qLn(nsecs / lastNsecs) / qLn(double(input.length()) / lastLength);
+        }
+        lastNsecs = nsecs;
+        lastLength = input.length();
+
+        _pendingRows << MatchResultRow(QString(tr("length %1")).arg(input.length()),
+                                       QString(tr("%1 ms, ~%2 steps (%3 per char)"))
+                                       .arg(nsecs / 1000000.0, 0, 'f', 3)
+                                       .arg(nsecs / nsecsPerStep, 0, 'f', 0)
+                                       .arg(nsecs / nsecsPerStep / input.length(), 0, 'f', 1));
+        flushResults(false);
+        emit progressChanged(i + 1, probes, 0);
+        if (nsecs > PROBE_BUDGET_NS)
+        {
+            break;
+        }
+    }
+    if (isCanceled())
+    {
+        return;
+    }
+
+    QString growth;
+    if (exponent < 1.5)
+    {
+        growth = tr("linear");
+    }
+    else if (exponent < 2.5)
+    {
+        growth = QString(tr("super-linear, about O(n^%1)")).arg(exponent, 0, 'f', 1);
+    }
+    else
+    {
+        growth = QString(tr("catastrophic, about O(n^%1) and rising")).arg(exponent, 0, 'f', 1);
+    }
+    _pendingRows << MatchResultRow(tr("probe input"), analyzer.probeInput(4));
+    _pendingRows << MatchResultRow(tr("growth"), growth);
+    if (exponent >= 1.5)
+    {
+        emit warningRaised(QString(tr("WARNING: matching time grows %1 with the input length.")).arg(growth));
+    }
+}
+
+void MatchWorker::doProfile()
+{
+    PatternProfiler profiler(*_regexp);
+    if (!profiler.isParsed())
+    {
+        emit warningRaised(tr("WARNING: the pattern can't be profiled, its syntax isn't understood."));
+        return;
+    }
+
+    int pos = 0;
+    while (!isCanceled() && pos <= _testee.length() && (pos = profiler.indexIn(_testee, pos)) != -1)
+    {
+        // Past an empty match by a whole code point, as RegExpMatchIterator.
+        int length = profiler.matchedLength();
+        pos = length > 0 ? pos + length : RegExpMatchIterator::nextCodePoint(_testee, pos);
+        if (isFlushDue())
+        {
+            _lastFlush = _timer.elapsed();
+            emit progressChanged(pos, _testee.length(), profiler.profile().matches);
+        }
+    }
+    if (isCanceled())
+    {
+        return;
+    }
+
+    // The profile only covers the text it got through; time the same.
+    PatternProfile profile = profiler.profile();
+    profile.textLength = _testee.length();
+    QElapsedTimer engineTimer;
+    engineTimer.start();
+    Benchmark::scan(*_regexp, _testee.left(profile.scanned));
+    profile.nsecs = engineTimer.nsecsElapsed();
+    emit progressChanged(profile.scanned, _testee.length(), profile.matches);
+    emit profileFinished(profile);
+}
+
+/*
+ * Limits an iterator to what is left of the run's match count and time
+ * limits, once matches were found and some time was spent. False when
+ * nothing is left, so the iterator must not search at all.
+ */
+bool MatchWorker::applyLimits(RegExpMatchIterator &it, int matches) const
+{
+    qint64 elapsed = _timer.elapsed();
+    if ((_maxMatches > 0 && matches >= _maxMatches) || (_maxMsecs > 0 && elapsed >= _maxMsecs))
+    {
+        return false;
+    }
+    if (_maxMatches > 0)
+    {
+        it.setMaxMatches(_maxMatches - matches);
+    }
+    if (_maxMsecs > 0)
+    {
+        it.setMaxMsecs(_maxMsecs - elapsed);
+    }
+    return true;
+}
+
+void MatchWorker::warnLimited(int matches)
+{
+    if (_maxMatches > 0 && matches >= _maxMatches)
+    {
+        emit warningRaised(QString(tr("WARNING: matching stopped at the limit of %1 matches.")).arg(_maxMatches));
+    }
+    else
+    {
+        emit warningRaised(QString(tr("WARNING: matching stopped at the time limit of %1 ms after %2 matches."))
+                           .arg(_maxMsecs).arg(matches));
+    }
+}
+
+bool MatchWorker::isFlushDue() const
+{
+    return _pendingSpans.size() >= FLUSH_MAX_SPANS ||
+           _timer.elapsed() - _lastFlush >= FLUSH_INTERVAL_MS;
+}
+
+void MatchWorker::flushResults(bool force)
+{
+    if (!force && isCanceled())
+    {
+        return;
+    }
+    _lastFlush = _timer.elapsed();
+    if (!_pendingRows.isEmpty())
+    {
+        emit resultsReady(_pendingRows);
+        _pendingRows.clear();
+    }
+    if (!_pendingSpans.isEmpty())
+    {
+        if (_exporter.isNull())
+        {
+            emit matchesReady(_pendingSpans);
+        }
+        else
+        {
+            _exporter->enqueue(_pendingSpans);
+        }
+        _pendingSpans.clear();
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef MATCHWORKER_H
+#define MATCHWORKER_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaType>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include "regexpcontroller.h"
+#include "mappedtestee.h"
+#include "matchexporter.h"
+#include "benchmark.h"
+#include "patternprofiler.h"
+
+typedef QPair<QString, QString> MatchResultRow;
+typedef QList<MatchResultRow> MatchResultRows;
+
+Q_DECLARE_METATYPE(MatchResultRows)
+
+/*
+ * Runs exactMatch/indexIn on a private copy of the controller state so a
+ * slow pattern never blocks the GUI thread. A single QRegExp call can't be
+ * interrupted, so cancel() only takes effect between two matches; a worker
+ * stuck in one call is simply abandoned by its owner and deletes itself
+ * when it finally returns.
+ *
+ * A mapped testee is scanned chunk by chunk. Each chunk is decoded
+ * together with an overlap window taken from the next one, so a match
+ * starting in the chunk may run on into the overlap; matches that reach the
+ * end of the overlap may have been cut short and are counted separately.
+ * A compressed testee is scanned the same way, in the order its chunks
+ * come out of the decoder thread. Its text isn't kept, so its matches are
+ * reported as result rows (up to MAX_STREAMED_ROWS) instead of spans.
+ *
+ * The profile runs indexIn with PatternProfiler over the testee to tell
+ * which capture groups and alternation branches the work goes to, and
+ * times the selected engine on the same text to put a time on each.
+ *
+ * A comparison times the controller against a second one (A against B)
+ * in interleaved benchmark passes, then walks both match lists in step
+ * to find the positions where they differ.
+ *
+ * The growth probe times single indexIn attempts on failing inputs of
+ * growing length. QRegExp doesn't expose its step count, so steps are
+ * estimated from the time per character of the shortest input.
+ *
+ * A live rescan starts from the matches kept before an edit (the head),
+ * scans from the edit on and, once past the limit, adopts the remaining
+ * old matches (the tail, already shifted) as soon as it finds one of them
+ * again, since the text from there on is unchanged.
+ *
+ * The index scans step through the matches with RegExpMatchIterator,
+ * stopping at the limits set with setMatchLimits() (0 means none).
+ *
+ * With an exporter set, the spans go to its I/O thread instead of
+ * matchesReady(), and the exporter is finished when the scan ends.
+ */
+class MatchWorker : public QThread
+{
+    Q_OBJECT
+public:
+    enum Mode
+    {
+        ExactMatch,
+        IndexIn,
+        BenchmarkIndexIn,
+        GrowthProbe,
+        LiveIndexIn,
+        Profile,
+        Compare
+    };
+
+    explicit MatchWorker(const RegExpController &controller, QObject *parent = 0);
+    ~MatchWorker();
+    void setMode(Mode mode);
+    Mode getMode() const;
+    void setTestee(const QString &testee);
+    void setMappedTestee(const MappedTesteePtr &testee, qint64 chunkSize, qint64 overlapSize);
+    void setCompressedTestee(const QString &filename, qint64 chunkSize, qint64 overlapSize);
+    void setParallel(bool parallel);
+    void setBenchmark(int passes, int warmup);
+    void setComparison(const RegExpController &other);
+    void setMatchLimits(int maxMatches, qint64 maxMsecs);
+    void setLiveRange(int from, int limit, const QVector<qint64> &head, const QVector<qint64> &tail);
+    void setExporter(const MatchExporterPtr &exporter);
+    void cancel();
+    bool isCanceled() const;
+
+signals:
+    void resultsReady(const MatchResultRows &rows);
+    void matchesReady(const QVector<qint64> &spans);
+    void progressChanged(qint64 scanned, qint64 total, int matches);
+    void truncatedMatchesFound(int count);
+    void matchingFinished(const QString &engine, qint64 nsecs);
+    void benchmarkFinished(const BenchmarkResult &result);
+    void profileFinished(const PatternProfile &profile);
+    void comparisonFinished(const ComparisonResult &result);
+    void warningRaised(const QString &message);
+    void rescanFinished(int from, int to);
+
+protected:
+    void run();
+
+private:
+    void doExactMatch();
+    void doIndexIn();
+    void doParallelIndexIn();
+    void doMappedIndexIn();
+    void doCompressedIndexIn();
+    void doBenchmark();
+    void doGrowthProbe();
+    void doProfile();
+    void doCompare();
+    void compareMatches(ComparisonResult &result);
+    void doLiveIndexIn();
+    bool applyLimits(RegExpMatchIterator &it, int matches) const;
+    void warnLimited(int matches);
+    bool isFlushDue() const;
+    void flushResults(bool force);
+
+    RegExpController *_regexp;
+    RegExpController *_other;
+    Mode _mode;
+    QString _testee;
+    MappedTesteePtr _mappedTestee;
+    QString _compressedTestee;
+    qint64 _chunkSize;
+    qint64 _overlapSize;
+    bool _parallel;
+    int _benchmarkPasses;
+    int _benchmarkWarmup;
+    int _liveFrom;
+    int _liveLimit;
+    QVector<qint64> _liveHead;
+    QVector<qint64> _liveTail;
+    int _maxMatches;
+    qint64 _maxMsecs;
+    MatchExporterPtr _exporter;
+    QAtomicInt _canceled;
+    MatchResultRows _pendingRows;
+    QVector<qint64> _pendingSpans;
+    QElapsedTimer _timer;
+    qint64 _lastFlush;
+};
+
+#endif // MATCHWORKER_H
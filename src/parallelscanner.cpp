@@ -0,0 +1,287 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QThread>
+#include <QtConcurrentMap>
+#include "parallelscanner.h"
+#include "patternparser.h"
+#include "prefilter.h"
+
+// Slices per thread, so uneven lines still keep every core busy.
+#define SLICES_PER_THREAD 4
+#define MIN_SLICE_LENGTH (64 * 1024)
+
+namespace
+{
+
+// Cuts out what a search for matches starting in [from, end) has to see.
+QString scanWindow(const QString &testee, int from, int end, int maxLength, int &windowStart)
+{
+    windowStart = qMax(from - Prefilter::windowPadding(0), 0);
+    int windowEnd = int(qMin(qint64(testee.length()), qint64(end) + Prefilter::windowPadding(maxLength)));
+    return testee.mid(windowStart, windowEnd - windowStart);
+}
+
+// A window's first character is no testee start for '^'.
+QRegExp::CaretMode windowCaretMode(QRegExp::CaretMode caretMode, int windowStart)
+{
+    return (windowStart > 0 && caretMode == QRegExp::CaretAtZero) ? QRegExp::CaretWontMatch : caretMode;
+}
+
+// Moves the match positions appended after from back into the testee.
+void shiftSpans(QVector<qint64> &spans, int from, int offset)
+{
+    for (int i = from; i < spans.size(); i += 2)
+    {
+        if (spans.at(i) >= 0)
+        {
+            spans[i] += offset;
+        }
+    }
+}
+
+struct SliceScanner
+{
+    typedef QVector<qint64> result_type;
+
+    SliceScanner(const QVector<RegExpController *> &clones, const QString &testee, int maxLength,
+                 int maxMatches, QAtomicInt *canceled, QAtomicInt *scanned) :
+        _clones(clones), _testee(testee), _maxLength(maxLength), _maxMatches(maxMatches),
+        _canceled(canceled), _scanned(scanned)
+    {
+    }
+
+    QVector<qint64> operator()(const ScanSlice &slice) const
+    {
+        QVector<qint64> spans;
+        RegExpController *regexp = _clones.at(slice.index);
+        int windowStart;
+        QString window = scanWindow(_testee, slice.start, slice.end, _maxLength, windowStart);
+        RegExpMatchIterator it(*regexp, window, slice.start - windowStart);
+        it.setCaretMode(windowCaretMode(regexp->getCaretMode(), windowStart));
+        it.setMaxMatches(_maxMatches);
+
+        while (_canceled->loadAcquire() == 0 && it.next() && it.pos() + windowStart < slice.end)
+        {
+            regexp->appendSpans(spans);
+        }
+        shiftSpans(spans, 0, windowStart);
+        _scanned->fetchAndAddRelaxed(qMin(slice.end, _testee.length()) - slice.start);
+        return spans;
+    }
+
+    QVector<RegExpController *> _clones;
+    QString _testee;
+    int _maxLength;
+    int _maxMatches;
+    QAtomicInt *_canceled;
+    QAtomicInt *_scanned;
+};
+
+}
+
+ParallelScanner::ParallelScanner(const RegExpController &controller) :
+    _regexp(new RegExpController()),
+    _canceled(0),
+    _scanned(0),
+    _captureCount(0),
+    _maxMatchLength(-1),
+    _maxMatches(0)
+{
+    _regexp->copyFrom(controller);
+    _captureCount = _regexp->captureCount();
+    PatternParser parser(_regexp->getRegExp());
+    // A slice ends right after a line break, which a line-bound match
+    // can't read, so the window needs no more than the assertion context.
+    _maxMatchLength = parser.isLineBound() ? 0 : parser.maxMatchLength();
+}
+
+ParallelScanner::~ParallelScanner()
+{
+    cancel();
+    _future.waitForFinished();
+    qDeleteAll(_clones);
+    delete _regexp;
+}
+
+bool ParallelScanner::isSupported(const RegExpController &controller)
+{
+    // With CaretAtOffset a slice start would become a valid '^' position;
+    // without a longest match or a line break to stop at, a slice can't be
+    // cut to a window.
+    PatternParser parser(controller.getRegExp());
+    return controller.getCaretMode() != QRegExp::CaretAtOffset
+            && (parser.maxMatchLength() >= 0 || parser.isLineBound());
+}
+
+void ParallelScanner::setTestee(const QString &testee)
+{
+    _testee = testee;
+}
+
+// 0 keeps every match.
+void ParallelScanner::setMaxMatches(int maxMatches)
+{
+    _maxMatches = qMax(maxMatches, 0);
+}
+
+void ParallelScanner::start(int sliceCount)
+{
+    if (sliceCount <= 0)
+    {
+        sliceCount = QThread::idealThreadCount() * SLICES_PER_THREAD;
+    }
+    splitTestee(sliceCount);
+
+    qDeleteAll(_clones);
+    _clones.clear();
+    for (int i = 0; i < _slices.size(); ++i)
+    {
+        RegExpController *clone = new RegExpController();
+        clone->copyFrom(*_regexp);
+        _clones << clone;
+    }
+
+    _canceled.storeRelease(0);
+    _scanned.storeRelease(0);
+    _future = QtConcurrent::mapped(_slices, SliceScanner(_clones, _testee, _maxMatchLength, _maxMatches, &_canceled, &_scanned));
+}
+
+void ParallelScanner::cancel()
+{
+    _canceled.storeRelease(1);
+}
+
+bool ParallelScanner::isFinished() const
+{
+    return _future.isFinished();
+}
+
+qint64 ParallelScanner::scannedLength() const
+{
+    return _scanned.loadAcquire();
+}
+
+QVector<qint64> ParallelScanner::result()
+{
+    _future.waitForFinished();
+
+    QVector<qint64> merged;
+    int stride = 2 * (_captureCount + 1);
+    qint64 nextPos = 0;
+
+    for (int k = 0; k < _slices.size() && _canceled.loadAcquire() == 0 && !isFull(merged); ++k)
+    {
+        const ScanSlice &slice = _slices.at(k);
+        QVector<qint64> spans = _future.resultAt(k);
+        int count = spans.size() / stride;
+        int first = 0;
+
+        // The previous match ran into this slice: rescan sequentially
+        // until we land on a match this slice found as well.
+        if (nextPos > slice.start && !scanOn(slice, spans, first, nextPos, merged))
+        {
+            continue;
+        }
+
+        if (first < count)
+        {
+            merged += spans.mid(first * stride);
+            qint64 lastPos = spans.at((count - 1) * stride);
+            qint64 lastLength = spans.at((count - 1) * stride + 1);
+            nextPos = lastLength > 0 ? lastPos + lastLength : RegExpMatchIterator::nextCodePoint(_testee, int(lastPos));
+        }
+
+        // A slice that stopped at the match limit left the rest of itself
+        // unsearched.
+        if (_maxMatches > 0 && count >= _maxMatches && !isFull(merged))
+        {
+            int none = 0;
+            scanOn(slice, QVector<qint64>(), none, nextPos, merged);
+        }
+    }
+
+    if (_canceled.loadAcquire() != 0)
+    {
+        merged.clear();
+    }
+    else if (isFull(merged))
+    {
+        merged.resize(_maxMatches * stride);
+    }
+    return merged;
+}
+
+/*
+ * Appends the matches from nextPos on that start in the slice until one
+ * of them is spans[first], or later ones, or the match limit is reached;
+ * true when it met such a match, which first then points to.
+ */
+bool ParallelScanner::scanOn(const ScanSlice &slice, const QVector<qint64> &spans, int &first, qint64 &nextPos,
+                             QVector<qint64> &merged) const
+{
+    int stride = 2 * (_captureCount + 1);
+    int count = spans.size() / stride;
+    int windowStart;
+    QString window = scanWindow(_testee, int(nextPos), slice.end, _maxMatchLength, windowStart);
+    RegExpMatchIterator it(*_regexp, window, int(nextPos) - windowStart);
+    it.setCaretMode(windowCaretMode(_regexp->getCaretMode(), windowStart));
+    while (!isFull(merged) && it.next() && it.pos() + windowStart < slice.end)
+    {
+        int pos = it.pos() + windowStart;
+        int len = it.matchedLength();
+        while (first < count && spans.at(first * stride) < pos)
+        {
+            first ++;
+        }
+        if (first < count && spans.at(first * stride) == pos && spans.at(first * stride + 1) == len)
+        {
+            return true;
+        }
+        int appended = merged.size();
+        _regexp->appendSpans(merged);
+        shiftSpans(merged, appended, windowStart);
+        nextPos = it.nextFrom() + windowStart;
+    }
+    return false;
+}
+
+bool ParallelScanner::isFull(const QVector<qint64> &merged) const
+{
+    return _maxMatches > 0 && merged.size() >= qint64(_maxMatches) * 2 * (_captureCount + 1);
+}
+
+void ParallelScanner::splitTestee(int sliceCount)
+{
+    _slices.clear();
+
+    int length = _testee.length();
+    int step = qMax(length / qMax(sliceCount, 1), MIN_SLICE_LENGTH);
+    int start = 0;
+    while (start < length)
+    {
+        // Cut right after a line break so records stay whole.
+        int end = (length - start > step) ? _testee.indexOf(QChar('\n'), start + step) : -1;
+        end = (end == -1) ? length : end + 1;
+
+        ScanSlice slice;
+        slice.index = _slices.size();
+        slice.start = start;
+        slice.end = end;
+        _slices << slice;
+        start = end;
+    }
+
+    // The last slice also owns the position right after the testee, where
+    // a pattern that accepts the empty string still matches.
+    if (_slices.isEmpty())
+    {
+        ScanSlice slice;
+        slice.index = 0;
+        slice.start = 0;
+        slice.end = 0;
+        _slices << slice;
+    }
+    _slices.last().end = length + 1;
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PARALLELSCANNER_H
+#define PARALLELSCANNER_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QString>
+#include <QVector>
+#include "regexpcontroller.h"
+
+struct ScanSlice
+{
+    int index;
+    int start;
+    int end;
+};
+
+/*
+ * Splits the testee into line-aligned slices and runs indexIn over them
+ * on the global thread pool, one RegExpController clone per slice. Every
+ * slice searches only a window of the testee: the slice plus the longest
+ * reach of a match starting in it (PatternParser::maxMatchLength()), so
+ * no search runs on through the rest of the testee. A pattern that can't
+ * read a line break (PatternParser::isLineBound()) needs no such bound,
+ * its matches end with their line; other unbounded patterns aren't
+ * supported. Results are exactly those of a sequential scan once merged:
+ * where the last match of one slice runs into the next, the merge rescans
+ * until it meets a match the next slice also found.
+ *
+ * setMaxMatches() keeps the result to the first matches of the testee:
+ * every slice stops after that many, and the merge goes on sequentially
+ * where a slice stopped early but the limit isn't reached yet.
+ */
+class ParallelScanner
+{
+public:
+    explicit ParallelScanner(const RegExpController &controller);
+    ~ParallelScanner();
+    static bool isSupported(const RegExpController &controller);
+    void setTestee(const QString &testee);
+    void setMaxMatches(int maxMatches);
+    void start(int sliceCount = 0);
+    void cancel();
+    bool isFinished() const;
+    qint64 scannedLength() const;
+    QVector<qint64> result();
+
+private:
+    Q_DISABLE_COPY(ParallelScanner)
+
+    void splitTestee(int sliceCount);
+    bool scanOn(const ScanSlice &slice, const QVector<qint64> &spans, int &first, qint64 &nextPos,
+                QVector<qint64> &merged) const;
+    bool isFull(const QVector<qint64> &merged) const;
+
+    RegExpController *_regexp;
+    QString _testee;
+    QVector<ScanSlice> _slices;
+    QVector<RegExpController *> _clones;
+    QFuture<QVector<qint64> > _future;
+    QAtomicInt _canceled;
+    QAtomicInt _scanned;
+    int _captureCount;
+    int _maxMatchLength;
+    int _maxMatches;
+};
+
+#endif // PARALLELSCANNER_H
@@ -0,0 +1,306 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "patternanalyzer.h"
+
+PatternAnalyzer::PatternAnalyzer(const RegExpController &regexp) :
+    _parser(regexp.getRegExp()),
+    _hotspot(NULL),
+    _exponential(false)
+{
+    if (_parser.isValid())
+    {
+        analyze(_parser.root());
+    }
+}
+
+bool PatternAnalyzer::isParsed() const
+{
+    return _parser.isValid();
+}
+
+QStringList PatternAnalyzer::warnings() const
+{
+    return _warnings;
+}
+
+QString PatternAnalyzer::probeInput(int pumpCount) const
+{
+    const PatternNode *root = _parser.root();
+    if (root == NULL)
+    {
+        return QString(pumpCount, QChar('a'));
+    }
+
+    const PatternNode *hotspot = _hotspot;
+    if (hotspot == NULL)
+    {
+        hotspot = findUnboundedRepeat(root);
+    }
+    if (hotspot == NULL)
+    {
+        hotspot = root;
+    }
+
+    // Whatever has to precede the hotspot for the engine to reach it.
+    QString prefix;
+    QList<const PatternNode *> path;
+    findPath(root, hotspot, path);
+    for (int i = 0; i + 1 < path.size(); ++i)
+    {
+        const PatternNode *node = path.at(i);
+        if (node->type != PatternNode::Sequence)
+        {
+            continue;
+        }
+        int next = node->children.indexOf(const_cast<PatternNode *>(path.at(i + 1)));
+        for (int j = 0; j < next; ++j)
+        {
+            prefix += sample(node->children.at(j));
+        }
+    }
+
+    const PatternNode *body = (hotspot->type == PatternNode::Repeat) ? hotspot->children.first() : hotspot;
+    QList<CharSet> firstSets;
+    collectFirstSets(body, firstSets);
+    QString pump = sample(body);
+    if (pump.isEmpty())
+    {
+        pump = QChar(firstSets.isEmpty() ? ushort('a') : firstSets.first().sampleChar());
+    }
+    QChar suffix(firstSets.isEmpty() ? ushort('!') : firstSets.first().sampleOutsideChar());
+
+    return prefix + pump.repeated(pumpCount) + suffix;
+}
+
+void PatternAnalyzer::analyze(const PatternNode *node)
+{
+    if (node->isUnbounded())
+    {
+        checkNestedRepeat(node);
+        checkOverlappingAlternation(node);
+    }
+    else if (node->type == PatternNode::Sequence)
+    {
+        checkAdjacentRepeats(node);
+    }
+
+    foreach (const PatternNode *child, node->children)
+    {
+        analyze(child);
+    }
+}
+
+void PatternAnalyzer::checkNestedRepeat(const PatternNode *repeat)
+{
+    const PatternNode *body = repeat->children.first();
+    const PatternNode *inner = findUnboundedRepeat(body);
+    if (inner == NULL && !body->isNullable())
+    {
+        return;
+    }
+
+    setHotspot(repeat, true);
+    QString pattern = _parser.pattern();
+    if (inner != NULL)
+    {
+        addWarning(repeat, QString(tr("nested quantifier \"%1\" inside \"%2\" can backtrack exponentially."))
+                   .arg(pattern.mid(inner->begin, inner->end - inner->begin))
+                   .arg(pattern.mid(repeat->begin, repeat->end - repeat->begin)));
+    }
+    else
+    {
+        addWarning(repeat, QString(tr("quantified \"%1\" can match the empty string and backtrack exponentially."))
+                   .arg(pattern.mid(repeat->begin, repeat->end - repeat->begin)));
+    }
+}
+
+void PatternAnalyzer::checkOverlappingAlternation(const PatternNode *repeat)
+{
+    const PatternNode *body = repeat->children.first();
+    while (body->type == PatternNode::Group)
+    {
+        body = body->children.first();
+    }
+    if (body->type != PatternNode::Alternation)
+    {
+        return;
+    }
+
+    QList<QList<CharSet> > branchSets;
+    foreach (const PatternNode *branch, body->children)
+    {
+        QList<CharSet> sets;
+        collectFirstSets(branch, sets);
+        branchSets << sets;
+    }
+    for (int i = 0; i < branchSets.size(); ++i)
+    {
+        for (int j = i + 1; j < branchSets.size(); ++j)
+        {
+            if (!overlaps(branchSets.at(i), branchSets.at(j)))
+            {
+                continue;
+            }
+            setHotspot(repeat, true);
+            QString pattern = _parser.pattern();
+            const PatternNode *a = body->children.at(i);
+            const PatternNode *b = body->children.at(j);
+            addWarning(repeat, QString(tr("alternatives \"%1\" and \"%2\" under a quantifier can start with the same character and backtrack exponentially."))
+                       .arg(pattern.mid(a->begin, a->end - a->begin))
+                       .arg(pattern.mid(b->begin, b->end - b->begin)));
+            return;
+        }
+    }
+}
+
+void PatternAnalyzer::checkAdjacentRepeats(const PatternNode *sequence)
+{
+    for (int i = 0; i + 1 < sequence->children.size(); ++i)
+    {
+        const PatternNode *a = sequence->children.at(i);
+        const PatternNode *b = sequence->children.at(i + 1);
+        if (!a->isUnbounded() || !b->isUnbounded())
+        {
+            continue;
+        }
+
+        QList<CharSet> setsA;
+        QList<CharSet> setsB;
+        collectFirstSets(a->children.first(), setsA);
+        collectFirstSets(b->children.first(), setsB);
+        if (!overlaps(setsA, setsB))
+        {
+            continue;
+        }
+        setHotspot(a, false);
+        QString pattern = _parser.pattern();
+        addWarning(a, QString(tr("adjacent quantifiers \"%1\" and \"%2\" overlap, a failing match can take polynomial time."))
+                   .arg(pattern.mid(a->begin, a->end - a->begin))
+                   .arg(pattern.mid(b->begin, b->end - b->begin)));
+    }
+}
+
+void PatternAnalyzer::setHotspot(const PatternNode *repeat, bool exponential)
+{
+    // The probe pumps the first exponential finding, else the first one.
+    if (_hotspot == NULL || (exponential && !_exponential))
+    {
+        _hotspot = repeat;
+        _exponential = exponential;
+    }
+}
+
+void PatternAnalyzer::addWarning(const PatternNode *node, const QString &message)
+{
+    _warnings << QString(tr("WARNING: at column %1, %2")).arg(node->begin + 1).arg(message);
+}
+
+const PatternNode *PatternAnalyzer::findUnboundedRepeat(const PatternNode *node) const
+{
+    if (node->isUnbounded())
+    {
+        return node;
+    }
+    foreach (const PatternNode *child, node->children)
+    {
+        const PatternNode *found = findUnboundedRepeat(child);
+        if (found != NULL)
+        {
+            return found;
+        }
+    }
+    return NULL;
+}
+
+bool PatternAnalyzer::findPath(const PatternNode *node, const PatternNode *target,
+                               QList<const PatternNode *> &path) const
+{
+    path << node;
+    if (node == target)
+    {
+        return true;
+    }
+    foreach (const PatternNode *child, node->children)
+    {
+        if (findPath(child, target, path))
+        {
+            return true;
+        }
+    }
+    path.removeLast();
+    return false;
+}
+
+void PatternAnalyzer::collectFirstSets(const PatternNode *node, QList<CharSet> &sets)
+{
+    switch (node->type)
+    {
+    case PatternNode::Set:
+        sets << node->set;
+        break;
+    case PatternNode::Sequence:
+        foreach (const PatternNode *child, node->children)
+        {
+            collectFirstSets(child, sets);
+            if (!child->isNullable())
+            {
+                break;
+            }
+        }
+        break;
+    case PatternNode::Alternation:
+    case PatternNode::Group:
+    case PatternNode::Repeat:
+        foreach (const PatternNode *child, node->children)
+        {
+            collectFirstSets(child, sets);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+bool PatternAnalyzer::overlaps(const QList<CharSet> &a, const QList<CharSet> &b)
+{
+    foreach (const CharSet &setA, a)
+    {
+        foreach (const CharSet &setB, b)
+        {
+            if (setA.intersects(setB))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+QString PatternAnalyzer::sample(const PatternNode *node)
+{
+    QString text;
+    switch (node->type)
+    {
+    case PatternNode::Set:
+        text = QChar(node->set.sampleChar());
+        break;
+    case PatternNode::Sequence:
+        foreach (const PatternNode *child, node->children)
+        {
+            text += sample(child);
+        }
+        break;
+    case PatternNode::Alternation:
+    case PatternNode::Group:
+        text = sample(node->children.first());
+        break;
+    case PatternNode::Repeat:
+        text = sample(node->children.first()).repeated(node->min);
+        break;
+    default:
+        break;
+    }
+    return text;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNANALYZER_H
+#define PATTERNANALYZER_H
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "patternparser.h"
+#include "regexpcontroller.h"
+
+/*
+ * Looks for pattern shapes that make a backtracking engine go super-linear:
+ * nested unbounded quantifiers such as "(a+)+", quantified alternations
+ * whose branches can start with the same character such as "(a|ab)*", and
+ * adjacent unbounded quantifiers over overlapping sets such as "\d+\d+".
+ *
+ * It also builds the input for the growth probe: a string that pumps the
+ * riskiest repeat and then fails, which is where backtracking explodes.
+ */
+class PatternAnalyzer
+{
+    Q_DECLARE_TR_FUNCTIONS(PatternAnalyzer)
+public:
+    explicit PatternAnalyzer(const RegExpController &regexp);
+    bool isParsed() const;
+    QStringList warnings() const;
+    QString probeInput(int pumpCount) const;
+
+private:
+    void analyze(const PatternNode *node);
+    void checkNestedRepeat(const PatternNode *repeat);
+    void checkOverlappingAlternation(const PatternNode *repeat);
+    void checkAdjacentRepeats(const PatternNode *sequence);
+    void setHotspot(const PatternNode *repeat, bool exponential);
+    void addWarning(const PatternNode *node, const QString &message);
+    const PatternNode *findUnboundedRepeat(const PatternNode *node) const;
+    bool findPath(const PatternNode *node, const PatternNode *target,
+                  QList<const PatternNode *> &path) const;
+    static void collectFirstSets(const PatternNode *node, QList<CharSet> &sets);
+    static bool overlaps(const QList<CharSet> &a, const QList<CharSet> &b);
+    static QString sample(const PatternNode *node);
+
+    PatternParser _parser;
+    QStringList _warnings;
+    const PatternNode *_hotspot;
+    bool _exponential;
+};
+
+#endif // PATTERNANALYZER_H
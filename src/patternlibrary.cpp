@@ -0,0 +1,347 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <cstring>
+#include "patternlibrary.h"
+#include "prefilter.h"
+
+#define LIBRARY_MAGIC "QRXL"
+#define LIBRARY_VERSION 1
+// Written as a number, read back in another byte order it won't match.
+#define LIBRARY_BYTE_ORDER 0x01020304u
+// Magic, version, byte order mark and pattern count.
+#define LIBRARY_HEADER_BYTES 16
+#define PATTERN_SYNTAX_COUNT 6
+#define CARET_MODE_COUNT 3
+
+namespace
+{
+
+enum RecordFlag
+{
+    CaseSensitive = 0x01,
+    Minimal = 0x02,
+    TestExactMatch = 0x04,
+    Windowed = 0x08
+};
+
+void writeU32(QByteArray &out, quint32 value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void writeI32(QByteArray &out, qint32 value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void writeDouble(QByteArray &out, double value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void writeString(QByteArray &out, const QString &value)
+{
+    writeU32(out, quint32(value.length()));
+    out.append(reinterpret_cast<const char *>(value.constData()), value.length() * int(sizeof(QChar)));
+    if (value.length() % 2 != 0)
+    {
+        out.append(char(0)).append(char(0));
+    }
+}
+
+/*
+ * Bounds-checked reads from the mapped file; after a read past the end
+ * every further read fails too and isOk() turns false.
+ */
+class RecordReader
+{
+public:
+    RecordReader(const uchar *data, qint64 size, qint64 pos) :
+        _data(data), _size(size), _pos(pos), _ok(pos >= 0 && pos <= size)
+    {
+    }
+
+    bool isOk() const
+    {
+        return _ok;
+    }
+
+    quint32 readU32()
+    {
+        quint32 value = 0;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    qint32 readI32()
+    {
+        qint32 value = 0;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    double readDouble()
+    {
+        double value = 0.0;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    QString readString()
+    {
+        quint32 length = readU32();
+        qint64 bytes = qint64(length) * qint64(sizeof(QChar));
+        if (!_ok || bytes > _size - _pos)
+        {
+            _ok = false;
+            return QString();
+        }
+        QString value(int(length), Qt::Uninitialized);
+        memcpy(value.data(), _data + _pos, size_t(bytes));
+        _pos += (bytes + 3) & ~qint64(3);
+        _ok = _pos <= _size;
+        return value;
+    }
+
+private:
+    void read(void *value, qint64 bytes)
+    {
+        if (!_ok || bytes > _size - _pos)
+        {
+            _ok = false;
+            return;
+        }
+        memcpy(value, _data + _pos, size_t(bytes));
+        _pos += bytes;
+    }
+
+    const uchar *_data;
+    qint64 _size;
+    qint64 _pos;
+    bool _ok;
+};
+
+}
+
+PatternLibrary::PatternLibrary() :
+    _data(NULL),
+    _size(0),
+    _count(0)
+{
+}
+
+PatternLibrary::~PatternLibrary()
+{
+    close();
+}
+
+bool PatternLibrary::isLibrary(const QString &filename)
+{
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) && file.read(4) == LIBRARY_MAGIC;
+}
+
+bool PatternLibrary::write(const QString &filename, const QList<RegExpController *> &patterns, QString &error)
+{
+    QByteArray out;
+    out.append(LIBRARY_MAGIC);
+    writeU32(out, LIBRARY_VERSION);
+    writeU32(out, LIBRARY_BYTE_ORDER);
+    writeU32(out, quint32(patterns.size()));
+
+    // The offset table is filled in as the records are appended.
+    int table = out.size();
+    out.append(QByteArray(patterns.size() * int(sizeof(quint64)), char(0)));
+    for (int i = 0; i < patterns.size(); ++i)
+    {
+        quint64 offset = quint64(out.size());
+        memcpy(out.data() + table + i * int(sizeof(quint64)), &offset, sizeof(offset));
+        writeRecord(out, *patterns.at(i));
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(out) != out.size())
+    {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool PatternLibrary::open(const QString &filename)
+{
+    close();
+    _error.clear();
+
+    _file.setFileName(filename);
+    if (!_file.open(QIODevice::ReadOnly))
+    {
+        _error = _file.errorString();
+        return false;
+    }
+    _size = _file.size();
+    _data = (_size >= LIBRARY_HEADER_BYTES) ? _file.map(0, _size) : NULL;
+    if (_data == NULL)
+    {
+        _error = _size < LIBRARY_HEADER_BYTES ? tr("not a pattern library") : _file.errorString();
+        close();
+        return false;
+    }
+
+    RecordReader header(_data, _size, 4);
+    quint32 version = header.readU32();
+    quint32 byteOrder = header.readU32();
+    quint32 count = header.readU32();
+    if (memcmp(_data, LIBRARY_MAGIC, 4) != 0)
+    {
+        _error = tr("not a pattern library");
+    }
+    else if (byteOrder != LIBRARY_BYTE_ORDER)
+    {
+        _error = tr("the pattern library was written with another byte order");
+    }
+    else if (version != LIBRARY_VERSION)
+    {
+        _error = QString(tr("unsupported pattern library version %1")).arg(version);
+    }
+    else if (qint64(count) * qint64(sizeof(quint64)) > _size - LIBRARY_HEADER_BYTES)
+    {
+        _error = tr("the pattern library is truncated");
+    }
+    if (!_error.isEmpty())
+    {
+        close();
+        return false;
+    }
+    _count = int(count);
+    return true;
+}
+
+void PatternLibrary::close()
+{
+    if (_data != NULL)
+    {
+        _file.unmap(const_cast<uchar *>(_data));
+    }
+    _file.close();
+    _data = NULL;
+    _size = 0;
+    _count = 0;
+}
+
+int PatternLibrary::count() const
+{
+    return _count;
+}
+
+/*
+ * Sets regexp up as the index-th pattern of the library, together with the
+ * prefilter analysed when the library was written.
+ */
+bool PatternLibrary::load(int index, RegExpController &regexp) const
+{
+    if (index < 0 || index >= _count)
+    {
+        _error = QString(tr("no pattern #%1 in the library")).arg(index + 1);
+        return false;
+    }
+
+    quint64 offset;
+    memcpy(&offset, _data + LIBRARY_HEADER_BYTES + index * int(sizeof(quint64)), sizeof(offset));
+    RecordReader reader(_data, _size, qint64(qMin(offset, quint64(_size) + 1)));
+    quint32 flags = reader.readU32();
+    quint32 patternSyntax = reader.readU32();
+    quint32 caretMode = reader.readU32();
+    quint32 engine = reader.readU32();
+    double latencyBudget = reader.readDouble();
+    QString name = reader.readString();
+    QString pattern = reader.readString();
+    qint32 maxLiteralOffset = reader.readI32();
+    qint32 maxMatchLength = reader.readI32();
+    QStringList literals;
+    for (quint32 i = reader.readU32(); reader.isOk() && i > 0; --i)
+    {
+        literals << reader.readString();
+    }
+    QList<RegExpTestCase> testCases;
+    for (quint32 i = reader.readU32(); reader.isOk() && i > 0; --i)
+    {
+        RegExpTestCase testCase;
+        testCase.mustMatch = (reader.readU32() != 0);
+        testCase.text = reader.readString();
+        for (quint32 j = reader.readU32(); reader.isOk() && j > 0; --j)
+        {
+            int capture = int(reader.readU32());
+            testCase.captures.insert(capture, reader.readString());
+        }
+        testCases << testCase;
+    }
+
+    if (!reader.isOk() || patternSyntax >= PATTERN_SYNTAX_COUNT || caretMode >= CARET_MODE_COUNT ||
+        engine >= quint32(RegExpEngine::typeNames().size()))
+    {
+        _error = QString(tr("pattern #%1 of the library is corrupt")).arg(index + 1);
+        return false;
+    }
+
+    regexp.setName(name);
+    regexp.setPattern(pattern);
+    regexp.setPatternSyntax(QRegExp::PatternSyntax(patternSyntax));
+    regexp.setCaretMode(QRegExp::CaretMode(caretMode));
+    regexp.setCaseSensitive((flags & CaseSensitive) ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    regexp.setMinimal((flags & Minimal) != 0);
+    regexp.setEngine(RegExpEngine::Type(engine));
+    regexp.setTestCases(testCases);
+    regexp.setTestExactMatch((flags & TestExactMatch) != 0);
+    regexp.setLatencyBudget(latencyBudget);
+    regexp.setPrefilter(new Prefilter(regexp, literals, maxLiteralOffset, maxMatchLength, (flags & Windowed) != 0));
+    return true;
+}
+
+QString PatternLibrary::getError() const
+{
+    return _error;
+}
+
+void PatternLibrary::writeRecord(QByteArray &out, RegExpController &regexp)
+{
+    const QRegExp &options = regexp.getRegExp();
+    const Prefilter *prefilter = regexp.prefilter();
+    QStringList literals = prefilter->isUsable() ? prefilter->literals() : QStringList();
+
+    quint32 flags = 0;
+    flags |= (options.caseSensitivity() == Qt::CaseSensitive) ? CaseSensitive : 0;
+    flags |= options.isMinimal() ? Minimal : 0;
+    flags |= regexp.isTestExactMatch() ? TestExactMatch : 0;
+    flags |= prefilter->isWindowed() ? Windowed : 0;
+    writeU32(out, flags);
+    writeU32(out, quint32(options.patternSyntax()));
+    writeU32(out, quint32(regexp.getCaretMode()));
+    writeU32(out, quint32(regexp.getEngine()));
+    writeDouble(out, regexp.getLatencyBudget());
+    writeString(out, regexp.getName());
+    writeString(out, options.pattern());
+    writeI32(out, prefilter->maxLiteralOffset());
+    writeI32(out, prefilter->maxMatchLength());
+    writeU32(out, quint32(literals.size()));
+    foreach (const QString &literal, literals)
+    {
+        writeString(out, literal);
+    }
+    writeU32(out, quint32(regexp.getTestCases().size()));
+    foreach (const RegExpTestCase &testCase, regexp.getTestCases())
+    {
+        writeU32(out, testCase.mustMatch ? 1 : 0);
+        writeString(out, testCase.text);
+        writeU32(out, quint32(testCase.captures.size()));
+        QMapIterator<int, QString> it(testCase.captures);
+        while (it.hasNext())
+        {
+            it.next();
+            writeU32(out, quint32(it.key()));
+            writeString(out, it.value());
+        }
+    }
+}
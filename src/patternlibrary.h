@@ -0,0 +1,53 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNLIBRARY_H
+#define PATTERNLIBRARY_H
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include "regexpcontroller.h"
+
+/*
+ * A precompiled pattern library: any number of patterns with their
+ * options, test cases and prefilter analysis in one binary file. The file
+ * is mapped into memory and a pattern is decoded from it only when
+ * load() asks for it, through an offset table, so opening even a large
+ * library costs one mmap and nothing is parsed twice.
+ *
+ * All numbers are in host byte order; a library written on a machine of
+ * the other endianness is rejected rather than converted. Strings are
+ * stored as UTF-16 code units, each padded to four bytes.
+ */
+class PatternLibrary
+{
+    Q_DECLARE_TR_FUNCTIONS(PatternLibrary)
+public:
+    PatternLibrary();
+    ~PatternLibrary();
+    static bool isLibrary(const QString &filename);
+    static bool write(const QString &filename, const QList<RegExpController *> &patterns, QString &error);
+    bool open(const QString &filename);
+    void close();
+    int count() const;
+    bool load(int index, RegExpController &regexp) const;
+    QString getError() const;
+
+private:
+    Q_DISABLE_COPY(PatternLibrary)
+
+    static void writeRecord(QByteArray &out, RegExpController &regexp);
+
+    QFile _file;
+    const uchar *_data;
+    qint64 _size;
+    int _count;
+    mutable QString _error;
+};
+
+#endif // PATTERNLIBRARY_H
@@ -0,0 +1,641 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "patternparser.h"
+#include "regexpengine.h"
+
+// Upper bound accepted for {n,m} counts, as in QRegExp.
+#define MAX_REPEAT_COUNT 1000
+// Longer reaches are treated as unbounded.
+#define MAX_BOUNDED_REACH (1024 * 1024)
+
+PatternNode::PatternNode(PatternNode::Type type, int begin) :
+    type(type),
+    begin(begin),
+    end(begin),
+    min(1),
+    max(1),
+    greedy(true),
+    index(0)
+{
+}
+
+PatternNode::~PatternNode()
+{
+    qDeleteAll(children);
+}
+
+bool PatternNode::isNullable() const
+{
+    switch (type)
+    {
+    case Set:
+        return false;
+    case Sequence:
+        foreach (const PatternNode *child, children)
+        {
+            if (!child->isNullable())
+            {
+                return false;
+            }
+        }
+        return true;
+    case Alternation:
+        foreach (const PatternNode *child, children)
+        {
+            if (child->isNullable())
+            {
+                return true;
+            }
+        }
+        return false;
+    case Group:
+        return children.first()->isNullable();
+    case Repeat:
+        return min == 0 || children.first()->isNullable();
+    default:
+        // Empty, assertions and back references (the group may be empty).
+        return true;
+    }
+}
+
+bool PatternNode::isUnbounded() const
+{
+    return type == Repeat && max < 0;
+}
+
+bool PatternNode::isVariableLength() const
+{
+    switch (type)
+    {
+    case Repeat:
+        return min != max || children.first()->isVariableLength();
+    case BackReference:
+        return true;
+    case Alternation:
+    case Sequence:
+    case Group:
+        foreach (const PatternNode *child, children)
+        {
+            if (child->isVariableLength())
+            {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+/*
+ * How many characters from where it starts matching the node may read at
+ * most: its longest match plus whatever a lookahead inside looks at.
+ * -1 when that isn't bounded (or is too large to be worth bounding).
+ */
+int PatternNode::maxReach() const
+{
+    qint64 reach = 0;
+    switch (type)
+    {
+    case Set:
+        return 1;
+    case Sequence:
+    case Alternation:
+        foreach (const PatternNode *child, children)
+        {
+            int childReach = child->maxReach();
+            if (childReach < 0)
+            {
+                return -1;
+            }
+            reach = (type == Sequence) ? reach + childReach : qMax(reach, qint64(childReach));
+        }
+        break;
+    case Group:
+    case Lookahead:
+    case NegativeLookahead:
+        reach = children.first()->maxReach();
+        break;
+    case Repeat:
+        reach = children.first()->maxReach();
+        if (reach < 0 || max < 0)
+        {
+            return -1;
+        }
+        reach *= max;
+        break;
+    case BackReference:
+        return -1;
+    default:
+        return 0;
+    }
+    return (reach < 0 || reach > MAX_BOUNDED_REACH) ? -1 : int(reach);
+}
+
+/*
+ * Whether the node, lookaheads included, may read ch from the testee. A
+ * back reference only reads again what its group read.
+ */
+bool PatternNode::readsChar(ushort ch) const
+{
+    if (type == Set)
+    {
+        return set.contains(ch);
+    }
+    foreach (const PatternNode *child, children)
+    {
+        if (child->readsChar(ch))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PatternNode::isAssertion() const
+{
+    return type == LineStart || type == LineEnd || type == WordBoundary ||
+           type == NonWordBoundary || type == Lookahead || type == NegativeLookahead;
+}
+
+PatternParser::PatternParser(const QRegExp &options) :
+    _pattern(RegExpEngine::translatePattern(options)),
+    _pos(0),
+    _caseSensitivity(options.caseSensitivity()),
+    _minimal(options.isMinimal()),
+    _captureCount(0),
+    _errorOffset(-1),
+    _root(NULL)
+{
+    _root = parseAlternation();
+    if (_root != NULL && !atEnd())
+    {
+        setError(tr("unexpected right parenthesis"));
+    }
+    if (!_error.isEmpty())
+    {
+        delete _root;
+        _root = NULL;
+    }
+}
+
+PatternParser::~PatternParser()
+{
+    delete _root;
+}
+
+bool PatternParser::isValid() const
+{
+    return _root != NULL;
+}
+
+QString PatternParser::errorString() const
+{
+    return _error;
+}
+
+int PatternParser::errorOffset() const
+{
+    return _errorOffset;
+}
+
+QString PatternParser::pattern() const
+{
+    return _pattern;
+}
+
+Qt::CaseSensitivity PatternParser::caseSensitivity() const
+{
+    return _caseSensitivity;
+}
+
+int PatternParser::captureCount() const
+{
+    return _captureCount;
+}
+
+const PatternNode *PatternParser::root() const
+{
+    return _root;
+}
+
+/*
+ * Upper bound on the characters a match reads from its start (see
+ * PatternNode::maxReach()); -1 when unbounded or the pattern didn't parse.
+ */
+int PatternParser::maxMatchLength() const
+{
+    return isValid() ? _root->maxReach() : -1;
+}
+
+/*
+ * Whether no match can read a line break, so none runs past the end of
+ * its line; '^', '$' and '\b' only look at one. '.' and complemented
+ * classes do read one.
+ */
+bool PatternParser::isLineBound() const
+{
+    return isValid() && !_root->readsChar('\n');
+}
+
+PatternNode *PatternParser::parseAlternation()
+{
+    int begin = _pos;
+    PatternNode *branch = parseSequence();
+    if (branch == NULL || peek() != '|')
+    {
+        return branch;
+    }
+
+    PatternNode *node = new PatternNode(PatternNode::Alternation, begin);
+    node->children << branch;
+    while (peek() == '|')
+    {
+        ++_pos;
+        branch = parseSequence();
+        if (branch == NULL)
+        {
+            delete node;
+            return NULL;
+        }
+        node->children << branch;
+    }
+    node->end = _pos;
+    return node;
+}
+
+PatternNode *PatternParser::parseSequence()
+{
+    PatternNode *node = new PatternNode(PatternNode::Sequence, _pos);
+    while (!atEnd() && peek() != '|' && peek() != ')')
+    {
+        PatternNode *atom = parseAtom();
+        if (atom == NULL)
+        {
+            delete node;
+            return NULL;
+        }
+
+        int min;
+        int max;
+        if (parseQuantifier(min, max, true))
+        {
+            PatternNode *repeat = new PatternNode(PatternNode::Repeat, atom->begin);
+            repeat->min = min;
+            repeat->max = max;
+            repeat->greedy = !_minimal;
+            if (peek() == '?')
+            {
+                // Lazy suffix; a possessive '+' is treated as greedy.
+                repeat->greedy = false;
+                ++_pos;
+            }
+            else if (peek() == '+')
+            {
+                ++_pos;
+            }
+            repeat->children << atom;
+            repeat->end = _pos;
+            atom = repeat;
+
+            if (parseQuantifier(min, max, false))
+            {
+                node->children << atom;
+                delete node;
+                setError(tr("nothing to repeat"));
+                return NULL;
+            }
+        }
+        node->children << atom;
+    }
+    node->end = _pos;
+
+    if (node->children.size() == 1)
+    {
+        PatternNode *only = node->children.takeFirst();
+        delete node;
+        return only;
+    }
+    if (node->children.isEmpty())
+    {
+        node->type = PatternNode::Empty;
+    }
+    return node;
+}
+
+PatternNode *PatternParser::parseAtom()
+{
+    int begin = _pos;
+    ushort ch = peek();
+    PatternNode *node = NULL;
+
+    switch (ch)
+    {
+    case '(':
+        return parseGroup();
+    case '[':
+        return parseClass();
+    case '\\':
+        return parseEscape();
+    case '*':
+    case '+':
+    case '?':
+        setError(tr("nothing to repeat"));
+        return NULL;
+    case '.':
+        node = new PatternNode(PatternNode::Set, begin);
+        node->set = CharSet::any();
+        break;
+    case '^':
+        node = new PatternNode(PatternNode::LineStart, begin);
+        break;
+    case '$':
+        node = new PatternNode(PatternNode::LineEnd, begin);
+        break;
+    default:
+        node = new PatternNode(PatternNode::Set, begin);
+        node->set = CharSet::single(ch);
+        break;
+    }
+    ++_pos;
+    node->end = _pos;
+    return node;
+}
+
+PatternNode *PatternParser::parseGroup()
+{
+    int begin = _pos;
+    PatternNode::Type type = PatternNode::Group;
+    int index = 0;
+
+    ++_pos;
+    if (peek() == '?')
+    {
+        switch (peek(1))
+        {
+        case ':':
+            break;
+        case '=':
+            type = PatternNode::Lookahead;
+            break;
+        case '!':
+            type = PatternNode::NegativeLookahead;
+            break;
+        default:
+            setError(tr("unsupported group syntax"));
+            return NULL;
+        }
+        _pos += 2;
+    }
+    else
+    {
+        index = ++_captureCount;
+    }
+
+    PatternNode *body = parseAlternation();
+    if (body == NULL)
+    {
+        return NULL;
+    }
+    if (peek() != ')')
+    {
+        delete body;
+        setError(tr("missing right parenthesis"));
+        return NULL;
+    }
+    ++_pos;
+
+    PatternNode *node = new PatternNode(type, begin);
+    node->index = index;
+    node->children << body;
+    node->end = _pos;
+    return node;
+}
+
+PatternNode *PatternParser::parseClass()
+{
+    PatternNode *node = new PatternNode(PatternNode::Set, _pos);
+    ++_pos;
+    if (peek() == '^')
+    {
+        node->set.setNegated(true);
+        ++_pos;
+    }
+
+    bool first = true;
+    while (!atEnd() && (first || peek() != ']'))
+    {
+        first = false;
+        ushort low = peek();
+        ++_pos;
+        if (low == '\\' && !parseClassEscape(node->set, low))
+        {
+            // A class escape such as \d was added to the set directly.
+            continue;
+        }
+
+        if (peek() == '-' && peek(1) != ']' && _pos + 1 < _pattern.length())
+        {
+            ++_pos;
+            ushort high = peek();
+            ++_pos;
+            if (high == '\\' && !parseClassEscape(node->set, high))
+            {
+                // "a-\d" is a literal '-' between two members.
+                node->set.addChar(low);
+                node->set.addChar('-');
+                continue;
+            }
+            if (high < low)
+            {
+                delete node;
+                setError(tr("bad character range"));
+                return NULL;
+            }
+            node->set.addRange(low, high);
+        }
+        else
+        {
+            node->set.addChar(low);
+        }
+    }
+
+    if (atEnd())
+    {
+        delete node;
+        setError(tr("missing right bracket"));
+        return NULL;
+    }
+    ++_pos;
+    node->end = _pos;
+    return node;
+}
+
+PatternNode *PatternParser::parseEscape()
+{
+    int begin = _pos;
+    ++_pos;
+    if (atEnd())
+    {
+        setError(tr("pattern ends with a backslash"));
+        return NULL;
+    }
+
+    ushort escape = peek();
+    ++_pos;
+    PatternNode *node = new PatternNode(PatternNode::Set, begin);
+    switch (escape)
+    {
+    case 'd': node->set = CharSet::fromClass(CharSet::Digit); break;
+    case 'D': node->set = CharSet::fromClass(CharSet::NotDigit); break;
+    case 'w': node->set = CharSet::fromClass(CharSet::Word); break;
+    case 'W': node->set = CharSet::fromClass(CharSet::NotWord); break;
+    case 's': node->set = CharSet::fromClass(CharSet::Space); break;
+    case 'S': node->set = CharSet::fromClass(CharSet::NotSpace); break;
+    case 'b': node->type = PatternNode::WordBoundary; break;
+    case 'B': node->type = PatternNode::NonWordBoundary; break;
+    default:
+        if (escape >= '1' && escape <= '9')
+        {
+            node->type = PatternNode::BackReference;
+            node->index = escape - '0';
+        }
+        else
+        {
+            node->set = CharSet::single(parseCharEscape(escape));
+        }
+        break;
+    }
+    node->end = _pos;
+    return node;
+}
+
+bool PatternParser::parseQuantifier(int &min, int &max, bool consume)
+{
+    int start = _pos;
+    switch (peek())
+    {
+    case '*': min = 0; max = -1; break;
+    case '+': min = 1; max = -1; break;
+    case '?': min = 0; max = 1; break;
+    case '{':
+        ++_pos;
+        min = parseNumber(4, 10);
+        max = min;
+        if (peek() == ',')
+        {
+            ++_pos;
+            max = (peek() == '}') ? -1 : parseNumber(4, 10);
+        }
+        if (min < 0 || (max < 0 && peek(-1) != ',') || peek() != '}' ||
+            min > MAX_REPEAT_COUNT || (max >= 0 && (max < min || max > MAX_REPEAT_COUNT)))
+        {
+            // Not a valid interval: '{' is an ordinary character.
+            _pos = start;
+            return false;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    ++_pos;
+    if (!consume)
+    {
+        _pos = start;
+    }
+    return true;
+}
+
+bool PatternParser::parseClassEscape(CharSet &set, ushort &ch)
+{
+    if (atEnd())
+    {
+        ch = '\\';
+        return true;
+    }
+
+    ushort escape = peek();
+    ++_pos;
+    switch (escape)
+    {
+    case 'd': set.addClass(CharSet::Digit); return false;
+    case 'D': set.addClass(CharSet::NotDigit); return false;
+    case 'w': set.addClass(CharSet::Word); return false;
+    case 'W': set.addClass(CharSet::NotWord); return false;
+    case 's': set.addClass(CharSet::Space); return false;
+    case 'S': set.addClass(CharSet::NotSpace); return false;
+    case 'b': ch = 0x08; return true;
+    default:
+        ch = parseCharEscape(escape);
+        return true;
+    }
+}
+
+ushort PatternParser::parseCharEscape(ushort escape)
+{
+    int value;
+    switch (escape)
+    {
+    case 'a': return 0x07;
+    case 'e': return 0x1B;
+    case 'f': return '\f';
+    case 'n': return '\n';
+    case 'r': return '\r';
+    case 't': return '\t';
+    case 'v': return '\v';
+    case '0':
+        value = parseNumber(3, 8);
+        return value < 0 ? 0 : ushort(value);
+    case 'x':
+        value = parseNumber(4, 16);
+        return value < 0 ? 'x' : ushort(value);
+    default:
+        return escape;
+    }
+}
+
+int PatternParser::parseNumber(int maxDigits, int base)
+{
+    int value = 0;
+    int digits = 0;
+    while (digits < maxDigits && !atEnd())
+    {
+        int digit = QChar(peek()).digitValue();
+        if (base == 16 && digit < 0)
+        {
+            ushort ch = QChar(peek()).toLower().unicode();
+            digit = (ch >= 'a' && ch <= 'f') ? ch - 'a' + 10 : -1;
+        }
+        if (digit < 0 || digit >= base)
+        {
+            break;
+        }
+        value = value * base + digit;
+        ++digits;
+        ++_pos;
+    }
+    return digits > 0 ? value : -1;
+}
+
+bool PatternParser::atEnd() const
+{
+    return _pos >= _pattern.length();
+}
+
+ushort PatternParser::peek(int ahead) const
+{
+    int pos = _pos + ahead;
+    return (pos >= 0 && pos < _pattern.length()) ? _pattern.at(pos).unicode() : 0;
+}
+
+void PatternParser::setError(const QString &message)
+{
+    if (_error.isEmpty())
+    {
+        _error = message;
+        _errorOffset = _pos;
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNPARSER_H
+#define PATTERNPARSER_H
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QList>
+#include <QRegExp>
+#include <QString>
+#include "charset.h"
+
+/*
+ * One node of a parsed pattern. begin/end locate the node in the
+ * translated pattern text so findings can point back at the source.
+ */
+class PatternNode
+{
+public:
+    enum Type
+    {
+        Empty,
+        Set,
+        Sequence,
+        Alternation,
+        Group,
+        Repeat,
+        LineStart,
+        LineEnd,
+        WordBoundary,
+        NonWordBoundary,
+        Lookahead,
+        NegativeLookahead,
+        BackReference
+    };
+
+    explicit PatternNode(Type type, int begin = 0);
+    ~PatternNode();
+    bool isNullable() const;
+    bool isUnbounded() const;
+    bool isVariableLength() const;
+    bool isAssertion() const;
+    int maxReach() const;
+    bool readsChar(ushort ch) const;
+
+    Type type;
+    int begin;
+    int end;
+    CharSet set;        // Set
+    int min;            // Repeat
+    int max;            // Repeat, -1 when unbounded
+    bool greedy;        // Repeat
+    int index;          // Group: capture number (0 = non-capturing); BackReference: group
+    QList<PatternNode *> children;
+
+private:
+    Q_DISABLE_COPY(PatternNode)
+};
+
+/*
+ * Recursive-descent parser for the QRegExp regexp dialect (RegExp, RegExp2
+ * and W3CXmlSchema11). Wildcard and fixed-string patterns are translated to
+ * that dialect first. The tree drives the analysis and the Lazy DFA
+ * engine's NFA; QRegExp still has the final word on whether a pattern is
+ * valid.
+ */
+class PatternParser
+{
+    Q_DECLARE_TR_FUNCTIONS(PatternParser)
+public:
+    explicit PatternParser(const QRegExp &options);
+    ~PatternParser();
+    bool isValid() const;
+    QString errorString() const;
+    int errorOffset() const;
+    QString pattern() const;
+    Qt::CaseSensitivity caseSensitivity() const;
+    int captureCount() const;
+    const PatternNode *root() const;
+    int maxMatchLength() const;
+    bool isLineBound() const;
+
+private:
+    PatternNode *parseAlternation();
+    PatternNode *parseSequence();
+    PatternNode *parseAtom();
+    PatternNode *parseGroup();
+    PatternNode *parseClass();
+    PatternNode *parseEscape();
+    bool parseQuantifier(int &min, int &max, bool consume);
+    bool parseClassEscape(CharSet &set, ushort &ch);
+    ushort parseCharEscape(ushort escape);
+    int parseNumber(int maxDigits, int base);
+    bool atEnd() const;
+    ushort peek(int ahead = 0) const;
+    void setError(const QString &message);
+
+    QString _pattern;
+    int _pos;
+    Qt::CaseSensitivity _caseSensitivity;
+    bool _minimal;
+    int _captureCount;
+    QString _error;
+    int _errorOffset;
+    PatternNode *_root;
+
+    Q_DISABLE_COPY(PatternParser)
+};
+
+#endif // PATTERNPARSER_H
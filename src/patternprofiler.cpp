@@ -0,0 +1,430 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "patternprofiler.h"
+#include <QPair>
+#include <algorithm>
+
+// Steps a whole profiling run may take before it stops.
+#define MAX_PROFILE_STEPS 50000000
+// Nesting of an attempt; every repeated character adds a level.
+#define MAX_PROFILE_DEPTH 200000
+
+PatternProfile::PatternProfile() :
+    steps(0),
+    nsecs(0),
+    scanned(0),
+    textLength(0),
+    matches(0),
+    truncated(false),
+    tooDeep(false)
+{
+}
+
+double PatternProfile::selfShare(int entry) const
+{
+    return steps > 0 ? double(entries.at(entry).selfSteps) / steps : 0.0;
+}
+
+double PatternProfile::totalShare(int entry) const
+{
+    return steps > 0 ? double(entries.at(entry).totalSteps) / steps : 0.0;
+}
+
+qint64 PatternProfile::selfNsecs(int entry) const
+{
+    return qint64(nsecs * selfShare(entry));
+}
+
+/*
+ * Entry indexes, most expensive first by their own steps.
+ */
+QList<int> PatternProfile::byCost() const
+{
+    QVector<QPair<qint64, int> > costs;
+    for (int i = 0; i < entries.size(); ++i)
+    {
+        costs << qMakePair(-entries.at(i).selfSteps, i);
+    }
+    std::sort(costs.begin(), costs.end());
+
+    QList<int> order;
+    for (int i = 0; i < costs.size(); ++i)
+    {
+        order << costs.at(i).second;
+    }
+    return order;
+}
+
+PatternProfiler::PatternProfiler(const RegExpController &regexp) :
+    _parser(regexp.getRegExp()),
+    _engine(regexp.engine()->name()),
+    _pattern(regexp.getPattern()),
+    _text(NULL),
+    _length(0),
+    _region(0),
+    _matchEnd(-1),
+    _matchedLength(-1),
+    _depth(0),
+    _steps(0),
+    _scanned(0),
+    _matches(0),
+    _exhausted(false),
+    _tooDeep(false)
+{
+    if (_parser.isValid())
+    {
+        addRegion(_parser.root(), tr("pattern"), -1, 0);
+        addRegions(_parser.root(), 0, 1);
+    }
+}
+
+bool PatternProfiler::isParsed() const
+{
+    return _parser.isValid();
+}
+
+/*
+ * Finds the leftmost match from position from, as QRegExp::indexIn() does,
+ * and returns its position or -1.
+ */
+int PatternProfiler::indexIn(const QString &text, int from)
+{
+    _matchedLength = -1;
+    if (!_parser.isValid())
+    {
+        return -1;
+    }
+
+    _text = text.constData();
+    _length = text.length();
+    _captures.fill(-1, 2 * (_parser.captureCount() + 1));
+    Continuation accept = { Continuation::Accept, NULL, 0, 0, 0, NULL };
+    for (int start = qMax(from, 0); start <= _length && !_exhausted; ++start)
+    {
+        _region = 0;
+        _depth = 0;
+        _entries[0].attempts ++;
+        if (match(_parser.root(), start, &accept))
+        {
+            _matchedLength = _matchEnd - start;
+            _scanned = qMax(_scanned, _matchEnd);
+            _matches ++;
+            return start;
+        }
+        _scanned = qMax(_scanned, start);
+    }
+    return -1;
+}
+
+int PatternProfiler::matchedLength() const
+{
+    return _matchedLength;
+}
+
+bool PatternProfiler::isExhausted() const
+{
+    return _exhausted;
+}
+
+PatternProfile PatternProfiler::profile() const
+{
+    PatternProfile profile;
+    profile.engine = _engine;
+    profile.pattern = _pattern;
+    profile.entries = _entries;
+    profile.steps = _steps;
+    profile.scanned = _scanned;
+    profile.matches = _matches;
+    profile.truncated = _exhausted;
+    profile.tooDeep = _tooDeep;
+
+    // Entries are in pre-order, so every part comes after its parent.
+    for (int i = 0; i < profile.entries.size(); ++i)
+    {
+        profile.entries[i].totalSteps = profile.entries.at(i).selfSteps;
+    }
+    for (int i = profile.entries.size() - 1; i > 0; --i)
+    {
+        profile.entries[profile.entries.at(i).parent].totalSteps += profile.entries.at(i).totalSteps;
+    }
+    return profile;
+}
+
+void PatternProfiler::addRegions(const PatternNode *node, int parent, int depth)
+{
+    if (node->type == PatternNode::Group && node->index > 0)
+    {
+        parent = addRegion(node, QString(tr("group %1")).arg(node->index), parent, depth);
+        _groupRegions.insert(node, parent);
+        ++depth;
+    }
+
+    for (int i = 0; i < node->children.size(); ++i)
+    {
+        const PatternNode *child = node->children.at(i);
+        if (node->type == PatternNode::Alternation)
+        {
+            int branch = addRegion(child, QString(tr("branch %1 of %2")).arg(i + 1).arg(node->children.size()),
+                                   parent, depth);
+            _branchRegions.insert(child, branch);
+            addRegions(child, branch, depth + 1);
+        }
+        else
+        {
+            addRegions(child, parent, depth);
+        }
+    }
+}
+
+int PatternProfiler::addRegion(const PatternNode *node, const QString &label, int parent, int depth)
+{
+    ProfileEntry entry;
+    entry.label = label;
+    entry.begin = node->begin;
+    entry.end = node->end;
+    entry.parent = parent;
+    entry.depth = depth;
+    entry.attempts = 0;
+    entry.selfSteps = 0;
+    entry.totalSteps = 0;
+    _entries << entry;
+    return _entries.size() - 1;
+}
+
+/*
+ * Matches node at pos and then whatever next stands for. Returns true as
+ * soon as the whole pattern matched; false makes the caller backtrack.
+ */
+bool PatternProfiler::match(const PatternNode *node, int pos, const Continuation *next)
+{
+    if (_exhausted)
+    {
+        return false;
+    }
+    if (++_depth > MAX_PROFILE_DEPTH)
+    {
+        _tooDeep = true;
+        _exhausted = true;
+        return false;
+    }
+
+    bool matched = false;
+    switch (node->type)
+    {
+    case PatternNode::Empty:
+        matched = resume(next, pos);
+        break;
+    case PatternNode::Set:
+        matched = step() && pos < _length &&
+                  node->set.contains(_text[pos].unicode(), _parser.caseSensitivity()) &&
+                  resume(next, pos + 1);
+        break;
+    case PatternNode::Sequence:
+        matched = matchSequence(node, 0, pos, next);
+        break;
+    case PatternNode::Alternation:
+        for (int i = 0; !matched && !_exhausted && i < node->children.size(); ++i)
+        {
+            const PatternNode *branch = node->children.at(i);
+            matched = matchRegion(branch, _branchRegions.value(branch), pos, next);
+        }
+        break;
+    case PatternNode::Group:
+        if (node->index > 0)
+        {
+            Continuation end = { Continuation::GroupEnd, node, node->index, pos, 0, next };
+            matched = matchRegion(node->children.first(), _groupRegions.value(node), pos, &end);
+        }
+        else
+        {
+            matched = match(node->children.first(), pos, next);
+        }
+        break;
+    case PatternNode::Repeat:
+        matched = matchRepeat(node, 0, pos, next);
+        break;
+    case PatternNode::LineStart:
+        matched = step() && pos == 0 && resume(next, pos);
+        break;
+    case PatternNode::LineEnd:
+        matched = step() && pos == _length && resume(next, pos);
+        break;
+    case PatternNode::WordBoundary:
+    case PatternNode::NonWordBoundary:
+    {
+        bool before = pos > 0 && CharSet::isWordChar(_text[pos - 1].unicode());
+        bool after = pos < _length && CharSet::isWordChar(_text[pos].unicode());
+        bool boundary = (before != after);
+        matched = step() && boundary == (node->type == PatternNode::WordBoundary) && resume(next, pos);
+        break;
+    }
+    case PatternNode::Lookahead:
+    case PatternNode::NegativeLookahead:
+    {
+        Continuation end = { Continuation::LookaheadEnd, node, 0, 0, 0, NULL };
+        bool found = match(node->children.first(), pos, &end);
+        matched = !_exhausted && found == (node->type == PatternNode::Lookahead) && resume(next, pos);
+        break;
+    }
+    case PatternNode::BackReference:
+    {
+        int end = pos;
+        matched = matchBackReference(node->index, end) && resume(next, end);
+        break;
+    }
+    }
+
+    --_depth;
+    return matched;
+}
+
+bool PatternProfiler::matchSequence(const PatternNode *node, int index, int pos, const Continuation *next)
+{
+    if (index == node->children.size())
+    {
+        return resume(next, pos);
+    }
+    if (index == node->children.size() - 1)
+    {
+        // The last child continues straight with next, one level less deep.
+        return match(node->children.at(index), pos, next);
+    }
+    Continuation rest = { Continuation::SequenceNext, node, index + 1, 0, 0, next };
+    return match(node->children.at(index), pos, &rest);
+}
+
+/*
+ * count iterations of the repeat's body are done. Greedy repeats try
+ * another iteration before moving on, lazy ones the other way round.
+ */
+bool PatternProfiler::matchRepeat(const PatternNode *node, int count, int pos, const Continuation *next)
+{
+    const PatternNode *body = node->children.first();
+    Continuation again = { Continuation::RepeatNext, node, count + 1, pos, 0, next };
+    if (count < node->min)
+    {
+        return match(body, pos, &again);
+    }
+
+    bool canRepeat = (node->max < 0 || count < node->max);
+    if (node->greedy)
+    {
+        if (canRepeat && match(body, pos, &again))
+        {
+            return true;
+        }
+        return !_exhausted && resume(next, pos);
+    }
+    if (resume(next, pos))
+    {
+        return true;
+    }
+    return !_exhausted && canRepeat && match(body, pos, &again);
+}
+
+bool PatternProfiler::matchRegion(const PatternNode *node, int region, int pos, const Continuation *next)
+{
+    int outer = _region;
+    _region = region;
+    _entries[region].attempts ++;
+    Continuation end = { Continuation::RegionEnd, node, 0, 0, outer, next };
+    bool matched = match(node, pos, &end);
+    _region = outer;
+    return matched;
+}
+
+bool PatternProfiler::resume(const Continuation *next, int pos)
+{
+    switch (next->kind)
+    {
+    case Continuation::Accept:
+        _matchEnd = pos;
+        return true;
+    case Continuation::LookaheadEnd:
+        return true;
+    case Continuation::SequenceNext:
+        return matchSequence(next->node, next->index, pos, next->next);
+    case Continuation::RepeatNext:
+        // An empty iteration past the minimum would loop forever.
+        if (pos == next->start && next->index > next->node->min)
+        {
+            return false;
+        }
+        return matchRepeat(next->node, next->index, pos, next->next);
+    case Continuation::GroupEnd:
+    {
+        int oldStart = _captures.at(2 * next->index);
+        int oldEnd = _captures.at(2 * next->index + 1);
+        _captures[2 * next->index] = next->start;
+        _captures[2 * next->index + 1] = pos;
+        if (resume(next->next, pos))
+        {
+            return true;
+        }
+        _captures[2 * next->index] = oldStart;
+        _captures[2 * next->index + 1] = oldEnd;
+        return false;
+    }
+    case Continuation::RegionEnd:
+    {
+        int inner = _region;
+        _region = next->region;
+        bool matched = resume(next->next, pos);
+        _region = inner;
+        return matched;
+    }
+    }
+    return false;
+}
+
+/*
+ * A group that hasn't matched yet matches the empty string, as in QRegExp.
+ */
+bool PatternProfiler::matchBackReference(int group, int &pos)
+{
+    if (2 * group + 1 >= _captures.size() || _captures.at(2 * group) < 0)
+    {
+        return step();
+    }
+
+    int start = _captures.at(2 * group);
+    int length = _captures.at(2 * group + 1) - start;
+    if (pos + length > _length)
+    {
+        return false;
+    }
+    for (int i = 0; i < length; ++i)
+    {
+        QChar expected = _text[start + i];
+        QChar actual = _text[pos + i];
+        if (!step())
+        {
+            return false;
+        }
+        if (_parser.caseSensitivity() == Qt::CaseSensitive ? expected != actual
+                                                           : expected.toCaseFolded() != actual.toCaseFolded())
+        {
+            return false;
+        }
+    }
+    pos += length;
+    return true;
+}
+
+/*
+ * Charges one step to the part being matched; false once the budget is
+ * spent.
+ */
+bool PatternProfiler::step()
+{
+    if (_steps >= MAX_PROFILE_STEPS)
+    {
+        _exhausted = true;
+        return false;
+    }
+    ++_steps;
+    _entries[_region].selfSteps ++;
+    return true;
+}
@@ -0,0 +1,140 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNPROFILER_H
+#define PATTERNPROFILER_H
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include "patternparser.h"
+#include "regexpcontroller.h"
+
+/*
+ * Cost of one part of a pattern: the whole pattern, a capture group or one
+ * branch of an alternation. begin/end locate it in the pattern text.
+ * selfSteps counts the steps taken directly in the part, totalSteps also
+ * those of the parts nested in it; parent indexes the enclosing part (-1
+ * for the whole pattern).
+ */
+struct ProfileEntry
+{
+    QString label;
+    int begin;
+    int end;
+    int parent;
+    int depth;
+    qint64 attempts;
+    qint64 selfSteps;
+    qint64 totalSteps;
+};
+
+/*
+ * Result of a profiling run. nsecs is the time the selected engine took
+ * for the same text; each entry's share of it is estimated from its share
+ * of the steps. scanned is how far into the textLength characters the
+ * run got.
+ */
+class PatternProfile
+{
+public:
+    PatternProfile();
+    double selfShare(int entry) const;
+    double totalShare(int entry) const;
+    qint64 selfNsecs(int entry) const;
+    QList<int> byCost() const;
+
+    QString engine;
+    QString pattern;
+    QList<ProfileEntry> entries;
+    qint64 steps;
+    qint64 nsecs;
+    int scanned;
+    int textLength;
+    int matches;
+    bool truncated;
+    bool tooDeep;
+};
+
+Q_DECLARE_METATYPE(PatternProfile)
+
+/*
+ * Instrumented backtracking interpreter over the parsed pattern. It tries
+ * the alternatives in the order a backtracking engine does (branches left
+ * to right, greedy repeats longest first) and charges every character test
+ * to the innermost capture group or alternation branch being matched, so a
+ * slow pattern shows where the backtracking happens.
+ *
+ * It is a model, not the selected engine: the engine's own time is only
+ * split up by step share. Going over MAX_PROFILE_STEPS in total or nesting
+ * deeper than MAX_PROFILE_DEPTH in one attempt ends the run, much as a
+ * backtracking engine gives up; the counts gathered so far are kept.
+ */
+class PatternProfiler
+{
+    Q_DECLARE_TR_FUNCTIONS(PatternProfiler)
+public:
+    explicit PatternProfiler(const RegExpController &regexp);
+    bool isParsed() const;
+    int indexIn(const QString &text, int from);
+    int matchedLength() const;
+    bool isExhausted() const;
+    PatternProfile profile() const;
+
+private:
+    struct Continuation
+    {
+        enum Kind
+        {
+            Accept,
+            SequenceNext,
+            RepeatNext,
+            GroupEnd,
+            RegionEnd,
+            LookaheadEnd
+        };
+
+        Kind kind;
+        const PatternNode *node;
+        int index;
+        int start;
+        int region;
+        const Continuation *next;
+    };
+
+    void addRegions(const PatternNode *node, int parent, int depth);
+    int addRegion(const PatternNode *node, const QString &label, int parent, int depth);
+    bool match(const PatternNode *node, int pos, const Continuation *next);
+    bool matchSequence(const PatternNode *node, int index, int pos, const Continuation *next);
+    bool matchRepeat(const PatternNode *node, int count, int pos, const Continuation *next);
+    bool matchRegion(const PatternNode *node, int region, int pos, const Continuation *next);
+    bool resume(const Continuation *next, int pos);
+    bool matchBackReference(int group, int &pos);
+    bool step();
+
+    PatternParser _parser;
+    QString _engine;
+    QString _pattern;
+    const QChar *_text;
+    int _length;
+    QList<ProfileEntry> _entries;
+    QHash<const PatternNode *, int> _groupRegions;
+    QHash<const PatternNode *, int> _branchRegions;
+    int _region;
+    QVector<int> _captures;
+    int _matchEnd;
+    int _matchedLength;
+    int _depth;
+    qint64 _steps;
+    int _scanned;
+    int _matches;
+    bool _exhausted;
+    bool _tooDeep;
+};
+
+#endif // PATTERNPROFILER_H
@@ -0,0 +1,170 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QFile>
+#include <QTextStream>
+#include "patternset.h"
+#include "patternlibrary.h"
+
+PatternSet::PatternSet(QObject *parent) :
+    QObject(parent)
+{
+}
+
+PatternSet::~PatternSet()
+{
+    qDeleteAll(_patterns);
+}
+
+int PatternSet::count() const
+{
+    return _patterns.size();
+}
+
+RegExpController *PatternSet::at(int index) const
+{
+    return _patterns.at(index);
+}
+
+RegExpController *PatternSet::append()
+{
+    RegExpController *regexp = new RegExpController();
+    _patterns << regexp;
+    return regexp;
+}
+
+void PatternSet::removeAt(int index)
+{
+    delete _patterns.takeAt(index);
+}
+
+void PatternSet::clear()
+{
+    qDeleteAll(_patterns);
+    _patterns.clear();
+}
+
+bool PatternSet::saveToFile(const QString &filename)
+{
+    QFile file(filename);
+    if (!file.open(QFile::WriteOnly|QFile::Truncate|QFile::Text))
+    {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    for (int i = 0; i < _patterns.size(); ++i)
+    {
+        if (i > 0)
+        {
+            stream << endl;
+        }
+        _patterns.at(i)->saveToStream(stream);
+    }
+    file.close();
+
+    _filename = filename;
+
+    return true;
+}
+
+bool PatternSet::loadFromFile(const QString &filename)
+{
+    if (PatternLibrary::isLibrary(filename))
+    {
+        return loadFromLibrary(filename);
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly|QFile::Text))
+    {
+        return false;
+    }
+
+    QTextStream stream(&file);
+    QList<QStringList> sections = RegExpController::readSections(stream);
+    file.close();
+
+    QList<RegExpController *> patterns;
+    _fileError.clear();
+    for (int i = 0; i < sections.size(); ++i)
+    {
+        RegExpController *regexp = new RegExpController();
+        patterns << regexp;
+        if (!regexp->loadFromSection(sections.at(i)))
+        {
+            _fileError = QString("Pattern #%1: %2").arg(i + 1).arg(regexp->getFileError());
+            qDeleteAll(patterns);
+            return false;
+        }
+    }
+
+    clear();
+    _patterns = patterns;
+    _filename = filename;
+
+    return true;
+}
+
+QString PatternSet::getFilename() const
+{
+    return _filename;
+}
+
+QString PatternSet::getFileError() const
+{
+    return _fileError;
+}
+
+int PatternSet::sectionCount(const QString &filename)
+{
+    if (PatternLibrary::isLibrary(filename))
+    {
+        PatternLibrary library;
+        return library.open(filename) ? library.count() : 0;
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly|QFile::Text))
+    {
+        return 0;
+    }
+
+    QTextStream stream(&file);
+    return RegExpController::readSections(stream).size();
+}
+
+/*
+ * A precompiled library is read into the set as well; saving it writes
+ * the text format.
+ */
+bool PatternSet::loadFromLibrary(const QString &filename)
+{
+    PatternLibrary library;
+    _fileError.clear();
+    if (!library.open(filename))
+    {
+        _fileError = library.getError();
+        return false;
+    }
+
+    QList<RegExpController *> patterns;
+    for (int i = 0; i < library.count(); ++i)
+    {
+        RegExpController *regexp = new RegExpController();
+        patterns << regexp;
+        if (!library.load(i, *regexp))
+        {
+            _fileError = library.getError();
+            qDeleteAll(patterns);
+            return false;
+        }
+    }
+
+    clear();
+    _patterns = patterns;
+    _filename = filename;
+
+    return true;
+}
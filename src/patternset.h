@@ -0,0 +1,43 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNSET_H
+#define PATTERNSET_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include "regexpcontroller.h"
+
+/*
+ * An ordered list of patterns saved as one .qregexp file, with a
+ * [Pattern] section per pattern. A file with a single section is an
+ * ordinary pattern file.
+ */
+class PatternSet : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PatternSet(QObject *parent = 0);
+    ~PatternSet();
+    int count() const;
+    RegExpController *at(int index) const;
+    RegExpController *append();
+    void removeAt(int index);
+    void clear();
+    bool saveToFile(const QString &filename);
+    bool loadFromFile(const QString &filename);
+    QString getFilename() const;
+    QString getFileError() const;
+    static int sectionCount(const QString &filename);
+
+private:
+    bool loadFromLibrary(const QString &filename);
+
+    QList<RegExpController *> _patterns;
+    QString _filename;
+    QString _fileError;
+};
+
+#endif // PATTERNSET_H
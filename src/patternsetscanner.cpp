@@ -0,0 +1,228 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <algorithm>
+#include <QtConcurrentRun>
+#include <QtConcurrentMap>
+#include "patternsetscanner.h"
+
+// Characters run through the automata between cancel checks.
+#define SCAN_CHUNK_LENGTH (1024 * 1024)
+
+struct PatternSetScanner::Confirmer
+{
+    typedef QVector<PatternSetHit> result_type;
+
+    explicit Confirmer(const PatternSetScanner *scanner) :
+        _scanner(scanner)
+    {
+    }
+
+    QVector<PatternSetHit> operator()(int pattern) const
+    {
+        return _scanner->confirm(pattern);
+    }
+
+    const PatternSetScanner *_scanner;
+};
+
+PatternSetScanner::PatternSetScanner(const PatternSet &set) :
+    _exact(Qt::CaseSensitive),
+    _folded(Qt::CaseInsensitive),
+    _canceled(0),
+    _scanned(0)
+{
+    for (int i = 0; i < set.count(); ++i)
+    {
+        RegExpController *regexp = new RegExpController();
+        regexp->copyFrom(*set.at(i));
+        _patterns << regexp;
+        _valid << (!regexp->getPattern().isEmpty() && regexp->isPatternValid());
+
+        // Confirmation searches windows around the literals, too.
+        regexp->setPrefilterEnabled(true);
+        const Prefilter *prefilter = regexp->prefilter();
+        if (!_valid.last() || !prefilter->isUsable())
+        {
+            continue;
+        }
+        AhoCorasick &automaton = (prefilter->caseSensitivity() == Qt::CaseSensitive) ? _exact : _folded;
+        foreach (const QString &literal, prefilter->literals())
+        {
+            automaton.addLiteral(literal, _literalPatterns.size());
+            _literalPatterns << i;
+        }
+    }
+    _exact.build();
+    _folded.build();
+}
+
+PatternSetScanner::~PatternSetScanner()
+{
+    cancel();
+    _future.waitForFinished();
+    qDeleteAll(_patterns);
+}
+
+void PatternSetScanner::setTestee(const QString &testee)
+{
+    _testee = testee;
+}
+
+void PatternSetScanner::start()
+{
+    _canceled.storeRelease(0);
+    _scanned.storeRelease(0);
+    _future = QtConcurrent::run(this, &PatternSetScanner::scan);
+}
+
+void PatternSetScanner::cancel()
+{
+    _canceled.storeRelease(1);
+}
+
+bool PatternSetScanner::isFinished() const
+{
+    return _future.isFinished();
+}
+
+QFuture<QVector<PatternSetHit> > PatternSetScanner::future() const
+{
+    return _future;
+}
+
+qint64 PatternSetScanner::scannedLength() const
+{
+    return _scanned.loadAcquire();
+}
+
+bool PatternSetScanner::isPrefiltered(int pattern) const
+{
+    return _valid.at(pattern) && _patterns.at(pattern)->prefilter()->isUsable();
+}
+
+QStringList PatternSetScanner::literals(int pattern) const
+{
+    return isPrefiltered(pattern) ? _patterns.at(pattern)->prefilter()->literals() : QStringList();
+}
+
+QVector<PatternSetHit> PatternSetScanner::result()
+{
+    _future.waitForFinished();
+    if (_canceled.loadAcquire() != 0)
+    {
+        return QVector<PatternSetHit>();
+    }
+    return _future.result();
+}
+
+QVector<PatternSetHit> PatternSetScanner::scan()
+{
+    // The single pass: candidate positions of every prefiltered pattern.
+    _candidates = QVector<QVector<int> >(_patterns.size());
+    int length = _testee.length();
+    int exactState = 0;
+    int foldedState = 0;
+    QVector<LiteralHit> hits;
+    for (int from = 0; from < length && _canceled.loadAcquire() == 0; from += SCAN_CHUNK_LENGTH)
+    {
+        int to = qMin(from + SCAN_CHUNK_LENGTH, length);
+        hits.clear();
+        if (!_exact.isEmpty())
+        {
+            exactState = _exact.scan(_testee, from, to, exactState, hits);
+        }
+        if (!_folded.isEmpty())
+        {
+            foldedState = _folded.scan(_testee, from, to, foldedState, hits);
+        }
+        foreach (const LiteralHit &hit, hits)
+        {
+            _candidates[_literalPatterns.at(hit.id)] << hit.pos;
+        }
+        _scanned.fetchAndAddRelaxed(to - from);
+    }
+    for (int i = 0; i < _candidates.size(); ++i)
+    {
+        QVector<int> &candidates = _candidates[i];
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+
+    QList<int> patterns;
+    for (int i = 0; i < _patterns.size(); ++i)
+    {
+        patterns << i;
+    }
+    QList<QVector<PatternSetHit> > results =
+            QtConcurrent::blockingMapped<QList<QVector<PatternSetHit> > >(patterns, Confirmer(this));
+
+    QVector<PatternSetHit> merged;
+    foreach (const QVector<PatternSetHit> &result, results)
+    {
+        merged += result;
+    }
+    std::sort(merged.begin(), merged.end(), hitLessThan);
+    return merged;
+}
+
+QVector<PatternSetHit> PatternSetScanner::confirm(int pattern) const
+{
+    QVector<PatternSetHit> hits;
+    if (!_valid.at(pattern))
+    {
+        return hits;
+    }
+
+    const RegExpController *regexp = _patterns.at(pattern);
+    RegExpMatchIterator it(*regexp, _testee);
+    PatternSetHit hit;
+    hit.pattern = pattern;
+
+    if (!isPrefiltered(pattern))
+    {
+        while (_canceled.loadAcquire() == 0 && it.next())
+        {
+            hit.pos = it.pos();
+            hit.length = it.matchedLength();
+            hits << hit;
+        }
+        return hits;
+    }
+
+    // A match from the next search on contains a literal at or after its
+    // start, so candidates before it are covered by a reported match or
+    // were ruled out, and none left means no more matches.
+    const QVector<int> &candidates = _candidates.at(pattern);
+    int maxLiteralOffset = regexp->prefilter()->maxLiteralOffset();
+    int c = 0;
+    while (_canceled.loadAcquire() == 0)
+    {
+        while (c < candidates.size() && candidates.at(c) < it.nextFrom())
+        {
+            c ++;
+        }
+        if (c == candidates.size())
+        {
+            break;
+        }
+        if (maxLiteralOffset >= 0)
+        {
+            it.skipTo(candidates.at(c) - maxLiteralOffset);
+        }
+        if (!it.next())
+        {
+            break;
+        }
+        hit.pos = it.pos();
+        hit.length = it.matchedLength();
+        hits << hit;
+    }
+    return hits;
+}
+
+bool PatternSetScanner::hitLessThan(const PatternSetHit &left, const PatternSetHit &right)
+{
+    return left.pos != right.pos ? left.pos < right.pos : left.pattern < right.pattern;
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNSETSCANNER_H
+#define PATTERNSETSCANNER_H
+
+#include <QAtomicInt>
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "ahocorasick.h"
+#include "patternset.h"
+#include "prefilter.h"
+
+struct PatternSetHit
+{
+    int pattern;
+    int pos;
+    int length;
+};
+
+/*
+ * Matches every pattern of a set against one testee. The required
+ * literals of all patterns go into one Aho-Corasick automaton per case
+ * sensitivity, so a single pass over the testee yields the candidate
+ * positions of every pattern; each pattern's engine then only confirms
+ * its own candidates. Patterns without a required literal fall back to
+ * a full scan. Confirmation runs on the global thread pool, one task per
+ * pattern, stepping through the matches with a RegExpMatchIterator, and
+ * hits are returned sorted by position.
+ */
+class PatternSetScanner
+{
+public:
+    explicit PatternSetScanner(const PatternSet &set);
+    ~PatternSetScanner();
+    void setTestee(const QString &testee);
+    void start();
+    void cancel();
+    bool isFinished() const;
+    QFuture<QVector<PatternSetHit> > future() const;
+    qint64 scannedLength() const;
+    bool isPrefiltered(int pattern) const;
+    QStringList literals(int pattern) const;
+    QVector<PatternSetHit> result();
+
+private:
+    Q_DISABLE_COPY(PatternSetScanner)
+    struct Confirmer;
+
+    QVector<PatternSetHit> scan();
+    QVector<PatternSetHit> confirm(int pattern) const;
+    static bool hitLessThan(const PatternSetHit &left, const PatternSetHit &right);
+
+    QList<RegExpController *> _patterns;
+    QVector<bool> _valid;
+    AhoCorasick _exact;
+    AhoCorasick _folded;
+    QVector<int> _literalPatterns;
+    QVector<QVector<int> > _candidates;
+    QString _testee;
+    QFuture<QVector<PatternSetHit> > _future;
+    QAtomicInt _canceled;
+    QAtomicInt _scanned;
+};
+
+#endif // PATTERNSETSCANNER_H
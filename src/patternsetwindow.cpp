@@ -0,0 +1,373 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QComboBox>
+#include <QHeaderView>
+#include "patternsetwindow.h"
+#include "ui_patternsetwindow.h"
+
+// Hits listed in the result table; the summary still counts all of them.
+#define MAX_RESULT_ROWS 10000
+#define MAX_DISPLAY_LENGTH 1024
+#define PROGRESS_INTERVAL_MS 100
+
+enum PatternColumn
+{
+    NameColumn,
+    PatternColumn,
+    SyntaxColumn,
+    CaseSensitiveColumn,
+    MinimalColumn,
+    HitsColumn,
+    PatternColumnCount
+};
+
+enum ResultColumn
+{
+    RuleColumn,
+    PosColumn,
+    LengthColumn,
+    TextColumn,
+    ResultColumnCount
+};
+
+PatternSetWindow::PatternSetWindow(QWidget *parent) :
+    QWidget(parent),
+    ui(new Ui::PatternSetWindow),
+    _patternSet(new PatternSet(this)),
+    _scanner(NULL),
+    _watcher(new QFutureWatcher<QVector<PatternSetHit> >(this)),
+    _progressTimer(new QTimer(this))
+{
+    ui->setupUi(this);
+    ui->patternTable->setColumnCount(PatternColumnCount);
+    ui->patternTable->setHorizontalHeaderLabels(QStringList() << tr("Name") << tr("Pattern") << tr("Syntax")
+                                                << tr("Case sensitive") << tr("Minimal") << tr("Hits"));
+    ui->patternTable->horizontalHeader()->setSectionResizeMode(PatternColumn, QHeaderView::Stretch);
+    ui->resultTable->setColumnCount(ResultColumnCount);
+    ui->resultTable->setHorizontalHeaderLabels(QStringList() << tr("Rule") << tr("Pos") << tr("Length") << tr("Text"));
+    ui->resultTable->horizontalHeader()->setStretchLastSection(true);
+    ui->resultTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    connect(_watcher, SIGNAL(finished()), this, SLOT(onScanFinished()));
+    connect(_progressTimer, SIGNAL(timeout()), this, SLOT(onProgressTimeout()));
+    on_addPatternButton_clicked();
+    setRunning(false);
+    setWindowTitle(tr("Untitled pattern set"));
+}
+
+PatternSetWindow::~PatternSetWindow()
+{
+    releaseScanner();
+    delete ui;
+}
+
+void PatternSetWindow::run()
+{
+    releaseScanner();
+    syncUiToPatternSet();
+
+    ui->resultTable->setRowCount(0);
+    for (int row = 0; row < ui->patternTable->rowCount(); ++row)
+    {
+        ui->patternTable->item(row, HitsColumn)->setText(QString());
+        ui->patternTable->item(row, HitsColumn)->setToolTip(QString());
+    }
+
+    QStringList errors;
+    for (int i = 0; i < _patternSet->count(); ++i)
+    {
+        RegExpController *regexp = _patternSet->at(i);
+        if (!regexp->getPattern().trimmed().isEmpty() && !regexp->isPatternValid())
+        {
+            errors << tr("Rule %1 skipped: %2").arg(ruleName(i)).arg(regexp->errorString());
+        }
+    }
+
+    _testee = ui->testeeEdit->toPlainText();
+    if (isPatternEmpty())
+    {
+        errors << tr("ERROR: pattern content is empty.");
+    }
+    else if (_testee.isEmpty())
+    {
+        errors << tr("ERROR: testee content is empty.");
+    }
+    ui->summaryLabel->setStyleSheet(errors.isEmpty() ? QString() : QString("color: red"));
+    ui->summaryLabel->setText(errors.join("\n"));
+    if (isPatternEmpty() || _testee.isEmpty())
+    {
+        return;
+    }
+
+    _scanner = new PatternSetScanner(*_patternSet);
+    _scanner->setTestee(_testee);
+    _elapsed.start();
+    _scanner->start();
+    _watcher->setFuture(_scanner->future());
+    setRunning(true);
+}
+
+void PatternSetWindow::cancel()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+    releaseScanner();
+    ui->progressLabel->setText(tr("Canceled."));
+}
+
+bool PatternSetWindow::isRunning() const
+{
+    return _scanner != NULL;
+}
+
+void PatternSetWindow::clear()
+{
+    releaseScanner();
+    _patternSet->clear();
+    ui->patternTable->setRowCount(0);
+    on_addPatternButton_clicked();
+    clearTestee();
+    ui->resultTable->setRowCount(0);
+    ui->summaryLabel->clear();
+    ui->progressLabel->clear();
+}
+
+void PatternSetWindow::clearTestee()
+{
+    ui->testeeEdit->clear();
+}
+
+void PatternSetWindow::loadTesteeFromFile(const QString &filename)
+{
+    clearTestee();
+
+    QFile testeeFile(filename);
+    if (testeeFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        QTextStream testeeStream(&testeeFile);
+        ui->testeeEdit->setPlainText(testeeStream.readAll());
+    }
+}
+
+bool PatternSetWindow::saveToFile(const QString &filename)
+{
+    syncUiToPatternSet();
+    if (!_patternSet->saveToFile(filename))
+    {
+        return false;
+    }
+    setWindowTitle(QFileInfo(filename).fileName());
+    return true;
+}
+
+bool PatternSetWindow::loadFromFile(const QString &filename)
+{
+    releaseScanner();
+    if (!_patternSet->loadFromFile(filename))
+    {
+        return false;
+    }
+    syncUiFromPatternSet();
+    setWindowTitle(QFileInfo(filename).fileName());
+    return true;
+}
+
+QString PatternSetWindow::getFilename()
+{
+    return _patternSet->getFilename();
+}
+
+QString PatternSetWindow::getFileError()
+{
+    return _patternSet->getFileError();
+}
+
+bool PatternSetWindow::isPatternEmpty() const
+{
+    for (int row = 0; row < ui->patternTable->rowCount(); ++row)
+    {
+        QTableWidgetItem *item = ui->patternTable->item(row, PatternColumn);
+        if (item != NULL && !item->text().trimmed().isEmpty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PatternSetWindow::syncUiToPatternSet()
+{
+    for (int row = 0; row < ui->patternTable->rowCount(); ++row)
+    {
+        RegExpController *regexp = _patternSet->at(row);
+        QComboBox *syntaxComboBox = qobject_cast<QComboBox *>(ui->patternTable->cellWidget(row, SyntaxColumn));
+        regexp->setName(ui->patternTable->item(row, NameColumn)->text().trimmed());
+        regexp->setPattern(ui->patternTable->item(row, PatternColumn)->text());
+        regexp->setPatternSyntax(syntaxComboBox->currentText());
+        regexp->setCaseSensitive(ui->patternTable->item(row, CaseSensitiveColumn)->checkState() == Qt::Checked ?
+                                     Qt::CaseSensitive : Qt::CaseInsensitive);
+        regexp->setMinimal(ui->patternTable->item(row, MinimalColumn)->checkState() == Qt::Checked);
+    }
+}
+
+void PatternSetWindow::syncUiFromPatternSet()
+{
+    ui->patternTable->setRowCount(0);
+    for (int i = 0; i < _patternSet->count(); ++i)
+    {
+        insertPatternRow(_patternSet->at(i));
+    }
+}
+
+void PatternSetWindow::on_addPatternButton_clicked()
+{
+    insertPatternRow(_patternSet->append());
+}
+
+void PatternSetWindow::on_removePatternButton_clicked()
+{
+    int row = ui->patternTable->currentRow();
+    if (row < 0 || isRunning())
+    {
+        return;
+    }
+    ui->patternTable->removeRow(row);
+    _patternSet->removeAt(row);
+}
+
+void PatternSetWindow::on_runButton_clicked()
+{
+    run();
+}
+
+void PatternSetWindow::on_cancelButton_clicked()
+{
+    cancel();
+}
+
+void PatternSetWindow::onScanFinished()
+{
+    // A finished notice may still arrive from a scan released since.
+    if (_scanner == NULL || !_scanner->isFinished())
+    {
+        return;
+    }
+
+    qint64 msecs = _elapsed.elapsed();
+    QVector<PatternSetHit> hits = _scanner->result();
+    QVector<int> hitCounts(_patternSet->count(), 0);
+    int rows = qMin(hits.size(), MAX_RESULT_ROWS);
+
+    ui->resultTable->setRowCount(rows);
+    for (int i = 0; i < hits.size(); ++i)
+    {
+        const PatternSetHit &hit = hits.at(i);
+        hitCounts[hit.pattern] ++;
+        if (i >= rows)
+        {
+            continue;
+        }
+        ui->resultTable->setItem(i, RuleColumn, new QTableWidgetItem(ruleName(hit.pattern)));
+        ui->resultTable->setItem(i, PosColumn, new QTableWidgetItem(QString::number(hit.pos)));
+        ui->resultTable->setItem(i, LengthColumn, new QTableWidgetItem(QString::number(hit.length)));
+        ui->resultTable->setItem(i, TextColumn, new QTableWidgetItem(_testee.mid(hit.pos, qMin(hit.length, MAX_DISPLAY_LENGTH))));
+    }
+
+    int prefiltered = 0;
+    for (int i = 0; i < _patternSet->count(); ++i)
+    {
+        QTableWidgetItem *item = ui->patternTable->item(i, HitsColumn);
+        item->setText(QString::number(hitCounts.at(i)));
+        if (_scanner->isPrefiltered(i))
+        {
+            prefiltered ++;
+            item->setToolTip(tr("Prefiltered on: %1").arg(_scanner->literals(i).join(", ")));
+        }
+    }
+
+    QString summary = tr("%1 hits from %2 rules in %3 ms; %4 rules prefiltered by required literals, %5 scanned in full.")
+            .arg(hits.size())
+            .arg(_patternSet->count())
+            .arg(msecs)
+            .arg(prefiltered)
+            .arg(_patternSet->count() - prefiltered);
+    if (hits.size() > rows)
+    {
+        summary += tr(" Only the first %1 hits are listed.").arg(rows);
+    }
+    if (!ui->summaryLabel->text().isEmpty())
+    {
+        summary = ui->summaryLabel->text() + "\n" + summary;
+    }
+    ui->summaryLabel->setText(summary);
+    ui->progressLabel->clear();
+    releaseScanner();
+}
+
+void PatternSetWindow::onProgressTimeout()
+{
+    if (_scanner == NULL)
+    {
+        return;
+    }
+    ui->progressLabel->setText(tr("Scanned %1 of %2 characters").arg(_scanner->scannedLength()).arg(_testee.length()));
+}
+
+void PatternSetWindow::insertPatternRow(RegExpController *regexp)
+{
+    int row = ui->patternTable->rowCount();
+    ui->patternTable->insertRow(row);
+    ui->patternTable->setItem(row, NameColumn, new QTableWidgetItem(regexp->getName()));
+    ui->patternTable->setItem(row, PatternColumn, new QTableWidgetItem(regexp->getPattern()));
+
+    QComboBox *syntaxComboBox = new QComboBox(ui->patternTable);
+    syntaxComboBox->addItems(regexp->getPatternSyntaxList());
+    syntaxComboBox->setCurrentIndex(regexp->getPatternSyntax());
+    ui->patternTable->setCellWidget(row, SyntaxColumn, syntaxComboBox);
+
+    QTableWidgetItem *caseSensitiveItem = new QTableWidgetItem();
+    caseSensitiveItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+    caseSensitiveItem->setCheckState(regexp->getCaseSensitive() == Qt::CaseSensitive ? Qt::Checked : Qt::Unchecked);
+    ui->patternTable->setItem(row, CaseSensitiveColumn, caseSensitiveItem);
+
+    QTableWidgetItem *minimalItem = new QTableWidgetItem();
+    minimalItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable);
+    minimalItem->setCheckState(regexp->isMinimal() ? Qt::Checked : Qt::Unchecked);
+    ui->patternTable->setItem(row, MinimalColumn, minimalItem);
+
+    QTableWidgetItem *hitsItem = new QTableWidgetItem();
+    hitsItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+    ui->patternTable->setItem(row, HitsColumn, hitsItem);
+}
+
+QString PatternSetWindow::ruleName(int pattern) const
+{
+    QString name = _patternSet->at(pattern)->getName();
+    return name.isEmpty() ? QString("#%1").arg(pattern + 1) : name;
+}
+
+void PatternSetWindow::releaseScanner()
+{
+    _progressTimer->stop();
+    delete _scanner;
+    _scanner = NULL;
+    setRunning(false);
+}
+
+void PatternSetWindow::setRunning(bool running)
+{
+    ui->runButton->setEnabled(!running);
+    ui->cancelButton->setEnabled(running);
+    ui->addPatternButton->setEnabled(!running);
+    ui->removePatternButton->setEnabled(!running);
+    if (running)
+    {
+        _progressTimer->start(PROGRESS_INTERVAL_MS);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PATTERNSETWINDOW_H
+#define PATTERNSETWINDOW_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include "patternset.h"
+#include "patternsetscanner.h"
+
+namespace Ui {
+class PatternSetWindow;
+}
+
+/*
+ * Edits a pattern set and reports which of its rules hit where in the
+ * testee, all rules matched in one pass by PatternSetScanner.
+ */
+class PatternSetWindow : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PatternSetWindow(QWidget *parent = 0);
+    ~PatternSetWindow();
+    void run();
+    void cancel();
+    bool isRunning() const;
+    void clear();
+    void clearTestee();
+    void loadTesteeFromFile(const QString &filename);
+    bool saveToFile(const QString &filename);
+    bool loadFromFile(const QString &filename);
+    QString getFilename();
+    QString getFileError();
+    bool isPatternEmpty() const;
+    void syncUiToPatternSet();
+    void syncUiFromPatternSet();
+
+private slots:
+    void on_addPatternButton_clicked();
+    void on_removePatternButton_clicked();
+    void on_runButton_clicked();
+    void on_cancelButton_clicked();
+    void onScanFinished();
+    void onProgressTimeout();
+
+private:
+    void insertPatternRow(RegExpController *regexp);
+    QString ruleName(int pattern) const;
+    void releaseScanner();
+    void setRunning(bool running);
+
+    Ui::PatternSetWindow *ui;
+    PatternSet *_patternSet;
+    PatternSetScanner *_scanner;
+    QFutureWatcher<QVector<PatternSetHit> > *_watcher;
+    QTimer *_progressTimer;
+    QElapsedTimer _elapsed;
+    QString _testee;
+};
+
+#endif // PATTERNSETWINDOW_H
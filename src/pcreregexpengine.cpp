@@ -0,0 +1,156 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "pcreregexpengine.h"
+
+PcreRegExpEngine::PcreRegExpEngine(const QRegExp &options) :
+    _pattern(replaceAnchor(translatePattern(options), QChar('$'), "\\z")),
+    // As in QRegExp, '.' matches line breaks too.
+    _patternOptions(QRegularExpression::DotMatchesEverythingOption)
+{
+    if (options.caseSensitivity() == Qt::CaseInsensitive)
+    {
+        _patternOptions |= QRegularExpression::CaseInsensitiveOption;
+    }
+    if (options.isMinimal())
+    {
+        _patternOptions |= QRegularExpression::InvertedGreedinessOption;
+    }
+    _regexp = compile(_pattern);
+}
+
+RegExpEngine::Type PcreRegExpEngine::type() const
+{
+    return PcreQRegularExpression;
+}
+
+RegExpEngine *PcreRegExpEngine::clone() const
+{
+    // Copies share the compiled pattern, matching on it is thread-safe.
+    PcreRegExpEngine *engine = new PcreRegExpEngine(*this);
+    engine->_match = QRegularExpressionMatch();
+    return engine;
+}
+
+bool PcreRegExpEngine::isValid() const
+{
+    return _regexp.isValid();
+}
+
+QString PcreRegExpEngine::errorString() const
+{
+    return _regexp.errorString();
+}
+
+bool PcreRegExpEngine::exactMatch(const QString &str)
+{
+    if (_exactRegexp.pattern().isEmpty())
+    {
+        _exactRegexp = compile(QString("\\A(?:%1)\\z").arg(_pattern));
+    }
+    _match = _exactRegexp.match(str);
+    return _match.hasMatch();
+}
+
+int PcreRegExpEngine::indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode)
+{
+    if (caretMode == QRegExp::CaretAtOffset)
+    {
+        if (_caretAtOffsetRegexp.pattern().isEmpty())
+        {
+            _caretAtOffsetRegexp = compile(replaceAnchor(_pattern, QChar('^'), "\\G"));
+        }
+        _match = _caretAtOffsetRegexp.match(str, offset);
+    }
+    else if (caretMode == QRegExp::CaretWontMatch)
+    {
+        if (_caretWontMatchRegexp.pattern().isEmpty())
+        {
+            _caretWontMatchRegexp = compile(replaceAnchor(_pattern, QChar('^'), "(?!)"));
+        }
+        _match = _caretWontMatchRegexp.match(str, offset);
+    }
+    else
+    {
+        _match = _regexp.match(str, offset);
+    }
+    return pos(0);
+}
+
+int PcreRegExpEngine::captureCount() const
+{
+    return _regexp.captureCount();
+}
+
+int PcreRegExpEngine::pos(int nth) const
+{
+    return _match.hasMatch() ? _match.capturedStart(nth) : -1;
+}
+
+int PcreRegExpEngine::capturedLength(int nth) const
+{
+    if (!_match.hasMatch())
+    {
+        return nth == 0 ? -1 : 0;
+    }
+    return _match.capturedLength(nth);
+}
+
+QString PcreRegExpEngine::cap(int nth) const
+{
+    return _match.captured(nth);
+}
+
+QString PcreRegExpEngine::replaceAnchor(const QString &pattern, QChar anchor, const QString &replacement)
+{
+    QString result;
+    bool inClass = false;
+    int length = pattern.length();
+
+    result.reserve(length + 8);
+    for (int i = 0; i < length; ++i)
+    {
+        QChar ch = pattern.at(i);
+        if (ch == QChar('\\') && i + 1 < length)
+        {
+            result += ch;
+            result += pattern.at(++i);
+        }
+        else if (inClass)
+        {
+            inClass = (ch != QChar(']'));
+            result += ch;
+        }
+        else if (ch == QChar('['))
+        {
+            inClass = true;
+            result += ch;
+            // "[^" negates and "[]" or "[^]" starts with a literal ']'.
+            if (i + 1 < length && pattern.at(i + 1) == QChar('^'))
+            {
+                result += pattern.at(++i);
+            }
+            if (i + 1 < length && pattern.at(i + 1) == QChar(']'))
+            {
+                result += pattern.at(++i);
+            }
+        }
+        else if (ch == anchor)
+        {
+            result += replacement;
+        }
+        else
+        {
+            result += ch;
+        }
+    }
+    return result;
+}
+
+QRegularExpression PcreRegExpEngine::compile(const QString &pattern) const
+{
+    QRegularExpression regexp(pattern, _patternOptions);
+    regexp.optimize();
+    return regexp;
+}
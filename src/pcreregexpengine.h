@@ -0,0 +1,49 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PCREREGEXPENGINE_H
+#define PCREREGEXPENGINE_H
+
+#include <QRegularExpression>
+#include <QRegularExpressionMatch>
+#include "regexpengine.h"
+
+/*
+ * QRegularExpression (PCRE2) backend, JIT-compiled up front. Wildcard and
+ * FixedString patterns are translated to regular expressions, '.' matches
+ * line breaks as in QRegExp, minimal matching maps to inverted
+ * greediness, and the caret modes are emulated
+ * by rewriting '^' to "\G" (CaretAtOffset) or to a failing "(?!)"
+ * (CaretWontMatch). '$' is rewritten to "\z", as PCRE's also matches
+ * before a final line break and QRegExp's doesn't.
+ */
+class PcreRegExpEngine : public RegExpEngine
+{
+public:
+    explicit PcreRegExpEngine(const QRegExp &options);
+    Type type() const;
+    RegExpEngine *clone() const;
+    bool isValid() const;
+    QString errorString() const;
+    bool exactMatch(const QString &str);
+    int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode);
+    int captureCount() const;
+    int pos(int nth) const;
+    int capturedLength(int nth) const;
+    QString cap(int nth) const;
+
+private:
+    static QString replaceAnchor(const QString &pattern, QChar anchor, const QString &replacement);
+    QRegularExpression compile(const QString &pattern) const;
+
+    QString _pattern;
+    QRegularExpression::PatternOptions _patternOptions;
+    QRegularExpression _regexp;
+    QRegularExpression _caretAtOffsetRegexp;
+    QRegularExpression _caretWontMatchRegexp;
+    QRegularExpression _exactRegexp;
+    QRegularExpressionMatch _match;
+};
+
+#endif // PCREREGEXPENGINE_H
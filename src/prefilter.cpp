@@ -0,0 +1,446 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "prefilter.h"
+
+// Limits on the literal sets tracked while walking the pattern.
+#define MAX_SET_LITERALS 4
+#define MAX_EXACT_LITERALS 16
+#define MAX_LITERAL_LENGTH 64
+// Longer windows aren't worth the bookkeeping, search the testee instead.
+#define MAX_WINDOW_LENGTH (64 * 1024)
+// '\b' and '$' look at the character next to where they stand.
+#define WINDOW_CONTEXT_CHARS 1
+
+Prefilter::LiteralInfo::LiteralInfo() :
+    exact(false),
+    offset(0)
+{
+}
+
+Prefilter::Prefilter(const RegExpController &regexp) :
+    _usable(false),
+    _caseSensitivity(regexp.getRegExp().caseSensitivity()),
+    _maxLiteralOffset(-1),
+    _maxMatchLength(-1),
+    _windowed(false),
+    _automaton(regexp.getRegExp().caseSensitivity())
+{
+    // With CaretAtOffset '^' depends on where each search starts.
+    PatternParser parser(regexp.getRegExp());
+    if (!parser.isValid() || regexp.getCaretMode() == QRegExp::CaretAtOffset)
+    {
+        return;
+    }
+
+    LiteralInfo info = extract(parser.root());
+    if (info.literals.isEmpty() || shortest(info.literals) == 0)
+    {
+        return;
+    }
+
+    _literals = info.literals;
+    if (_caseSensitivity == Qt::CaseInsensitive)
+    {
+        for (int i = 0; i < _literals.size(); ++i)
+        {
+            _literals[i] = fold(_literals.at(i));
+        }
+        _literals.removeDuplicates();
+    }
+    _usable = true;
+
+    _maxMatchLength = parser.maxMatchLength();
+    if (_maxMatchLength > MAX_WINDOW_LENGTH)
+    {
+        _maxMatchLength = -1;
+    }
+    _maxLiteralOffset = info.exact ? 0 : info.offset;
+    if (_maxLiteralOffset < 0)
+    {
+        _maxLiteralOffset = _maxMatchLength;
+    }
+    _windowed = _maxMatchLength >= 0;
+    buildSearch();
+}
+
+/*
+ * Restores a prefilter from the results of an earlier analysis; literals
+ * are taken as already folded.
+ */
+Prefilter::Prefilter(const RegExpController &regexp, const QStringList &literals,
+                     int maxLiteralOffset, int maxMatchLength, bool windowed) :
+    _usable(!literals.isEmpty() && regexp.getCaretMode() != QRegExp::CaretAtOffset),
+    _literals(literals),
+    _caseSensitivity(regexp.getRegExp().caseSensitivity()),
+    _maxLiteralOffset(maxLiteralOffset),
+    _maxMatchLength(maxMatchLength),
+    _windowed(windowed),
+    _automaton(regexp.getRegExp().caseSensitivity())
+{
+    if (_usable)
+    {
+        buildSearch();
+    }
+}
+
+void Prefilter::buildSearch()
+{
+    if (_literals.size() == 1)
+    {
+        _matcher.setPattern(_literals.first());
+        _matcher.setCaseSensitivity(_caseSensitivity);
+    }
+    else
+    {
+        for (int i = 0; i < _literals.size(); ++i)
+        {
+            _automaton.addLiteral(_literals.at(i), i);
+        }
+        _automaton.build();
+    }
+}
+
+bool Prefilter::isUsable() const
+{
+    return _usable;
+}
+
+bool Prefilter::isWindowed() const
+{
+    return _windowed;
+}
+
+QStringList Prefilter::literals() const
+{
+    return _literals;
+}
+
+Qt::CaseSensitivity Prefilter::caseSensitivity() const
+{
+    return _caseSensitivity;
+}
+
+int Prefilter::maxLiteralOffset() const
+{
+    return _maxLiteralOffset;
+}
+
+int Prefilter::maxMatchLength() const
+{
+    return _maxMatchLength;
+}
+
+QString Prefilter::description() const
+{
+    QStringList quoted;
+    foreach (const QString &literal, _literals)
+    {
+        quoted << QString("\"%1\"").arg(literal);
+    }
+    QString description = quoted.join(" | ");
+    if (_caseSensitivity == Qt::CaseInsensitive)
+    {
+        description += tr(" (any case)");
+    }
+    if (_windowed)
+    {
+        description += tr(", matched within %1 chars around each hit").arg(_maxMatchLength);
+    }
+    return description;
+}
+
+/*
+ * Returns the start of the leftmost required literal at or after from,
+ * or -1 when there is none.
+ */
+int Prefilter::findLiteral(const QString &text, int from) const
+{
+    if (_literals.size() > 1)
+    {
+        return _automaton.indexIn(text, from);
+    }
+    if (_literals.first().length() == 1)
+    {
+        return text.indexOf(_literals.first().at(0), from, _caseSensitivity);
+    }
+    return _matcher.indexIn(text, from);
+}
+
+/*
+ * Confirms a candidate: returns the first match starting at or after from
+ * when one starts no later than literalPos (or anywhere, without a
+ * window), else -1. The engine's capture positions are relative to offset.
+ * exhausted tells that no match starts at or after from at all.
+ */
+int Prefilter::indexIn(RegExpEngine *engine, QRegExp::CaretMode caretMode, const QString &text,
+                       int from, int literalPos, int &offset, bool &exhausted) const
+{
+    int start = from;
+    if (_maxLiteralOffset >= 0)
+    {
+        start = qMax(from, literalPos - _maxLiteralOffset);
+    }
+    exhausted = false;
+
+    if (!_windowed)
+    {
+        offset = 0;
+        int pos = engine->indexIn(text, start, caretMode);
+        exhausted = (pos == -1);
+        return pos;
+    }
+
+    // A copy rather than raw data: engines keep their subject for cap().
+    int windowStart = qMax(0, start - windowPadding(0));
+    int windowEnd = int(qMin(qint64(text.length()), qint64(literalPos) + windowPadding(_maxMatchLength)));
+    QString window = text.mid(windowStart, windowEnd - windowStart);
+    offset = windowStart;
+    int pos = engine->indexIn(window, start - windowStart, caretMode);
+    if (pos == -1 || pos + windowStart > literalPos)
+    {
+        return -1;
+    }
+    return pos + windowStart;
+}
+
+/*
+ * How far from a match start a search for the match may read: its reach
+ * plus the context of an assertion at its end. Padding by windowPadding(0)
+ * before the first start gives an assertion there its context, too. Every
+ * window cut out of a longer testee is padded this way.
+ */
+int Prefilter::windowPadding(int maxMatchLength)
+{
+    return maxMatchLength + WINDOW_CONTEXT_CHARS;
+}
+
+QString Prefilter::fold(const QString &text)
+{
+    // Per code unit, so folded positions line up with the testee.
+    QString folded(text);
+    for (int i = 0; i < folded.length(); ++i)
+    {
+        folded[i] = folded.at(i).toLower();
+    }
+    return folded;
+}
+
+Prefilter::LiteralInfo Prefilter::extract(const PatternNode *node)
+{
+    LiteralInfo info;
+    switch (node->type)
+    {
+    case PatternNode::Set:
+    {
+        QVector<ushort> chars;
+        if (node->set.enumerate(chars, MAX_SET_LITERALS))
+        {
+            info.exact = true;
+            foreach (ushort ch, chars)
+            {
+                info.literals << QString(QChar(ch));
+            }
+        }
+        break;
+    }
+    case PatternNode::Sequence:
+        return extractSequence(node);
+    case PatternNode::Alternation:
+    {
+        // Any branch may match, so every branch has to require something.
+        bool required = true;
+        info.exact = true;
+        foreach (const PatternNode *child, node->children)
+        {
+            LiteralInfo branch = extract(child);
+            info.exact = info.exact && branch.exact;
+            required = required && !branch.literals.isEmpty();
+            info.literals += branch.literals;
+            int offset = branch.exact ? 0 : branch.offset;
+            info.offset = (info.offset < 0 || offset < 0) ? -1 : qMax(info.offset, offset);
+        }
+        info.literals.removeDuplicates();
+        if (info.literals.size() > MAX_EXACT_LITERALS || (!info.exact && !required))
+        {
+            info.exact = false;
+            info.literals.clear();
+        }
+        break;
+    }
+    case PatternNode::Group:
+        return extract(node->children.first());
+    case PatternNode::Repeat:
+    {
+        LiteralInfo body = extract(node->children.first());
+        if (node->max == 0)
+        {
+            info.exact = true;
+            info.literals << QString();
+        }
+        else if (node->min == 0)
+        {
+            break;
+        }
+        else if (body.exact && node->min == node->max)
+        {
+            QStringList run;
+            run << QString();
+            bool fits = true;
+            for (int i = 0; fits && i < node->min; ++i)
+            {
+                fits = cross(run, body.literals);
+            }
+            info.exact = fits;
+            info.literals = fits ? run : body.literals;
+        }
+        else
+        {
+            // The first repetition starts with the node.
+            info.literals = body.literals;
+            info.offset = body.exact ? 0 : body.offset;
+        }
+        break;
+    }
+    case PatternNode::BackReference:
+        break;
+    default:
+        // Empty and the assertions match the empty string.
+        info.exact = true;
+        info.literals << QString();
+        break;
+    }
+    return info;
+}
+
+Prefilter::LiteralInfo Prefilter::extractSequence(const PatternNode *node)
+{
+    // Exact children are concatenated into a run of literals; any other
+    // child ends the run. The best run, or required set of a child, wins.
+    QStringList run;
+    run << QString();
+    int runOffset = 0;
+    int position = 0;
+    bool allExact = true;
+    QStringList best;
+    int bestOffset = -1;
+
+    foreach (const PatternNode *child, node->children)
+    {
+        LiteralInfo info = extract(child);
+        if (run.size() == 1 && run.first().isEmpty())
+        {
+            runOffset = position;
+        }
+
+        if (!info.exact || !cross(run, info.literals))
+        {
+            allExact = false;
+            if (isBetter(run, runOffset, best, bestOffset))
+            {
+                best = run;
+                bestOffset = runOffset;
+            }
+            int childOffset = (position < 0 || info.offset < 0) ? -1 : position + info.offset;
+            if (!info.exact && isBetter(info.literals, childOffset, best, bestOffset))
+            {
+                best = info.literals;
+                bestOffset = childOffset;
+            }
+            run.clear();
+            if (info.exact)
+            {
+                run = info.literals;
+                runOffset = position;
+            }
+            else
+            {
+                run << QString();
+            }
+        }
+
+        int length = child->maxReach();
+        position = (position < 0 || length < 0) ? -1 : position + length;
+    }
+
+    LiteralInfo info;
+    if (allExact)
+    {
+        info.exact = true;
+        info.literals = run;
+        return info;
+    }
+    if (isBetter(run, runOffset, best, bestOffset))
+    {
+        best = run;
+        bestOffset = runOffset;
+    }
+    info.literals = best;
+    info.offset = bestOffset;
+    return info;
+}
+
+bool Prefilter::isBetter(const QStringList &literals, int offset, const QStringList &best, int bestOffset)
+{
+    int length = shortest(literals);
+    if (length == 0)
+    {
+        return false;
+    }
+    if (best.isEmpty())
+    {
+        return true;
+    }
+
+    // Longer literals give fewer false candidates, fewer ones a faster
+    // search, and a bounded offset a tighter window.
+    int bestLength = shortest(best);
+    if (length != bestLength)
+    {
+        return length > bestLength;
+    }
+    if (literals.size() != best.size())
+    {
+        return literals.size() < best.size();
+    }
+    return offset >= 0 && (bestOffset < 0 || offset < bestOffset);
+}
+
+bool Prefilter::cross(QStringList &run, const QStringList &literals)
+{
+    if (run.size() * literals.size() > MAX_EXACT_LITERALS)
+    {
+        return false;
+    }
+
+    QStringList product;
+    foreach (const QString &prefix, run)
+    {
+        foreach (const QString &literal, literals)
+        {
+            if (prefix.length() + literal.length() > MAX_LITERAL_LENGTH)
+            {
+                return false;
+            }
+            product << prefix + literal;
+        }
+    }
+    product.removeDuplicates();
+    run = product;
+    return true;
+}
+
+int Prefilter::shortest(const QStringList &literals)
+{
+    if (literals.isEmpty())
+    {
+        return 0;
+    }
+    int length = literals.first().length();
+    foreach (const QString &literal, literals)
+    {
+        length = qMin(length, literal.length());
+    }
+    return length;
+}
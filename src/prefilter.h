@@ -0,0 +1,85 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef PREFILTER_H
+#define PREFILTER_H
+
+#include <QtGlobal>
+#include <QCoreApplication>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+#include <QStringMatcher>
+#include "ahocorasick.h"
+#include "patternparser.h"
+#include "regexpcontroller.h"
+#include "regexpengine.h"
+
+/*
+ * Required literals of a pattern: every match contains at least one of
+ * literals(). A literal search can then find candidate positions, and the
+ * engine only has to confirm a match around each of them.
+ *
+ * When the reach of a match is bounded (PatternParser::maxMatchLength(),
+ * which counts what lookaheads read, up to MAX_WINDOW_LENGTH), confirmation
+ * runs inside a window of the testee: from the earliest start
+ * a match containing the literal can have to the latest end it can reach,
+ * padded by windowPadding(). Otherwise the
+ * engine searches on from the earliest start over the rest of the testee.
+ *
+ * Literals of case-insensitive patterns are folded to lower case.
+ * findLiteral() looks for them with the cheapest search that fits: a
+ * (vectorized) QChar search for a single character, a Boyer-Moore
+ * QStringMatcher for one literal, Aho-Corasick for several.
+ *
+ * A precompiled pattern library (see PatternLibrary) stores the analysis,
+ * so loading it only rebuilds the literal search.
+ */
+class Prefilter
+{
+    Q_DECLARE_TR_FUNCTIONS(Prefilter)
+public:
+    explicit Prefilter(const RegExpController &regexp);
+    Prefilter(const RegExpController &regexp, const QStringList &literals,
+              int maxLiteralOffset, int maxMatchLength, bool windowed);
+    bool isUsable() const;
+    bool isWindowed() const;
+    QStringList literals() const;
+    Qt::CaseSensitivity caseSensitivity() const;
+    int maxLiteralOffset() const;
+    int maxMatchLength() const;
+    QString description() const;
+    int findLiteral(const QString &text, int from) const;
+    int indexIn(RegExpEngine *engine, QRegExp::CaretMode caretMode, const QString &text,
+                int from, int literalPos, int &offset, bool &exhausted) const;
+    static QString fold(const QString &text);
+    static int windowPadding(int maxMatchLength);
+
+private:
+    struct LiteralInfo
+    {
+        LiteralInfo();
+        bool exact;
+        QStringList literals;
+        int offset;
+    };
+
+    void buildSearch();
+    LiteralInfo extract(const PatternNode *node);
+    LiteralInfo extractSequence(const PatternNode *node);
+    static bool isBetter(const QStringList &literals, int offset, const QStringList &best, int bestOffset);
+    static bool cross(QStringList &run, const QStringList &literals);
+    static int shortest(const QStringList &literals);
+
+    bool _usable;
+    QStringList _literals;
+    Qt::CaseSensitivity _caseSensitivity;
+    int _maxLiteralOffset;
+    int _maxMatchLength;
+    bool _windowed;
+    QStringMatcher _matcher;
+    AhoCorasick _automaton;
+};
+
+#endif // PREFILTER_H
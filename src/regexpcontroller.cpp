@@ -5,22 +5,67 @@
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
+#include <cstring>
 #include "regexpcontroller.h"
+#include "enginecache.h"
+#include "prefilter.h"
+#include "patternlibrary.h"
 
 #define BOOL_TO_STRING(_val_) ((_val_) ? "true" : "false")
-#define STRING_TO_BOOL(_val_) QRegExp("true|yes|1|on", Qt::CaseInsensitive).exactMatch(_val_)
+#define CAPTURE_KEY_PREFIX "capture"
+
+namespace
+{
+
+// Built once and shared by every controller; a rule library creates many.
+const QStringList &caretModeNames()
+{
+    static const QStringList names = QStringList() << "CaretAtZero" << "CaretAtOffset" <<
+                                     "CaretWontMatch";
+    return names;
+}
+
+const QStringList &patternSyntaxNames()
+{
+    static const QStringList names = QStringList() << "RegExp" << "RegExp2" <<
+                                     "Wildcard" << "WildcardUnix" <<
+                                     "FixedString" << "W3CXmlSchema11";
+    return names;
+}
+
+const QStringList &engineNames()
+{
+    static const QStringList names = RegExpEngine::typeNames();
+    return names;
+}
+
+bool keyIs(const QStringRef &key, const char *name)
+{
+    return key.compare(QLatin1String(name), Qt::CaseInsensitive) == 0;
+}
+
+bool isKeyChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == QLatin1Char('_');
+}
+
+}
 
 RegExpController::RegExpController(QObject *parent) :
     QObject(parent),
     _regexp(new QRegExp()),
-    _caretMode(QRegExp::CaretAtZero)
+    _caretMode(QRegExp::CaretAtZero),
+    _engineType(RegExpEngine::LegacyQRegExp),
+    _engine(NULL),
+    _prefilter(NULL),
+    _prefilterEnabled(true),
+    _matchOffset(0),
+    _testExactMatch(false),
+    _latencyBudget(0.0)
 {
-    _caretModeList << "CaretAtZero" << "CaretAtOffset" <<
-                   "CaretWontMatch";
-
-    _patternSyntaxList << "RegExp" << "RegExp2" <<
-                      "Wildcard" << "WildcardUnix" <<
-                          "FixedString" << "W3CXmlSchema11";
+    _caretModeList = caretModeNames();
+    _patternSyntaxList = patternSyntaxNames();
+    _engineList = engineNames();
 }
 
 RegExpController::~RegExpController()
@@ -28,9 +73,33 @@ RegExpController::~RegExpController()
     Q_ASSERT_X(_regexp != NULL,
                "RegExpController::~RegExpController",
                "_regexp object is missing(NULL).");
+    delete _prefilter;
+    delete _engine;
     delete _regexp;
 }
 
+/*
+ * Copying a QRegExp may touch the source's engine, so clones for worker
+ * threads have to be made up front, on the thread that owns other.
+ */
+void RegExpController::copyFrom(const RegExpController &other)
+{
+    *_regexp = *other._regexp;
+    _caretMode = other._caretMode;
+    _engineType = other._engineType;
+    _name = other._name;
+    _filename = other._filename;
+    _prefilterEnabled = other._prefilterEnabled;
+    _testCases = other._testCases;
+    _testExactMatch = other._testExactMatch;
+    _latencyBudget = other._latencyBudget;
+    invalidateEngine();
+    if (other._engine != NULL)
+    {
+        _engine = other._engine->clone();
+    }
+}
+
 const QStringList &RegExpController::getCaretModeList()
 {
     return _caretModeList;
@@ -61,6 +130,132 @@ QString RegExpController::patternSyntaxIdToString(QRegExp::PatternSyntax id)
     return _patternSyntaxList.at(id);
 }
 
+const QStringList &RegExpController::getEngineList()
+{
+    return _engineList;
+}
+
+RegExpEngine::Type RegExpController::engineStringToId(const QString &engine)
+{
+    int id = _engineList.indexOf(engine);
+    return id < 0 ? RegExpEngine::LegacyQRegExp : RegExpEngine::Type(id);
+}
+
+QString RegExpController::engineIdToString(RegExpEngine::Type id)
+{
+    return _engineList.at(id);
+}
+
+RegExpEngine::Type RegExpController::getEngine() const
+{
+    return _engineType;
+}
+
+void RegExpController::setEngine(RegExpEngine::Type engine)
+{
+    if (_engineType == engine)
+    {
+        return;
+    }
+    _engineType = engine;
+    invalidateEngine();
+}
+
+void RegExpController::setEngine(const QString &engine)
+{
+    setEngine(engineStringToId(engine));
+}
+
+RegExpEngine *RegExpController::engine() const
+{
+    if (_engine == NULL)
+    {
+        _engine = EngineCache::instance()->acquire(_engineType, *_regexp, _caretMode);
+    }
+    return _engine;
+}
+
+const QRegExp &RegExpController::getRegExp() const
+{
+    return *_regexp;
+}
+
+const QList<RegExpTestCase> &RegExpController::getTestCases() const
+{
+    return _testCases;
+}
+
+void RegExpController::setTestCases(const QList<RegExpTestCase> &testCases)
+{
+    _testCases = testCases;
+}
+
+bool RegExpController::isTestExactMatch() const
+{
+    return _testExactMatch;
+}
+
+void RegExpController::setTestExactMatch(bool exactMatch)
+{
+    _testExactMatch = exactMatch;
+}
+
+/*
+ * Time a test case may take in milliseconds, 0 for no budget.
+ */
+double RegExpController::getLatencyBudget() const
+{
+    return _latencyBudget;
+}
+
+void RegExpController::setLatencyBudget(double msecs)
+{
+    _latencyBudget = qMax(msecs, 0.0);
+}
+
+const Prefilter *RegExpController::prefilter() const
+{
+    if (_prefilter == NULL)
+    {
+        _prefilter = new Prefilter(*this);
+    }
+    return _prefilter;
+}
+
+/*
+ * Takes over a prefilter built for the current pattern and options, e.g.
+ * one restored from a pattern library. Changing them drops it again.
+ */
+void RegExpController::setPrefilter(Prefilter *prefilter)
+{
+    delete _prefilter;
+    _prefilter = prefilter;
+}
+
+void RegExpController::setPrefilterEnabled(bool enabled)
+{
+    _prefilterEnabled = enabled;
+}
+
+bool RegExpController::isPrefilterEnabled() const
+{
+    return _prefilterEnabled;
+}
+
+bool RegExpController::isPrefiltered() const
+{
+    return _prefilterEnabled && !engine()->searchesLiterals() && prefilter()->isUsable();
+}
+
+void RegExpController::invalidateEngine()
+{
+    delete _engine;
+    _engine = NULL;
+    delete _prefilter;
+    _prefilter = NULL;
+    _matchOffset = 0;
+}
+
 QRegExp::PatternSyntax RegExpController::getPatternSyntax() const
 {
     return _regexp->patternSyntax();
@@ -73,7 +268,12 @@ QRegExp::CaretMode RegExpController::getCaretMode() const
 
 void RegExpController::setCaretMode(QRegExp::CaretMode caretMode)
 {
+    if (_caretMode == caretMode)
+    {
+        return;
+    }
     _caretMode = caretMode;
+    invalidateEngine();
 }
 
 void RegExpController::setCaretMode(const QString &caretMode)
@@ -83,7 +283,12 @@ void RegExpController::setCaretMode(const QString &caretMode)
 
 void RegExpController::setPatternSyntax(QRegExp::PatternSyntax pattern)
 {
+    if (_regexp->patternSyntax() == pattern)
+    {
+        return;
+    }
     _regexp->setPatternSyntax(pattern);
+    invalidateEngine();
 }
 
 void RegExpController::setPatternSyntax(const QString &pattern)
@@ -93,7 +298,12 @@ void RegExpController::setPatternSyntax(const QString &pattern)
 
 void RegExpController::setPattern(const QString &pattern)
 {
+    if (_regexp->pattern() == pattern)
+    {
+        return;
+    }
     _regexp->setPattern(pattern);
+    invalidateEngine();
 }
 
 QString RegExpController::getPattern()
@@ -101,9 +311,24 @@ QString RegExpController::getPattern()
     return _regexp->pattern();
 }
 
+void RegExpController::setName(const QString &name)
+{
+    _name = name;
+}
+
+QString RegExpController::getName() const
+{
+    return _name;
+}
+
 void RegExpController::setCaseSensitive(Qt::CaseSensitivity caseSensitivity)
 {
+    if (_regexp->caseSensitivity() == caseSensitivity)
+    {
+        return;
+    }
     _regexp->setCaseSensitivity(caseSensitivity);
+    invalidateEngine();
 }
 
 Qt::CaseSensitivity RegExpController::getCaseSensitive()
@@ -113,42 +338,120 @@ Qt::CaseSensitivity RegExpController::getCaseSensitive()
 
 bool RegExpController::isPatternValid()
 {
-    return _regexp->isValid();
+    return engine()->isValid();
 }
 
 QString RegExpController::errorString()
 {
-    return _regexp->errorString();
+    return engine()->errorString();
 }
 
 bool RegExpController::exactMatch(const QString &str) const
 {
-    return _regexp->exactMatch(str);
+    _matchOffset = 0;
+    return engine()->exactMatch(str);
 }
 
 int RegExpController::indexIn(const QString &str, int offset) const
 {
-    return _regexp->indexIn(str, offset, _caretMode);
+    return indexIn(str, offset, _caretMode);
+}
+
+int RegExpController::indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode) const
+{
+    _matchOffset = 0;
+    if (offset < 0 || !isPrefiltered())
+    {
+        return engine()->indexIn(str, offset, caretMode);
+    }
+
+    const Prefilter *filter = prefilter();
+    int from = offset;
+    int literalPos;
+    while ((literalPos = filter->findLiteral(str, from)) != -1)
+    {
+        bool exhausted = false;
+        int pos = filter->indexIn(engine(), caretMode, str, from, literalPos, _matchOffset, exhausted);
+        if (pos != -1 || exhausted)
+        {
+            return pos;
+        }
+        // No match starts up to this literal, so none before the next one.
+        from = literalPos + 1;
+    }
+
+    // Leave the engine in its "no match" state, as a failed search would.
+    // A prefiltered pattern needs a literal, so it can't match "".
+    _matchOffset = 0;
+    return engine()->indexIn(QString(), 0, caretMode);
 }
 
 int RegExpController::captureCount() const
 {
-    return _regexp->captureCount();
+    return engine()->captureCount();
 }
 
 QString RegExpController::cap(int nth) const
 {
-    return _regexp->cap(nth);
+    return engine()->cap(nth);
+}
+
+int RegExpController::pos(int nth) const
+{
+    int pos = engine()->pos(nth);
+    return pos < 0 ? pos : pos + _matchOffset;
+}
+
+int RegExpController::capturedLength(int nth) const
+{
+    return engine()->capturedLength(nth);
 }
 
 QStringList RegExpController::capturedTexts() const
 {
-    return _regexp->capturedTexts();
+    return engine()->capturedTexts();
+}
+
+/*
+ * Number of values appendSpans() adds per match: a (pos, length) pair for
+ * the whole match and one for every capture.
+ */
+int RegExpController::spanStride() const
+{
+    return 2 * (engine()->captureCount() + 1);
+}
+
+/*
+ * Appends the last match's spans; an unmatched capture gets a pos of -1.
+ */
+void RegExpController::appendSpans(QVector<qint64> &spans) const
+{
+    RegExpEngine *regexp = engine();
+    int captureCount = regexp->captureCount();
+    for (int i = 0; i <= captureCount; ++i)
+    {
+        int pos = regexp->pos(i);
+        spans << (pos < 0 ? pos : pos + _matchOffset) << regexp->capturedLength(i);
+    }
+}
+
+QStringRef RegExpController::spanRef(const QString &subject, qint64 pos, qint64 length)
+{
+    if (pos < 0)
+    {
+        return QStringRef();
+    }
+    return subject.midRef(int(pos), int(length));
 }
 
 void RegExpController::setMinimal(bool minimal)
 {
-    return _regexp->setMinimal(minimal);
+    if (_regexp->isMinimal() == minimal)
+    {
+        return;
+    }
+    _regexp->setMinimal(minimal);
+    invalidateEngine();
 }
 
 bool RegExpController::isMinimal() const
@@ -158,7 +461,7 @@ bool RegExpController::isMinimal() const
 
 int RegExpController::matchedLength() const
 {
-    return _regexp->matchedLength();
+    return engine()->matchedLength();
 }
 
 bool RegExpController::saveToFile(const QString &filename)
@@ -170,39 +473,178 @@ bool RegExpController::saveToFile(const QString &filename)
     }
 
     QTextStream stream(&file);
+    saveToStream(stream);
+    file.close();
 
+    _filename = filename;
+
+    return true;
+}
+
+void RegExpController::saveToStream(QTextStream &stream)
+{
     stream << "[Pattern]" << endl;
+    if (!_name.isEmpty())
+    {
+        stream << "name = " << _name << endl;
+    }
     stream << "pattern = " << _regexp->pattern() << endl;
     stream << "patternSyntax = " << patternSyntaxIdToString(_regexp->patternSyntax()) << endl;
     stream << "caretMode = " << caretModeIdToString(_caretMode) << endl;
     stream << "caseSensitivity = " << BOOL_TO_STRING(_regexp->caseSensitivity()) << endl;
     stream << "minimal = " << BOOL_TO_STRING(_regexp->isMinimal()) << endl;
+    stream << "engine = " << engineIdToString(_engineType) << endl;
+    if (_testExactMatch)
+    {
+        stream << "testMethod = exactMatch" << endl;
+    }
+    if (_latencyBudget > 0.0)
+    {
+        stream << "latencyBudgetMs = " << _latencyBudget << endl;
+    }
+    foreach (const RegExpTestCase &testCase, _testCases)
+    {
+        stream << (testCase.mustMatch ? "mustMatch = " : "mustNotMatch = ") << quoteValue(testCase.text) << endl;
+        QMapIterator<int, QString> it(testCase.captures);
+        while (it.hasNext())
+        {
+            it.next();
+            stream << "capture" << it.key() << " = " << quoteValue(it.value()) << endl;
+        }
+    }
+}
+
+bool RegExpController::loadFromFile(const QString &filename)
+{
+    if (PatternLibrary::isLibrary(filename))
+    {
+        // As with a pattern set file, the first pattern is loaded.
+        PatternLibrary library;
+        if (!library.open(filename) || !library.load(0, *this))
+        {
+            _fileError = library.getError();
+            return false;
+        }
+        _filename = filename;
+        return true;
+    }
+
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly|QFile::Text))
+    {
+        _fileError = file.errorString();
+        return false;
+    }
 
+    QTextStream stream(&file);
+    QList<QStringList> sections = readSections(stream);
     file.close();
+    if (sections.isEmpty())
+    {
+        _fileError = QString("Error no pattern found");
+        return false;
+    }
 
+    // A pattern set file loads its first pattern here.
+    if (!loadFromSection(sections.first()))
+    {
+        return false;
+    }
     _filename = filename;
 
     return true;
 }
 
-bool RegExpController::loadFromFile(const QString &filename)
+QList<QStringList> RegExpController::readSections(QTextStream &stream)
 {
-    QFile file(filename);
-    if (!file.open(QFile::ReadOnly|QFile::Text))
+    // Every [Pattern] header starts a section. Lines before the first
+    // header form one too, as older files may lack it.
+    QList<QStringList> sections;
+    bool inSection = false;
+    while (!stream.atEnd())
+    {
+        QString line = stream.readLine().trimmed();
+        if (line.compare("[Pattern]", Qt::CaseInsensitive) == 0)
+        {
+            sections << QStringList();
+            inSection = true;
+            continue;
+        }
+        if (!inSection)
+        {
+            if (line.isEmpty())
+            {
+                continue;
+            }
+            sections << QStringList();
+            inSection = true;
+        }
+        sections.last() << line;
+    }
+    return sections;
+}
+
+/*
+ * Splits a "key = value" line without building any strings; the value is
+ * trimmed. Returns false for lines of any other shape.
+ */
+bool RegExpController::splitKeyValue(const QString &line, QStringRef &key, QStringRef &value)
+{
+    const QChar *data = line.constData();
+    int length = line.length();
+    int pos = 0;
+    while (pos < length && data[pos].isSpace())
+    {
+        ++pos;
+    }
+    int keyStart = pos;
+    while (pos < length && isKeyChar(data[pos]))
+    {
+        ++pos;
+    }
+    int keyEnd = pos;
+    while (pos < length && data[pos].isSpace())
+    {
+        ++pos;
+    }
+    if (keyEnd == keyStart || pos == length || data[pos] != QLatin1Char('='))
     {
         return false;
     }
+    ++pos;
+    while (pos < length && data[pos].isSpace())
+    {
+        ++pos;
+    }
+    int valueEnd = length;
+    while (valueEnd > pos && data[valueEnd - 1].isSpace())
+    {
+        --valueEnd;
+    }
+    key = QStringRef(&line, keyStart, keyEnd - keyStart);
+    value = QStringRef(&line, pos, valueEnd - pos);
+    return true;
+}
 
-    QRegExp keyValuePattern("\\s*(\\w+)\\s*=\\s*(.*)");
-    QTextStream stream(&file);
-    QString line;
+bool RegExpController::stringToBool(const QStringRef &value)
+{
+    return keyIs(value, "true") || keyIs(value, "yes") || keyIs(value, "1") || keyIs(value, "on");
+}
+
+bool RegExpController::loadFromSection(const QStringList &lines)
+{
+    QString name;
     QString pattern("");
     QRegExp::PatternSyntax patternSyntax = QRegExp::RegExp;
     QRegExp::CaretMode caretMode = QRegExp::CaretAtZero;
     Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive;
     bool minimal = false;
-    QString key;
-    QString value;
+    RegExpEngine::Type engine = RegExpEngine::LegacyQRegExp;
+    QList<RegExpTestCase> testCases;
+    bool testExactMatch = false;
+    double latencyBudget = 0.0;
+    QStringRef key;
+    QStringRef value;
     int lineNum = 0;
     bool parseSuccessful = false;
 
@@ -210,36 +652,67 @@ bool RegExpController::loadFromFile(const QString &filename)
 
     try
     {
-        while (!stream.atEnd())
+        foreach (const QString &line, lines)
         {
             lineNum ++;
-            line = stream.readLine().trimmed();
-            if (!keyValuePattern.exactMatch(line))
+            if (!splitKeyValue(line, key, value))
             {
                 continue;
             }
-            key = keyValuePattern.cap(1);
-            value = keyValuePattern.cap(2).trimmed();
-            // qDebug() << QString("%1 = %2").arg(key).arg(value);
-            if (key.compare("pattern", Qt::CaseInsensitive) == 0)
+            if (keyIs(key, "name"))
             {
-                pattern = value;
+                name = value.toString();
             }
-            else if (key.compare("patternSyntax", Qt::CaseInsensitive) == 0)
+            else if (keyIs(key, "pattern"))
             {
-                patternSyntax = patternSyntaxStringToId(value);
+                pattern = value.toString();
             }
-            else if (key.compare("caretMode", Qt::CaseInsensitive) == 0)
+            else if (keyIs(key, "patternSyntax"))
             {
-                caretMode = caretModeStringToId(value);
+                patternSyntax = patternSyntaxStringToId(value.toString());
             }
-            else if (key.compare("caseSensitivity", Qt::CaseInsensitive) == 0)
+            else if (keyIs(key, "caretMode"))
             {
-                caseSensitivity = STRING_TO_BOOL(value) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+                caretMode = caretModeStringToId(value.toString());
             }
-            else if (key.compare("minimal", Qt::CaseInsensitive) == 0)
+            else if (keyIs(key, "caseSensitivity"))
             {
-                minimal = STRING_TO_BOOL(value);
+                caseSensitivity = stringToBool(value) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+            }
+            else if (keyIs(key, "minimal"))
+            {
+                minimal = stringToBool(value);
+            }
+            else if (keyIs(key, "engine"))
+            {
+                engine = engineStringToId(value.toString());
+            }
+            else if (keyIs(key, "testMethod"))
+            {
+                testExactMatch = keyIs(value, "exactMatch");
+            }
+            else if (keyIs(key, "latencyBudgetMs"))
+            {
+                latencyBudget = value.toDouble();
+            }
+            else if (keyIs(key, "mustMatch") || keyIs(key, "mustNotMatch"))
+            {
+                RegExpTestCase testCase;
+                testCase.text = unquoteValue(value.toString());
+                testCase.mustMatch = keyIs(key, "mustMatch");
+                testCases << testCase;
+            }
+            else if (key.startsWith(QLatin1String(CAPTURE_KEY_PREFIX), Qt::CaseInsensitive) &&
+                     !testCases.isEmpty() && testCases.last().mustMatch)
+            {
+                // Expected captures belong to the must-match case before them.
+                int prefix = int(strlen(CAPTURE_KEY_PREFIX));
+                bool ok;
+                int index = QStringRef(&line, key.position() + prefix, key.length() - prefix).toInt(&ok);
+                if (ok)
+                {
+                    testCases.last().captures.insert(index, unquoteValue(value.toString()));
+                }
             }
         }
         parseSuccessful = true;
@@ -249,16 +722,19 @@ bool RegExpController::loadFromFile(const QString &filename)
         _fileError = QString("Error(line#=%1) bad syntax or unknown items").arg(lineNum);
     }
 
-    file.close();
-
     if (parseSuccessful)
     {
+        _name = name;
         _regexp->setPattern(pattern);
         _regexp->setPatternSyntax(patternSyntax);
         _caretMode = caretMode;
         _regexp->setCaseSensitivity(caseSensitivity);
         _regexp->setMinimal(minimal);
-        _filename = filename;
+        _engineType = engine;
+        _testCases = testCases;
+        _testExactMatch = testExactMatch;
+        setLatencyBudget(latencyBudget);
+        invalidateEngine();
     }
 
     return parseSuccessful;
@@ -274,7 +750,176 @@ QString RegExpController::getFileError() const
     return _fileError;
 }
 
+/*
+ * Test texts are written in double quotes with C-style escapes, so they
+ * keep their surrounding spaces and may span lines.
+ */
+QString RegExpController::quoteValue(const QString &value)
+{
+    QString quoted("\"");
+    quoted.reserve(value.length() + 2);
+    foreach (QChar ch, value)
+    {
+        switch (ch.unicode())
+        {
+        case '"': quoted += "\\\""; break;
+        case '\\': quoted += "\\\\"; break;
+        case '\t': quoted += "\\t"; break;
+        case '\n': quoted += "\\n"; break;
+        case '\r': quoted += "\\r"; break;
+        default: quoted += ch; break;
+        }
+    }
+    return quoted + '"';
+}
+
+/*
+ * An unquoted value is taken as it is.
+ */
+QString RegExpController::unquoteValue(const QString &value)
+{
+    if (value.length() < 2 || !value.startsWith('"') || !value.endsWith('"'))
+    {
+        return value;
+    }
+
+    QString unquoted;
+    unquoted.reserve(value.length());
+    for (int i = 1; i < value.length() - 1; ++i)
+    {
+        QChar ch = value.at(i);
+        if (ch != '\\' || i + 1 == value.length() - 1)
+        {
+            unquoted += ch;
+            continue;
+        }
+        ch = value.at(++i);
+        switch (ch.unicode())
+        {
+        case 't': unquoted += '\t'; break;
+        case 'n': unquoted += '\n'; break;
+        case 'r': unquoted += '\r'; break;
+        default: unquoted += ch; break;
+        }
+    }
+    return unquoted;
+}
+
 QString RegExpController::generatePatternForCode() const
 {
     return _regexp->pattern().replace("\\", "\\\\");
 }
+
+RegExpMatchIterator::RegExpMatchIterator(const RegExpController &regexp, const QString &text, int from) :
+    _regexp(regexp),
+    _text(text),
+    _caretMode(regexp.getCaretMode()),
+    _from(qMax(from, 0)),
+    _pos(-1),
+    _length(0),
+    _matches(0),
+    _maxMatches(0),
+    _maxMsecs(0),
+    _limited(false)
+{
+    _timer.start();
+}
+
+void RegExpMatchIterator::setMaxMatches(int maxMatches)
+{
+    _maxMatches = qMax(maxMatches, 0);
+}
+
+void RegExpMatchIterator::setMaxMsecs(qint64 maxMsecs)
+{
+    _maxMsecs = qMax(maxMsecs, qint64(0));
+}
+
+void RegExpMatchIterator::setCaretMode(QRegExp::CaretMode caretMode)
+{
+    _caretMode = caretMode;
+}
+
+/*
+ * Moves the next search forward to from, when the caller knows no match
+ * starts before it; never back, so matches stay disjoint.
+ */
+void RegExpMatchIterator::skipTo(int from)
+{
+    _from = qMax(_from, from);
+}
+
+/*
+ * Finds the next match; false at the end of the text or once a limit is
+ * reached.
+ */
+bool RegExpMatchIterator::next()
+{
+    if (_from > _text.length())
+    {
+        return false;
+    }
+    if ((_maxMatches > 0 && _matches >= _maxMatches) || (_maxMsecs > 0 && _timer.elapsed() >= _maxMsecs))
+    {
+        _limited = true;
+        return false;
+    }
+
+    _pos = _regexp.indexIn(_text, _from, _caretMode);
+    if (_pos == -1)
+    {
+        _length = 0;
+        _from = _text.length() + 1;
+        return false;
+    }
+    _length = _regexp.matchedLength();
+    _from = _length > 0 ? _pos + _length : nextCodePoint(_text, _pos);
+    if (_caretMode == QRegExp::CaretAtOffset)
+    {
+        _caretMode = QRegExp::CaretWontMatch;
+    }
+    _matches ++;
+    return true;
+}
+
+int RegExpMatchIterator::pos() const
+{
+    return _pos;
+}
+
+int RegExpMatchIterator::matchedLength() const
+{
+    return _length;
+}
+
+/*
+ * Where the next search starts; past the end of the text once the
+ * iteration has finished.
+ */
+int RegExpMatchIterator::nextFrom() const
+{
+    return _from;
+}
+
+int RegExpMatchIterator::matchCount() const
+{
+    return _matches;
+}
+
+bool RegExpMatchIterator::isLimited() const
+{
+    return _limited;
+}
+
+/*
+ * The position after the code point at pos, which never splits a
+ * surrogate pair.
+ */
+int RegExpMatchIterator::nextCodePoint(const QString &text, int pos)
+{
+    if (pos + 1 < text.length() && text.at(pos).isHighSurrogate() && text.at(pos + 1).isLowSurrogate())
+    {
+        return pos + 2;
+    }
+    return pos + 1;
+}
@@ -6,23 +6,68 @@
 #define REGEXPCONTROLLER_H
 
 #include <QtGlobal>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QRegExp>
 #include <QString>
 #include <QStringList>
+#include <QList>
+#include <QMap>
+#include <QVector>
+#include <QTextStream>
+#include "regexpengine.h"
 
+class Prefilter;
+
+/*
+ * A test case embedded in a pattern file: a text the pattern must or must
+ * not match and, for a must-match case, the captures expected of its
+ * first match by capture number.
+ */
+struct RegExpTestCase
+{
+    RegExpTestCase() : mustMatch(true) {}
+
+    QString text;
+    bool mustMatch;
+    QMap<int, QString> captures;
+};
+
+/*
+ * The pattern, its options and the engine matching it. indexIn() first
+ * looks for the literals every match has to contain (see Prefilter) and
+ * only runs the engine around them; positions reported afterwards are
+ * always positions in the string passed to indexIn().
+ *
+ * appendSpans() reports the last match as (pos, length) pairs, so callers
+ * can keep results as offsets into the testee they already hold and only
+ * build strings (spanRef() gives a view without copying) when displaying
+ * or exporting them. With the QRegExp engine only the whole match is
+ * reported without a copy, see LegacyRegExpEngine.
+ *
+ * A pattern file may carry test cases with a per-case latency budget for
+ * the corpus runner (see CorpusRunner). They are kept as loaded and
+ * written back on save.
+ */
 class RegExpController : public QObject
 {
     Q_OBJECT    
 public:
     explicit RegExpController(QObject *parent = 0);
     ~RegExpController();
+    void copyFrom(const RegExpController &other);
     const QStringList &getCaretModeList();
     const QStringList &getPatternSyntaxList();
     QRegExp::CaretMode caretModeStringToId(const QString &caretMode);
     QString caretModeIdToString(QRegExp::CaretMode id);
     QRegExp::PatternSyntax patternSyntaxStringToId(const QString &patternSyntax);
     QString patternSyntaxIdToString(QRegExp::PatternSyntax id);
+    const QStringList &getEngineList();
+    RegExpEngine::Type engineStringToId(const QString &engine);
+    QString engineIdToString(RegExpEngine::Type id);
+    RegExpEngine::Type getEngine() const;
+    void setEngine(RegExpEngine::Type engine);
+    void setEngine(const QString &engine);
     QRegExp::PatternSyntax getPatternSyntax() const;
     QRegExp::CaretMode getCaretMode() const;
     void setCaretMode(QRegExp::CaretMode caretMode);
@@ -31,34 +76,118 @@ public:
     void setPatternSyntax(const QString &pattern);
     void setPattern(const QString &pattern);
     QString getPattern();
+    void setName(const QString &name);
+    QString getName() const;
     void setCaseSensitive(Qt::CaseSensitivity caseSensitivity);
     Qt::CaseSensitivity getCaseSensitive();
     bool isPatternValid();
     QString errorString();
     bool exactMatch(const QString &str) const;
     int	indexIn(const QString &str, int offset=0) const;
+    int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode) const;
     int captureCount() const;
     QString cap(int nth=0) const;
+    int pos(int nth=0) const;
+    int capturedLength(int nth=0) const;
     QStringList capturedTexts() const;
+    int spanStride() const;
+    void appendSpans(QVector<qint64> &spans) const;
+    static QStringRef spanRef(const QString &subject, qint64 pos, qint64 length);
     void setMinimal(bool minimal);
     bool isMinimal() const;
     int matchedLength() const;
     bool saveToFile(const QString &filename);
     bool loadFromFile(const QString &filename);
+    void saveToStream(QTextStream &stream);
+    bool loadFromSection(const QStringList &lines);
+    static QList<QStringList> readSections(QTextStream &stream);
     QString getFilename() const;
     QString getFileError() const;
     QString generatePatternForCode() const;
+    RegExpEngine *engine() const;
+    const Prefilter *prefilter() const;
+    void setPrefilterEnabled(bool enabled);
+    bool isPrefilterEnabled() const;
+    bool isPrefiltered() const;
+    void setPrefilter(Prefilter *prefilter);
+    const QRegExp &getRegExp() const;
+    const QList<RegExpTestCase> &getTestCases() const;
+    void setTestCases(const QList<RegExpTestCase> &testCases);
+    bool isTestExactMatch() const;
+    void setTestExactMatch(bool exactMatch);
+    double getLatencyBudget() const;
+    void setLatencyBudget(double msecs);
 signals:
     
 public slots:
 
 private:
+    void invalidateEngine();
+    static QString quoteValue(const QString &value);
+    static bool splitKeyValue(const QString &line, QStringRef &key, QStringRef &value);
+    static bool stringToBool(const QStringRef &value);
+    static QString unquoteValue(const QString &value);
+
     QStringList _caretModeList;
     QStringList _patternSyntaxList;
+    QStringList _engineList;
     QRegExp *_regexp;
     QRegExp::CaretMode _caretMode;
+    RegExpEngine::Type _engineType;
+    mutable RegExpEngine *_engine;
+    mutable Prefilter *_prefilter;
+    bool _prefilterEnabled;
+    mutable int _matchOffset;
+    QString _name;
     QString _filename;
     QString _fileError;
+    QList<RegExpTestCase> _testCases;
+    bool _testExactMatch;
+    double _latencyBudget;
+};
+
+/*
+ * Steps through the successive matches of a controller in a string, as a
+ * global search does; after each next() the controller holds that match
+ * (cap(), pos(), appendSpans() ...). The search resumes at the end of a
+ * match, or one code point past an empty one, so patterns such as "a*"
+ * come to an end. With CaretAtOffset '^' only anchors where the iteration
+ * started, not where each later search resumes.
+ *
+ * setCaretMode() overrides the controller's caret mode, for a text that
+ * is a window cut out of a longer testee.
+ *
+ * setMaxMatches() and setMaxMsecs() stop the iteration early (0 means no
+ * limit); isLimited() then tells that it didn't reach the end.
+ */
+class RegExpMatchIterator
+{
+public:
+    RegExpMatchIterator(const RegExpController &regexp, const QString &text, int from = 0);
+    void setMaxMatches(int maxMatches);
+    void setMaxMsecs(qint64 maxMsecs);
+    void setCaretMode(QRegExp::CaretMode caretMode);
+    void skipTo(int from);
+    bool next();
+    int pos() const;
+    int matchedLength() const;
+    int nextFrom() const;
+    int matchCount() const;
+    bool isLimited() const;
+    static int nextCodePoint(const QString &text, int pos);
+
+private:
+    const RegExpController &_regexp;
+    QString _text;
+    QRegExp::CaretMode _caretMode;
+    int _from;
+    int _pos;
+    int _length;
+    int _matches;
+    int _maxMatches;
+    qint64 _maxMsecs;
+    QElapsedTimer _timer;
+    bool _limited;
 };
 
 #endif // REGEXPCONTROLLER_H
@@ -0,0 +1,164 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "regexpengine.h"
+#include "globregexpengine.h"
+#include "lazydfaregexpengine.h"
+#include "legacyregexpengine.h"
+#include "pcreregexpengine.h"
+#include "stdregexpengine.h"
+
+// Characters with a meaning in both PCRE and ECMAScript patterns.
+#define REGEXP_SPECIAL_CHARS "\\^$.|?*+()[]{}/"
+
+RegExpEngine::~RegExpEngine()
+{
+}
+
+RegExpEngine *RegExpEngine::create(RegExpEngine::Type type, const QRegExp &options)
+{
+    switch (type)
+    {
+    case PcreQRegularExpression:
+        return new PcreRegExpEngine(options);
+    case StdRegex:
+        return new StdRegExpEngine(options);
+    case LinearLazyDfa:
+        return new LazyDfaRegExpEngine(options);
+    case LegacyQRegExp:
+    default:
+        // QRegExp runs fixed strings and wildcards through its general
+        // matcher; they need no backtracking.
+        if (GlobRegExpEngine::supports(options))
+        {
+            return new GlobRegExpEngine(options);
+        }
+        return new LegacyRegExpEngine(options);
+    }
+}
+
+QStringList RegExpEngine::typeNames()
+{
+    QStringList names;
+    names << "QRegExp" << "QRegularExpression" << "std::regex" << "Lazy DFA";
+    return names;
+}
+
+QString RegExpEngine::name() const
+{
+    return typeNames().at(type());
+}
+
+QStringList RegExpEngine::capturedTexts() const
+{
+    QStringList texts;
+    for (int i = 0; i <= captureCount(); ++i)
+    {
+        texts << cap(i);
+    }
+    return texts;
+}
+
+int RegExpEngine::matchedLength() const
+{
+    return capturedLength(0);
+}
+
+/*
+ * Engines that already search for the pattern's literals themselves gain
+ * nothing from a prefilter doing the same first.
+ */
+bool RegExpEngine::searchesLiterals() const
+{
+    return false;
+}
+
+QString RegExpEngine::translatePattern(const QRegExp &options)
+{
+    switch (options.patternSyntax())
+    {
+    case QRegExp::FixedString:
+        return escapeLiteral(options.pattern());
+    case QRegExp::Wildcard:
+        return wildcardToRegExp(options.pattern(), false);
+    case QRegExp::WildcardUnix:
+        return wildcardToRegExp(options.pattern(), true);
+    default:
+        return options.pattern();
+    }
+}
+
+QString RegExpEngine::escapeLiteral(const QString &text)
+{
+    static const QString specialChars(REGEXP_SPECIAL_CHARS);
+    QString escaped;
+    escaped.reserve(text.length() * 2);
+    foreach (QChar ch, text)
+    {
+        if (specialChars.contains(ch))
+        {
+            escaped += QChar('\\');
+        }
+        escaped += ch;
+    }
+    return escaped;
+}
+
+QString RegExpEngine::wildcardToRegExp(const QString &pattern, bool unixStyle)
+{
+    QString regexp;
+    int length = pattern.length();
+
+    for (int i = 0; i < length; ++i)
+    {
+        QChar ch = pattern.at(i);
+        if (ch == QChar('*'))
+        {
+            regexp += ".*";
+        }
+        else if (ch == QChar('?'))
+        {
+            regexp += QChar('.');
+        }
+        else if (ch == QChar('\\') && unixStyle && i + 1 < length)
+        {
+            regexp += escapeLiteral(pattern.at(++i));
+        }
+        else if (ch == QChar('['))
+        {
+            // "[!...]" and "[^...]" negate; a leading ']' is literal.
+            int j = i + 1;
+            if (j < length && (pattern.at(j) == QChar('!') || pattern.at(j) == QChar('^')))
+            {
+                ++j;
+            }
+            if (j < length && pattern.at(j) == QChar(']'))
+            {
+                ++j;
+            }
+            int close = pattern.indexOf(QChar(']'), j);
+            if (close == -1)
+            {
+                regexp += escapeLiteral(ch);
+                continue;
+            }
+
+            QString set = pattern.mid(i + 1, close - i - 1);
+            if (set.startsWith(QChar('!')))
+            {
+                set[0] = QChar('^');
+            }
+            set.replace(QChar('\\'), QString("\\\\"));
+            set.replace(QChar('['), QString("\\["));
+            set.replace(QChar(']'), QString("\\]"));
+            regexp += QChar('[') + set + QChar(']');
+            i = close;
+        }
+        else
+        {
+            regexp += escapeLiteral(ch);
+        }
+    }
+    return regexp;
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef REGEXPENGINE_H
+#define REGEXPENGINE_H
+
+#include <QtGlobal>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+
+/*
+ * Matching backend behind RegExpController. The pattern and its options
+ * (syntax, case sensitivity, minimal) are always described by a QRegExp;
+ * each engine compiles that description into its own representation and
+ * keeps the capture state of its last match.
+ */
+class RegExpEngine
+{
+public:
+    enum Type
+    {
+        LegacyQRegExp,
+        PcreQRegularExpression,
+        StdRegex,
+        LinearLazyDfa
+    };
+
+    virtual ~RegExpEngine();
+    static RegExpEngine *create(Type type, const QRegExp &options);
+    static QStringList typeNames();
+    virtual Type type() const = 0;
+    virtual QString name() const;
+    virtual RegExpEngine *clone() const = 0;
+    virtual bool isValid() const = 0;
+    virtual QString errorString() const = 0;
+    virtual bool exactMatch(const QString &str) = 0;
+    virtual int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode) = 0;
+    virtual int captureCount() const = 0;
+    virtual int pos(int nth) const = 0;
+    virtual int capturedLength(int nth) const = 0;
+    virtual QString cap(int nth) const = 0;
+    virtual QStringList capturedTexts() const;
+    virtual int matchedLength() const;
+    virtual bool searchesLiterals() const;
+    static QString translatePattern(const QRegExp &options);
+
+protected:
+    static QString escapeLiteral(const QString &text);
+    static QString wildcardToRegExp(const QString &pattern, bool unixStyle);
+};
+
+#endif // REGEXPENGINE_H
@@ -3,44 +3,95 @@
  * file 'LICENSE.txt', which is part of this source code package.
  */
 #include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QTextStream>
 #include <QDebug>
+#include <QHeaderView>
 #include "regextesterwindow.h"
 #include "ui_regextesterwindow.h"
+#include "patternanalyzer.h"
+#include "patternparser.h"
+#include "matchhighlighter.h"
+#include "lazydfa.h"
+#include "prefilter.h"
+#include "parallelscanner.h"
+#include "compressedreader.h"
+#include "regexpengine.h"
+
+// Rows sampled when fitting the result columns to their contents.
+#define RESIZE_PRECISION_ROWS 200
+// Larger testee files are mapped and scanned in chunks instead of loaded.
+#define STREAMING_THRESHOLD (16 * 1024 * 1024)
+#define STREAMING_PREVIEW_BYTES (64 * 1024)
+// Live mode waits for a pause in typing, then rescans the edited region
+// plus the pattern's longest match on both sides.
+#define LIVE_DEBOUNCE_MS 300
+// Profile table entries show at most this much of their pattern text.
+#define MAX_PROFILE_LABEL_CHARS 40
 
 RegexTesterWindow::RegexTesterWindow(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::RegexTesterWindow),
-    _regexp(new RegExpController(this))
+    _regexp(new RegExpController(this)),
+    _resultModel(new MatchResultModel(this)),
+    _worker(NULL),
+    _fileSearcher(NULL),
+    _searchedFiles(0),
+    _searchedMatches(0),
+    _timeoutTimer(new QTimer(this)),
+    _liveTimer(new QTimer(this)),
+    _liveCaptureCount(0)
 {
     ui->setupUi(this);
     ui->caretModeComboBox->addItems(_regexp->getCaretModeList());
     ui->patternSyntaxComboBox->addItems(_regexp->getPatternSyntaxList());
+    ui->engineComboBox->addItems(_regexp->getEngineList());
+    ui->resultTable->setModel(_resultModel);
+    ui->resultTable->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->resultTable->horizontalHeader()->setResizeContentsPrecision(RESIZE_PRECISION_ROWS);
+    _timeoutTimer->setSingleShot(true);
+    connect(_timeoutTimer, SIGNAL(timeout()), this, SLOT(onWorkerTimeout()));
+    _highlighter = new MatchHighlighter(ui->testeeEdit->document());
+    _liveTimer->setSingleShot(true);
+    connect(_liveTimer, SIGNAL(timeout()), this, SLOT(runLive()));
+    connect(ui->patternEdit, SIGNAL(textChanged()), this, SLOT(onLiveInputChanged()));
+    connect(ui->patternEdit, SIGNAL(textChanged()), this, SLOT(clearProfileHeatMap()));
+    connect(ui->densityMap, SIGNAL(bucketClicked(qint64,qint64)), this, SLOT(onDensityBucketClicked(qint64,qint64)));
+    connect(ui->patternSyntaxComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onLiveInputChanged()));
+    connect(ui->caretModeComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onLiveInputChanged()));
+    connect(ui->engineComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(onLiveInputChanged()));
+    connect(ui->caseSensitiveCheckBox, SIGNAL(toggled(bool)), this, SLOT(onLiveInputChanged()));
+    connect(ui->minimalCheckBox, SIGNAL(toggled(bool)), this, SLOT(onLiveInputChanged()));
+    // Highlighting also reports (unchanged) text changes, so only restart
+    // the debounce on those and cancel on edits that change the length.
+    connect(ui->testeeEdit, SIGNAL(textChanged()), this, SLOT(onLiveTesteeChanged()));
+    connect(ui->testeeEdit->document(), SIGNAL(contentsChange(int,int,int)), this, SLOT(onTesteeContentsChange(int,int,int)));
+    setRunning(false);
+    setMappedTestee(MappedTesteePtr());
     setWindowTitle(tr("Untitled"));
 }
 
 RegexTesterWindow::~RegexTesterWindow()
 {
+    releaseWorker();
     delete ui;
 }
 
 void RegexTesterWindow::clearResultTable()
 {
-    ui->resultTable->clear();
-    ui->resultTable->setRowCount(0);
-
-    QStringList header;
-    header << "Item" << "Result";
-    ui->resultTable->setColumnCount(header.length());
-    ui->resultTable->setHorizontalHeaderLabels(header);
+    _resultModel->clear();
+    emit resultMemoryChanged();
 }
 
 void RegexTesterWindow::insertResultToTable(const QString &item, const QString &result)
 {
-    int rowIndex = ui->resultTable->rowCount();
-    ui->resultTable->insertRow(rowIndex);
-    ui->resultTable->setItem(rowIndex, 0, new QTableWidgetItem(item));
-    ui->resultTable->setItem(rowIndex, 1, new QTableWidgetItem(result));
+    insertResultsToTable(MatchResultRows() << MatchResultRow(item, result));
+}
+
+void RegexTesterWindow::insertResultsToTable(const MatchResultRows &rows)
+{
+    _resultModel->appendTextRows(rows);
 }
 
 QString RegexTesterWindow::boolToString(bool value)
@@ -48,9 +99,37 @@ QString RegexTesterWindow::boolToString(bool value)
     return value ? QString("true") : QString("false");
 }
 
+bool RegexTesterWindow::isBlank(const QString &text)
+{
+    // Same as text.trimmed().isEmpty(), without copying the text.
+    for (int i = 0; i < text.length(); ++i)
+    {
+        if (!text.at(i).isSpace())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void RegexTesterWindow::loadTesteeFromFile(const QString &filename)
 {
-    ui->testeeEdit->clear();
+    clearTestee();
+
+    if (CompressedReader::detectFormat(filename) != CompressedReader::Uncompressed)
+    {
+        setCompressedTestee(filename);
+        return;
+    }
+    if (QFileInfo(filename).size() > STREAMING_THRESHOLD)
+    {
+        MappedTesteePtr testee(new MappedTestee());
+        if (testee->open(filename))
+        {
+            setMappedTestee(testee);
+            return;
+        }
+    }
 
     QFile testeeFile(filename);
     if (testeeFile.open(QIODevice::ReadOnly | QIODevice::Text))
@@ -62,11 +141,15 @@ void RegexTesterWindow::loadTesteeFromFile(const QString &filename)
 
 void RegexTesterWindow::run()
 {
+    releaseWorker();
     syncUiToController();
 
     ui->resultEdit->clear();
     clearResultTable();
+    clearProfileHeatMap();
 
+    // The worker and the result model share this one copy of the testee.
+    _runTestee = isTesteeStreamed() ? QString() : ui->testeeEdit->toPlainText();
     if (!_regexp->isPatternValid())
     {
         ui->resultEdit->setTextColor(Qt::red);
@@ -80,28 +163,172 @@ void RegexTesterWindow::run()
         ui->resultEdit->insertPlainText(tr("ERROR: pattern content is empty."));
         return;
     }
-    else if(ui->testeeEdit->toPlainText().trimmed().isEmpty())
+    else if(!isTesteeStreamed() && !ui->growthProbeRadioBox->isChecked() &&
+            isBlank(_runTestee))
     {
         ui->resultEdit->setTextColor(Qt::red);
         ui->resultEdit->insertPlainText(tr("ERROR: testee content is empty."));
         return;
     }
+    else if(isTesteeStreamed() && !ui->indexInRadioBox->isChecked() &&
+            !ui->growthProbeRadioBox->isChecked())
+    {
+        ui->resultEdit->setTextColor(Qt::red);
+        ui->resultEdit->insertPlainText(tr("ERROR: only indexIn is available for a streamed testee."));
+        return;
+    }
     else
     {
         ui->resultEdit->setTextColor(Qt::blue);
         ui->resultEdit->insertPlainText(tr("Pattern is valid."));
     }
 
+    if (_regexp->getEngine() == RegExpEngine::LinearLazyDfa)
+    {
+        appendResultMessage(QString(tr("Engine: %1.")).arg(_regexp->engine()->name()), Qt::darkGreen);
+    }
+    foreach (const QString &warning, PatternAnalyzer(*_regexp).warnings())
+    {
+        appendResultMessage(warning, Qt::darkYellow);
+    }
+    if (_regexp->isPrefiltered() && !ui->exactMatchRadioBox->isChecked() && !ui->growthProbeRadioBox->isChecked())
+    {
+        appendResultMessage(QString(tr("Prefilter: searching for %1 first."))
+                            .arg(_regexp->prefilter()->description()),
+                            Qt::darkGreen);
+    }
+    if (ui->parallelCheckBox->isChecked() && ui->indexInRadioBox->isChecked() && !isTesteeStreamed() &&
+        !ParallelScanner::isSupported(*_regexp))
+    {
+        appendResultMessage(_regexp->getCaretMode() == QRegExp::CaretAtOffset
+                            ? tr("Parallel: '^' matches at the offset, scanning sequentially.")
+                            : tr("Parallel: a match may run on past a line break without bound, scanning sequentially."),
+                            Qt::darkYellow);
+    }
+
     ui->resultEdit->setTextColor(Qt::black);
     if (ui->exactMatchRadioBox->isChecked())
     {
         doExactMatch();
     }
+    else if (ui->benchmarkRadioBox->isChecked())
+    {
+        doBenchmark();
+    }
+    else if (ui->growthProbeRadioBox->isChecked())
+    {
+        doGrowthProbe();
+    }
+    else if (ui->profileRadioBox->isChecked())
+    {
+        doProfile();
+    }
     else
     {
         doIndexIn();
     }
-    ui->resultTable->resizeColumnsToContents();
+}
+
+void RegexTesterWindow::runLive()
+{
+    if (!ui->liveCheckBox->isChecked() || isTesteeStreamed())
+    {
+        return;
+    }
+
+    syncUiToController();
+    QString testee = ui->testeeEdit->toPlainText();
+    QString options = liveOptionsKey();
+    int from = 0;
+    int limit = testee.length();
+    QVector<qint64> head;
+    QVector<qint64> tail;
+    // Without a longest match any match may read into the edit.
+    int reach = PatternParser(_regexp->getRegExp()).maxMatchLength();
+
+    if (options == _liveOptions && reach >= 0)
+    {
+        // Only the text between the common prefix and suffix changed.
+        const QChar *oldText = _liveTestee.constData();
+        const QChar *newText = testee.constData();
+        int oldLength = _liveTestee.length();
+        int newLength = testee.length();
+        int common = qMin(oldLength, newLength);
+        int prefix = 0;
+        while (prefix < common && oldText[prefix] == newText[prefix])
+        {
+            prefix ++;
+        }
+        if (prefix == oldLength && prefix == newLength)
+        {
+            return;
+        }
+        int suffix = 0;
+        while (suffix < common - prefix && oldText[oldLength - 1 - suffix] == newText[newLength - 1 - suffix])
+        {
+            suffix ++;
+        }
+
+        int delta = newLength - oldLength;
+        int stride = 2 * (_liveCaptureCount + 1);
+        int margin = Prefilter::windowPadding(reach);
+        from = qMax(0, prefix - margin);
+        limit = qMin(newLength, newLength - suffix + margin);
+        int rescanFrom = from;
+        for (int i = 0; i + stride <= _liveSpans.size(); i += stride)
+        {
+            qint64 pos = _liveSpans.at(i);
+            if (pos + _liveSpans.at(i + 1) <= from)
+            {
+                head += _liveSpans.mid(i, stride);
+                continue;
+            }
+            // A match reaching into the margin is rescanned from its start.
+            rescanFrom = qMin(rescanFrom, int(pos));
+            if (pos < oldLength - suffix)
+            {
+                continue;
+            }
+            for (int j = 0; j < stride; j += 2)
+            {
+                qint64 capPos = _liveSpans.at(i + j);
+                tail << (capPos < 0 ? capPos : capPos + delta) << _liveSpans.at(i + j + 1);
+            }
+        }
+        from = rescanFrom;
+    }
+
+    ui->resultEdit->clear();
+    if (!_regexp->isPatternValid() || _regexp->getPattern().isEmpty())
+    {
+        releaseWorker();
+        clearResultTable();
+        _highlighter->clearMatches();
+        _liveOptions.clear();
+        if (!_regexp->isPatternValid())
+        {
+            ui->resultEdit->setTextColor(Qt::red);
+            ui->resultEdit->insertPlainText(tr("ERROR: "));
+            ui->resultEdit->insertPlainText(_regexp->errorString());
+        }
+        return;
+    }
+    ui->resultEdit->setTextColor(Qt::blue);
+    ui->resultEdit->insertPlainText(tr("Pattern is valid."));
+    if (_regexp->getEngine() == RegExpEngine::LinearLazyDfa)
+    {
+        appendResultMessage(QString(tr("Engine: %1.")).arg(_regexp->engine()->name()), Qt::darkGreen);
+    }
+    foreach (const QString &warning, PatternAnalyzer(*_regexp).warnings())
+    {
+        appendResultMessage(warning, Qt::darkYellow);
+    }
+
+    _pendingLiveTestee = testee;
+    _pendingLiveOptions = options;
+    createWorker(MatchWorker::LiveIndexIn, testee);
+    _worker->setLiveRange(from, limit, head, tail);
+    launchWorker();
 }
 
 bool RegexTesterWindow::saveToFile(const QString &filename)
@@ -143,6 +370,10 @@ void RegexTesterWindow::syncUiToController()
     _regexp->setCaseSensitive(ui->caseSensitiveCheckBox->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive);
     _regexp->setCaretMode(ui->caretModeComboBox->currentText());
     _regexp->setMinimal(ui->minimalCheckBox->isChecked());
+    _regexp->setEngine(ui->engineComboBox->currentText());
+    _regexp->setPrefilterEnabled(ui->prefilterCheckBox->isChecked());
+    LazyDfa::setCacheLimit(ui->dfaCacheSpinBox->value());
+    _resultModel->setMemoryBudget(qint64(ui->resultBudgetSpinBox->value()) * 1024 * 1024);
 }
 
 void RegexTesterWindow::syncUiFromController()
@@ -152,6 +383,7 @@ void RegexTesterWindow::syncUiFromController()
     ui->caseSensitiveCheckBox->setChecked(_regexp->getCaseSensitive() == Qt::CaseSensitive);
     ui->caretModeComboBox->setCurrentIndex(int(_regexp->getCaretMode()));
     ui->minimalCheckBox->setChecked(_regexp->isMinimal());
+    ui->engineComboBox->setCurrentIndex(int(_regexp->getEngine()));
 }
 
 bool RegexTesterWindow::isPatternEmpty() const
@@ -162,6 +394,13 @@ bool RegexTesterWindow::isPatternEmpty() const
 void RegexTesterWindow::clearTestee()
 {
     ui->testeeEdit->clear();
+    ui->densityMap->reset(0);
+    setMappedTestee(MappedTesteePtr());
+}
+
+bool RegexTesterWindow::isTesteeStreamed() const
+{
+    return !_mappedTestee.isNull() || !_compressedTestee.isEmpty();
 }
 
 void RegexTesterWindow::generatePatternForCode() const
@@ -173,48 +412,816 @@ void RegexTesterWindow::generatePatternForCode() const
 
 void RegexTesterWindow::doExactMatch()
 {
-    bool matchResult = _regexp->exactMatch(ui->testeeEdit->toPlainText());
+    startWorker(MatchWorker::ExactMatch);
+}
+
+void RegexTesterWindow::doIndexIn()
+{
+    startWorker(MatchWorker::IndexIn);
+}
+
+void RegexTesterWindow::doBenchmark()
+{
+    startWorker(MatchWorker::BenchmarkIndexIn);
+}
+
+void RegexTesterWindow::doGrowthProbe()
+{
+    startWorker(MatchWorker::GrowthProbe);
+}
+
+void RegexTesterWindow::doProfile()
+{
+    startWorker(MatchWorker::Profile);
+}
+
+bool RegexTesterWindow::isRunning() const
+{
+    return _worker != NULL || _fileSearcher != NULL;
+}
 
-    insertResultToTable(tr("exactMatch(...)"), boolToString(matchResult));
-    insertResultToTable(tr("matchedLength"), QString::number(_regexp->matchedLength()));
-    insertResultToTable(tr("captureCount"), QString::number(_regexp->captureCount()));
-    for (int i = 0; i <= _regexp->captureCount(); ++i)
+void RegexTesterWindow::cancel()
+{
+    if (!isRunning())
     {
-        QString itemText = QString(tr("cap(%1)")).arg(i);
-        insertResultToTable(itemText, _regexp->cap(i));
+        return;
     }
+    releaseWorker();
+    appendResultMessage(tr("Canceled."), Qt::red);
+    ui->resultTable->resizeColumnsToContents();
 }
 
-void RegexTesterWindow::doIndexIn()
+/*
+ * Runs indexIn with the matches streamed to a file instead of the result
+ * table.
+ */
+void RegexTesterWindow::exportMatches(const QString &filename, MatchExporter::Format format)
+{
+    if (!_compressedTestee.isEmpty())
+    {
+        ui->resultEdit->clear();
+        appendResultMessage(tr("ERROR: matches of a compressed testee can't be exported."), Qt::red);
+        return;
+    }
+    MatchExporterPtr exporter(new MatchExporter(filename, format), &QObject::deleteLater);
+    if (!exporter->open())
+    {
+        ui->resultEdit->clear();
+        appendResultMessage(QString(tr("ERROR: can't write %1: %2")).arg(filename).arg(exporter->getError()), Qt::red);
+        return;
+    }
+    ui->indexInRadioBox->setChecked(true);
+    _exporter = exporter;
+    run();
+    if (_exporter.isNull())
+    {
+        appendResultMessage(QString(tr("Exporting matches to %1.")).arg(filename), Qt::darkGreen);
+    }
+    _exporter.clear();
+}
+
+/*
+ * Runs indexIn over a directory tree; the result table lists every file
+ * with matches, followed by its matches.
+ */
+void RegexTesterWindow::searchFiles(const QString &root, const QStringList &globs)
+{
+    releaseWorker();
+    syncUiToController();
+    ui->resultEdit->clear();
+    clearResultTable();
+    _resultModel->setCaptureCount(0);
+
+    if (!_regexp->isPatternValid())
+    {
+        appendResultMessage(tr("ERROR: ") + _regexp->errorString(), Qt::red);
+        return;
+    }
+    else if (_regexp->getPattern().isEmpty())
+    {
+        appendResultMessage(tr("ERROR: pattern content is empty."), Qt::red);
+        return;
+    }
+
+    _searchedFiles = 0;
+    _searchedMatches = 0;
+    _fileSearcher = new FileSearcher(*_regexp, root, globs);
+    _fileSearcher->setChunking(qint64(ui->chunkSpinBox->value()) * 1024 * 1024,
+                               qint64(ui->overlapSpinBox->value()) * 1024);
+    connect(_fileSearcher, SIGNAL(fileSearched(FileSearchResult)), this, SLOT(onFileSearched(FileSearchResult)));
+    connect(_fileSearcher, SIGNAL(searchFinished(int,qint64,int,qint64)), this, SLOT(onFileSearchFinished(int,qint64,int,qint64)));
+    connect(_fileSearcher, SIGNAL(finished()), this, SLOT(onFileSearcherFinished()));
+    connect(_fileSearcher, SIGNAL(finished()), _fileSearcher, SLOT(deleteLater()));
+    appendResultMessage(QString(tr("Searching %1 for %2.")).arg(root).arg(globs.join(" ")), Qt::darkGreen);
+    setRunning(true);
+    _fileSearcher->start();
+}
+
+/*
+ * Benchmarks this window's pattern (A) against the other window's (B) on
+ * this window's testee and lists where their matches differ.
+ */
+void RegexTesterWindow::compareWith(RegexTesterWindow *other)
+{
+    releaseWorker();
+    syncUiToController();
+    other->syncUiToController();
+    ui->resultEdit->clear();
+    clearResultTable();
+    clearProfileHeatMap();
+
+    RegExpController *sides[2] = { _regexp, other->_regexp };
+    for (int side = 0; side < 2; ++side)
+    {
+        QString name = side == 0 ? QString("A") : QString("B");
+        if (!sides[side]->isPatternValid())
+        {
+            appendResultMessage(QString(tr("ERROR: pattern %1: %2")).arg(name).arg(sides[side]->errorString()), Qt::red);
+            return;
+        }
+        else if (sides[side]->getPattern().trimmed().isEmpty())
+        {
+            appendResultMessage(QString(tr("ERROR: pattern %1 is empty.")).arg(name), Qt::red);
+            return;
+        }
+    }
+    if (isTesteeStreamed())
+    {
+        appendResultMessage(tr("ERROR: patterns can only be compared on a testee held in the editor."), Qt::red);
+        return;
+    }
+    _runTestee = ui->testeeEdit->toPlainText();
+    if (isBlank(_runTestee))
+    {
+        appendResultMessage(tr("ERROR: testee content is empty."), Qt::red);
+        return;
+    }
+
+    appendResultMessage(QString(tr("Comparing A: %1 (%2) with B: %3 (%4)."))
+                        .arg(_regexp->getPattern())
+                        .arg(_regexp->engine()->name())
+                        .arg(other->_regexp->getPattern())
+                        .arg(other->_regexp->engine()->name()),
+                        Qt::darkGreen);
+    createWorker(MatchWorker::Compare, _runTestee);
+    _worker->setComparison(*other->_regexp);
+    _runTestee.clear();
+    launchWorker();
+}
+
+void RegexTesterWindow::startWorker(MatchWorker::Mode mode)
+{
+    createWorker(mode, _runTestee);
+    _runTestee.clear();
+    launchWorker();
+}
+
+void RegexTesterWindow::createWorker(MatchWorker::Mode mode, const QString &testee)
+{
+    releaseWorker();
+
+    _worker = new MatchWorker(*_regexp);
+    _worker->setMode(mode);
+    _worker->setParallel(ui->parallelCheckBox->isChecked());
+    _worker->setBenchmark(ui->passesSpinBox->value(), ui->passesSpinBox->value() / 10);
+    _worker->setMatchLimits(ui->maxMatchesSpinBox->value(), 0);
+    if (!_compressedTestee.isEmpty())
+    {
+        _worker->setCompressedTestee(_compressedTestee,
+                                     qint64(ui->chunkSpinBox->value()) * 1024 * 1024,
+                                     qint64(ui->overlapSpinBox->value()) * 1024);
+        _resultModel->setTestee(QString());
+    }
+    else if (_mappedTestee.isNull())
+    {
+        _worker->setTestee(testee);
+        _resultModel->setTestee(testee);
+    }
+    else
+    {
+        _worker->setMappedTestee(_mappedTestee,
+                                 qint64(ui->chunkSpinBox->value()) * 1024 * 1024,
+                                 qint64(ui->overlapSpinBox->value()) * 1024);
+        _resultModel->setMappedTestee(_mappedTestee);
+    }
+    if (!_exporter.isNull() && mode == MatchWorker::IndexIn)
+    {
+        if (_mappedTestee.isNull())
+        {
+            _exporter->setTestee(testee);
+        }
+        else
+        {
+            _exporter->setMappedTestee(_mappedTestee);
+        }
+        _exporter->setCaptureCount(_regexp->captureCount());
+        connect(_exporter.data(), SIGNAL(exportFinished(qint64,QString)), this, SLOT(onExportFinished(qint64,QString)));
+        _worker->setExporter(_exporter);
+        _exporter->start();
+        _exporter.clear();
+    }
+    // Matches of a compressed testee come as text rows.
+    bool spans = (mode == MatchWorker::ExactMatch || mode == MatchWorker::IndexIn ||
+                  mode == MatchWorker::LiveIndexIn) && _compressedTestee.isEmpty();
+    _resultModel->setCaptureCount(spans ? _regexp->captureCount() : 0);
+    if (!spans)
+    {
+        ui->densityMap->reset(0);
+    }
+    else
+    {
+        ui->densityMap->reset(_mappedTestee.isNull() ? testee.length() : _mappedTestee->size());
+    }
+    connect(_worker, SIGNAL(resultsReady(MatchResultRows)), this, SLOT(onWorkerResultsReady(MatchResultRows)));
+    connect(_worker, SIGNAL(matchesReady(QVector<qint64>)), this, SLOT(onWorkerMatchesReady(QVector<qint64>)));
+    connect(_worker, SIGNAL(progressChanged(qint64,qint64,int)), this, SLOT(onWorkerProgressChanged(qint64,qint64,int)));
+    connect(_worker, SIGNAL(truncatedMatchesFound(int)), this, SLOT(onWorkerTruncatedMatchesFound(int)));
+    connect(_worker, SIGNAL(matchingFinished(QString,qint64)), this, SLOT(onWorkerMatchingFinished(QString,qint64)));
+    connect(_worker, SIGNAL(benchmarkFinished(BenchmarkResult)), this, SLOT(onWorkerBenchmarkFinished(BenchmarkResult)));
+    connect(_worker, SIGNAL(profileFinished(PatternProfile)), this, SLOT(onWorkerProfileFinished(PatternProfile)));
+    connect(_worker, SIGNAL(comparisonFinished(ComparisonResult)), this, SLOT(onWorkerComparisonFinished(ComparisonResult)));
+    connect(_worker, SIGNAL(warningRaised(QString)), this, SLOT(onWorkerWarningRaised(QString)));
+    connect(_worker, SIGNAL(rescanFinished(int,int)), this, SLOT(onWorkerRescanFinished(int,int)));
+    connect(_worker, SIGNAL(finished()), this, SLOT(onWorkerFinished()));
+    connect(_worker, SIGNAL(finished()), _worker, SLOT(deleteLater()));
+}
+
+void RegexTesterWindow::launchWorker()
+{
+    setRunning(true);
+    if (ui->timeoutSpinBox->value() > 0)
+    {
+        _timeoutTimer->start(ui->timeoutSpinBox->value() * 1000);
+    }
+    _worker->start();
+}
+
+void RegexTesterWindow::releaseWorker()
+{
+    _timeoutTimer->stop();
+    if (_worker != NULL)
+    {
+        // The worker deletes itself once its current QRegExp call returns.
+        disconnect(_worker, 0, this, 0);
+        _worker->cancel();
+        _worker = NULL;
+    }
+    if (_fileSearcher != NULL)
+    {
+        disconnect(_fileSearcher, 0, this, 0);
+        _fileSearcher->cancel();
+        _fileSearcher = NULL;
+    }
+    setRunning(false);
+}
+
+void RegexTesterWindow::setRunning(bool running)
+{
+    ui->cancelButton->setEnabled(running);
+    if (running)
+    {
+        ui->progressBar->setRange(0, 0);
+        ui->progressLabel->clear();
+    }
+    else
+    {
+        ui->progressBar->setRange(0, 1);
+        ui->progressBar->setValue(0);
+    }
+}
+
+void RegexTesterWindow::onWorkerMatchingFinished(const QString &engine, qint64 nsecs)
+{
+    _engineTimings[engine] = nsecs;
+
+    QStringList timings;
+    QMapIterator<QString, qint64> it(_engineTimings);
+    while (it.hasNext())
+    {
+        it.next();
+        timings << QString("%1 %2 ms").arg(it.key()).arg(it.value() / 1000000.0, 0, 'f', 3);
+    }
+    appendResultMessage(QString(tr("Matched with %1 in %2 ms (last run per engine: %3)."))
+                        .arg(engine)
+                        .arg(nsecs / 1000000.0, 0, 'f', 3)
+                        .arg(timings.join(", ")),
+                        Qt::darkGreen);
+}
+
+void RegexTesterWindow::onWorkerBenchmarkFinished(const BenchmarkResult &result)
+{
+    _lastBenchmark = result;
+    ui->exportBenchmarkButton->setEnabled(true);
+
+    MatchResultRows rows;
+    rows << MatchResultRow(tr("engine"), result.engine);
+    rows << MatchResultRow(tr("passes (warm-up)"), QString("%1 (%2)").arg(result.sampleCount()).arg(result.warmup));
+    rows << MatchResultRow(tr("matches per pass"), QString::number(result.matchesPerPass));
+    rows << MatchResultRow(tr("min"), QString(tr("%1 ms")).arg(result.minimum() / 1000000.0, 0, 'f', 3));
+    rows << MatchResultRow(tr("median"), QString(tr("%1 ms")).arg(result.median() / 1000000.0, 0, 'f', 3));
+    rows << MatchResultRow(tr("p99"), QString(tr("%1 ms")).arg(result.percentile(99.0) / 1000000.0, 0, 'f', 3));
+    rows << MatchResultRow(tr("throughput"), QString(tr("%1 MB/s")).arg(result.throughput(), 0, 'f', 2));
+    rows << MatchResultRow(tr("matches/sec"), QString::number(result.matchesPerSecond(), 'f', 0));
+    if (result.unfilteredMedian > 0)
+    {
+        rows << MatchResultRow(tr("prefilter"), result.prefilter);
+        rows << MatchResultRow(tr("median without prefilter"), QString(tr("%1 ms")).arg(result.unfilteredMedian / 1000000.0, 0, 'f', 3));
+        rows << MatchResultRow(tr("prefilter speedup"), QString(tr("%1x")).arg(result.prefilterSpeedup(), 0, 'f', 2));
+    }
+    insertResultsToTable(rows);
+}
+
+void RegexTesterWindow::setMappedTestee(const MappedTesteePtr &testee)
+{
+    _compressedTestee.clear();
+    _mappedTestee = testee;
+    ui->streamingBar->setVisible(!testee.isNull());
+    ui->testeeEdit->setReadOnly(!testee.isNull());
+    if (testee.isNull())
+    {
+        ui->testeeBox->setTitle(tr("Testee"));
+        return;
+    }
+
+    qint64 previewBytes = testee->alignToChar(STREAMING_PREVIEW_BYTES);
+    ui->testeeEdit->setPlainText(testee->text(0, previewBytes));
+    ui->testeeBox->setTitle(tr("Testee (preview)"));
+    ui->streamingLabel->setText(QString(tr("Streaming %1 (%2 MB), showing the first %3 KB."))
+                                .arg(QFileInfo(testee->getFilename()).fileName())
+                                .arg(testee->size() / (1024 * 1024))
+                                .arg(previewBytes / 1024));
+}
+
+/*
+ * A gzip or zstd testee is decompressed while it is scanned; only a
+ * preview of its start is decoded up front.
+ */
+void RegexTesterWindow::setCompressedTestee(const QString &filename)
+{
+    CompressedReader reader;
+    if (!reader.open(filename))
+    {
+        ui->resultEdit->clear();
+        appendResultMessage(QString(tr("ERROR: can't read %1: %2")).arg(filename).arg(reader.getError()), Qt::red);
+        return;
+    }
+    QByteArray preview = reader.read(STREAMING_PREVIEW_BYTES);
+    int previewBytes = int(MappedTestee::alignToChar(preview.constData(), preview.size(), preview.size()));
+
+    setMappedTestee(MappedTesteePtr());
+    _compressedTestee = filename;
+    ui->streamingBar->setVisible(true);
+    ui->testeeEdit->setReadOnly(true);
+    ui->testeeEdit->setPlainText(QString::fromUtf8(preview.constData(), previewBytes));
+    ui->testeeBox->setTitle(tr("Testee (preview)"));
+    ui->streamingLabel->setText(QString(tr("Streaming %1 (%2 MB of %3), showing the first %4 KB."))
+                                .arg(QFileInfo(filename).fileName())
+                                .arg(reader.compressedSize() / (1024 * 1024))
+                                .arg(CompressedReader::formatName(CompressedReader::detectFormat(filename)))
+                                .arg(previewBytes / 1024));
+}
+
+/*
+ * Outer parts are painted first so nested ones show on top of them. The
+ * offsets are those of the translated pattern, which only match the
+ * editor's text for the regexp syntaxes.
+ */
+void RegexTesterWindow::showProfileHeatMap(const PatternProfile &profile)
 {
-    QString itemTitle;
-    QString testeeString = ui->testeeEdit->toPlainText();
-    int pos = 0;
-    int len;
+    if (ui->patternEdit->toPlainText() != profile.pattern ||
+        RegExpEngine::translatePattern(_regexp->getRegExp()) != profile.pattern)
+    {
+        return;
+    }
+
+    QList<QTextEdit::ExtraSelection> selections;
+    bool found = true;
+    for (int depth = 0; found; ++depth)
+    {
+        found = false;
+        for (int i = 0; i < profile.entries.size(); ++i)
+        {
+            const ProfileEntry &entry = profile.entries.at(i);
+            double share = profile.selfShare(i);
+            if (entry.depth != depth)
+            {
+                continue;
+            }
+            found = true;
+            if (share <= 0.0 || entry.end <= entry.begin)
+            {
+                continue;
+            }
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(ui->patternEdit->document());
+            selection.cursor.setPosition(entry.begin);
+            selection.cursor.setPosition(entry.end, QTextCursor::KeepAnchor);
+            // Yellow for the cheap parts through to red for the costliest.
+            selection.format.setBackground(QColor(255, int(220 * (1.0 - share)), 0, 40 + int(180 * share)));
+            selection.format.setToolTip(QString(tr("%1: %2% of the steps")).arg(entry.label).arg(share * 100.0, 0, 'f', 1));
+            selections << selection;
+        }
+    }
+    ui->patternEdit->setExtraSelections(selections);
+}
+
+void RegexTesterWindow::clearProfileHeatMap()
+{
+    ui->patternEdit->setExtraSelections(QList<QTextEdit::ExtraSelection>());
+}
+
+/*
+ * Jumps to the first match in a bucket of the density map, or to its
+ * start when it has none, from the matches already found.
+ */
+void RegexTesterWindow::onDensityBucketClicked(qint64 from, qint64 to)
+{
+    qint64 pos = from;
+    int match = _resultModel->firstMatchFrom(from);
+    if (match >= 0 && _resultModel->matchPos(match) < to)
+    {
+        pos = _resultModel->matchPos(match);
+        QModelIndex index = _resultModel->index(_resultModel->matchRow(match), 0);
+        ui->resultTable->setCurrentIndex(index);
+        ui->resultTable->scrollTo(index, QAbstractItemView::PositionAtTop);
+    }
+
+    // A streamed testee's editor only holds a preview.
+    if (!isTesteeStreamed())
+    {
+        QTextCursor cursor(ui->testeeEdit->document());
+        cursor.setPosition(int(qMin(pos, qint64(ui->testeeEdit->document()->characterCount() - 1))));
+        ui->testeeEdit->setTextCursor(cursor);
+        ui->testeeEdit->ensureCursorVisible();
+    }
+}
+
+void RegexTesterWindow::appendResultMessage(const QString &message, const QColor &color)
+{
+    ui->resultEdit->moveCursor(QTextCursor::End);
+    ui->resultEdit->setTextColor(color);
+    ui->resultEdit->insertPlainText("\n" + message);
+    ui->resultEdit->setTextColor(Qt::black);
+}
+
+void RegexTesterWindow::onWorkerResultsReady(const MatchResultRows &rows)
+{
+    insertResultsToTable(rows);
+}
+
+void RegexTesterWindow::onWorkerMatchesReady(const QVector<qint64> &spans)
+{
+    bool complete = _resultModel->appendMatches(spans);
+    ui->densityMap->addMatches(spans, 2 * (_resultModel->getCaptureCount() + 1));
+    emit resultMemoryChanged();
+    if (!complete && _worker != NULL)
+    {
+        releaseWorker();
+        appendResultMessage(QString(tr("ERROR: results reached the %1 MB memory budget, matching stopped."))
+                            .arg(ui->resultBudgetSpinBox->value()), Qt::red);
+        ui->resultTable->resizeColumnsToContents();
+    }
+}
+
+void RegexTesterWindow::onWorkerProgressChanged(qint64 scanned, qint64 total, int matches)
+{
+    ui->progressBar->setRange(0, 1000);
+    ui->progressBar->setValue(total > 0 ? int(scanned * 1000 / total) : 1000);
+    QString format = isTesteeStreamed() ? tr("%1 / %2 bytes, %3 matches") : tr("%1 / %2 chars, %3 matches");
+    if (_worker != NULL && (_worker->getMode() == MatchWorker::BenchmarkIndexIn ||
+                            _worker->getMode() == MatchWorker::Compare))
+    {
+        format = tr("%1 / %2 passes, %3 matches per pass");
+    }
+    else if (_worker != NULL && _worker->getMode() == MatchWorker::GrowthProbe)
+    {
+        format = tr("%1 / %2 input lengths");
+    }
+    ui->progressLabel->setText(format.arg(scanned).arg(total).arg(matches));
+    ui->densityMap->setScanned(scanned);
+}
+
+void RegexTesterWindow::onWorkerTruncatedMatchesFound(int count)
+{
+    appendResultMessage(QString(tr("WARNING: %1 match(es) ran to the end of the overlap window and may be cut short, increase the overlap.")).arg(count),
+                        Qt::darkYellow);
+}
+
+/*
+ * Lists the pattern's parts by their own cost, most expensive first, and
+ * paints the same costs over the pattern.
+ */
+void RegexTesterWindow::onWorkerProfileFinished(const PatternProfile &profile)
+{
+    appendResultMessage(QString(tr("Profiled %1 of %2 chars: %3 steps, %4 match(es); %5 took %6 ms on the same text."))
+                        .arg(profile.scanned)
+                        .arg(profile.textLength)
+                        .arg(profile.steps)
+                        .arg(profile.matches)
+                        .arg(profile.engine)
+                        .arg(profile.nsecs / 1000000.0, 0, 'f', 3),
+                        Qt::darkGreen);
+    if (profile.tooDeep)
+    {
+        appendResultMessage(tr("WARNING: an attempt nested too deep, the profile stops there."), Qt::darkYellow);
+    }
+    else if (profile.truncated)
+    {
+        appendResultMessage(tr("WARNING: the step budget ran out, the profile stops there."), Qt::darkYellow);
+    }
+
+    MatchResultRows rows;
+    foreach (int i, profile.byCost())
+    {
+        const ProfileEntry &entry = profile.entries.at(i);
+        if (entry.attempts == 0 && entry.selfSteps == 0)
+        {
+            continue;
+        }
+        QString text = profile.pattern.mid(entry.begin, entry.end - entry.begin);
+        if (text.length() > MAX_PROFILE_LABEL_CHARS)
+        {
+            text = text.left(MAX_PROFILE_LABEL_CHARS) + "...";
+        }
+        rows << MatchResultRow(QString("%1: %2").arg(entry.label).arg(text),
+                               QString(tr("%1% own, %2% with nested, %3 attempts, ~%4 ms"))
+                               .arg(profile.selfShare(i) * 100.0, 0, 'f', 1)
+                               .arg(profile.totalShare(i) * 100.0, 0, 'f', 1)
+                               .arg(entry.attempts)
+                               .arg(profile.selfNsecs(i) / 1000000.0, 0, 'f', 3));
+    }
+    insertResultsToTable(rows);
+    showProfileHeatMap(profile);
+}
+
+/*
+ * Reports which side is faster, if either reliably is, and lists the
+ * positions where the matches differ.
+ */
+void RegexTesterWindow::onWorkerComparisonFinished(const ComparisonResult &result)
+{
+    const BenchmarkResult *sides[2] = { &result.a, &result.b };
+    for (int side = 0; side < 2; ++side)
+    {
+        appendResultMessage(QString(tr("%1: median %2 ms, %3 MB/s, %4 matches per pass."))
+                            .arg(side == 0 ? "A" : "B")
+                            .arg(sides[side]->median() / 1000000.0, 0, 'f', 3)
+                            .arg(sides[side]->throughput(), 0, 'f', 2)
+                            .arg(sides[side]->matchesPerPass),
+                            Qt::darkGreen);
+    }
+
+    double low;
+    double high;
+    result.speedupInterval(low, high);
+    QString interval = QString(tr("95% confidence interval over %1 interleaved passes")).arg(result.sampleCount());
+    if (!result.isSignificant())
+    {
+        appendResultMessage(QString(tr("No significant difference: B runs at %1x the speed of A (%2: %3x - %4x)."))
+                            .arg(result.speedup(), 0, 'f', 3).arg(interval)
+                            .arg(low, 0, 'f', 3).arg(high, 0, 'f', 3),
+                            Qt::darkYellow);
+    }
+    else if (result.speedup() >= 1.0)
+    {
+        appendResultMessage(QString(tr("B is %1x faster than A (%2: %3x - %4x)."))
+                            .arg(result.speedup(), 0, 'f', 3).arg(interval)
+                            .arg(low, 0, 'f', 3).arg(high, 0, 'f', 3),
+                            Qt::darkGreen);
+    }
+    else
+    {
+        appendResultMessage(QString(tr("B is %1x slower than A (%2: %3x - %4x)."))
+                            .arg(1.0 / result.speedup(), 0, 'f', 3).arg(interval)
+                            .arg(1.0 / high, 0, 'f', 3).arg(1.0 / low, 0, 'f', 3),
+                            Qt::red);
+    }
+
+    if (result.differenceCount == 0)
+    {
+        appendResultMessage(tr("The matches of A and B are identical."), Qt::darkGreen);
+        return;
+    }
+    QString message = QString(tr("The matches differ at %1 position(s)")).arg(result.differenceCount);
+    if (result.differenceCount > result.differences.size())
+    {
+        message += QString(tr(", the first %1 are listed")).arg(result.differences.size());
+    }
+    appendResultMessage(message + ".", Qt::red);
 
-    while ((pos = _regexp->indexIn(testeeString, pos)) != -1)
+    MatchResultRows rows;
+    foreach (const MatchDifference &difference, result.differences)
     {
-        len = _regexp->matchedLength();
-        itemTitle = QString(tr("Testee[%1, %2]")).arg(pos).arg(pos + len - 1);
-        insertResultToTable(itemTitle, testeeString.mid(pos, len));
-        pos += len;
+        rows << MatchResultRow(QString(tr("position %1")).arg(difference.pos),
+                               QString("A: %1 | B: %2")
+                               .arg(describeCaptures(difference.capturesA))
+                               .arg(describeCaptures(difference.capturesB)));
     }
+    insertResultsToTable(rows);
+}
+
+QString RegexTesterWindow::describeCaptures(const QStringList &captures)
+{
+    if (captures.isEmpty())
+    {
+        return tr("no match");
+    }
+    return QString("\"%1\"").arg(captures.join("\", \""));
+}
+
+void RegexTesterWindow::onWorkerWarningRaised(const QString &message)
+{
+    appendResultMessage(message, Qt::darkYellow);
+}
+
+void RegexTesterWindow::onWorkerRescanFinished(int from, int to)
+{
+    _liveTestee = _pendingLiveTestee;
+    _liveOptions = _pendingLiveOptions;
+    _liveCaptureCount = _regexp->captureCount();
+    _liveSpans = _resultModel->spans();
+    _highlighter->setMatches(_liveSpans, _liveCaptureCount, from, to);
+}
+
+void RegexTesterWindow::onWorkerFinished()
+{
+    _timeoutTimer->stop();
+    _worker = NULL;
+    setRunning(false);
+    ui->resultTable->resizeColumnsToContents();
+}
+
+void RegexTesterWindow::onWorkerTimeout()
+{
+    if (_worker == NULL)
+    {
+        return;
+    }
+    releaseWorker();
+    appendResultMessage(QString(tr("ERROR: timed out after %1 s, matching abandoned.")).arg(ui->timeoutSpinBox->value()), Qt::red);
+    if (!PatternAnalyzer(*_regexp).warnings().isEmpty())
+    {
+        appendResultMessage(tr("The pattern may backtrack catastrophically, run the growth probe to check."), Qt::red);
+    }
+    ui->resultTable->resizeColumnsToContents();
+}
+
+void RegexTesterWindow::onExportFinished(qint64 matches, const QString &error)
+{
+    MatchExporter *exporter = qobject_cast<MatchExporter *>(sender());
+    QString filename = exporter != NULL ? exporter->getFilename() : QString();
+    if (!error.isEmpty())
+    {
+        appendResultMessage(QString(tr("ERROR: export to %1 failed: %2")).arg(filename).arg(error), Qt::red);
+        return;
+    }
+    appendResultMessage(QString(tr("Exported %1 matches to %2.")).arg(matches).arg(filename), Qt::darkGreen);
+}
+
+void RegexTesterWindow::onFileSearched(const FileSearchResult &result)
+{
+    _searchedFiles ++;
+    _searchedMatches += result.matches;
+    ui->progressLabel->setText(QString(tr("%1 files, %2 matches")).arg(_searchedFiles).arg(_searchedMatches));
+    if (!result.error.isEmpty())
+    {
+        insertResultToTable(result.filename, QString(tr("ERROR: %1")).arg(result.error));
+        return;
+    }
+    if (result.matches == 0)
+    {
+        return;
+    }
+    QString summary = QString(tr("%1 matches, %2 KB in %3 ms"))
+                      .arg(result.matches)
+                      .arg(result.bytes / 1024)
+                      .arg(result.nsecs / 1000000.0, 0, 'f', 3);
+    if (result.matches > result.rows.count())
+    {
+        summary += QString(tr(", first %1 listed")).arg(result.rows.count());
+    }
+    insertResultsToTable(MatchResultRows() << MatchResultRow(result.filename, summary) << result.rows);
+}
+
+void RegexTesterWindow::onFileSearchFinished(int files, qint64 bytes, int matches, qint64 nsecs)
+{
+    appendResultMessage(QString(tr("Searched %1 files (%2 MB) in %3 ms, %4 matches."))
+                        .arg(files)
+                        .arg(bytes / (1024.0 * 1024.0), 0, 'f', 1)
+                        .arg(nsecs / 1000000.0, 0, 'f', 3)
+                        .arg(matches),
+                        Qt::darkGreen);
+}
+
+void RegexTesterWindow::onFileSearcherFinished()
+{
+    _fileSearcher = NULL;
+    setRunning(false);
+    ui->resultTable->resizeColumnsToContents();
 }
 
 void RegexTesterWindow::clear()
 {
     ui->patternSyntaxComboBox->setCurrentIndex(0);
     ui->caretModeComboBox->setCurrentIndex(0);
+    ui->engineComboBox->setCurrentIndex(0);
     ui->caseSensitiveCheckBox->setChecked(true);
     ui->minimalCheckBox->setChecked(false);
     ui->exactMatchRadioBox->setChecked(true);
     ui->patternEdit->clear();
     ui->resultEdit->clear();
-    ui->testeeEdit->clear();
+    clearTestee();
+    releaseWorker();
     clearResultTable();
+    resetLive();
 }
 
 void RegexTesterWindow::on_runButton_clicked()
 {
     run();
 }
+
+void RegexTesterWindow::on_liveCheckBox_toggled(bool checked)
+{
+    resetLive();
+    if (checked)
+    {
+        _liveTimer->start(LIVE_DEBOUNCE_MS);
+    }
+}
+
+void RegexTesterWindow::onLiveInputChanged()
+{
+    if (!ui->liveCheckBox->isChecked())
+    {
+        return;
+    }
+    cancelLiveRun();
+    _liveTimer->start(LIVE_DEBOUNCE_MS);
+}
+
+void RegexTesterWindow::onLiveTesteeChanged()
+{
+    if (ui->liveCheckBox->isChecked())
+    {
+        _liveTimer->start(LIVE_DEBOUNCE_MS);
+    }
+}
+
+void RegexTesterWindow::onTesteeContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(position);
+    if (charsRemoved != charsAdded && ui->liveCheckBox->isChecked())
+    {
+        cancelLiveRun();
+    }
+}
+
+void RegexTesterWindow::cancelLiveRun()
+{
+    if (_worker != NULL && _worker->getMode() == MatchWorker::LiveIndexIn)
+    {
+        releaseWorker();
+    }
+}
+
+void RegexTesterWindow::resetLive()
+{
+    _liveTimer->stop();
+    cancelLiveRun();
+    _liveTestee.clear();
+    _liveOptions.clear();
+    _liveSpans.clear();
+    _highlighter->clearMatches();
+}
+
+QString RegexTesterWindow::liveOptionsKey() const
+{
+    return QString("%1|%2|%3|%4|%5|%6")
+            .arg(int(_regexp->getPatternSyntax()))
+            .arg(int(_regexp->getCaretMode()))
+            .arg(int(_regexp->getCaseSensitive()))
+            .arg(_regexp->isMinimal() ? 1 : 0)
+            .arg(int(_regexp->getEngine()))
+            .arg(_regexp->getPattern());
+}
+
+void RegexTesterWindow::on_cancelButton_clicked()
+{
+    cancel();
+}
+
+void RegexTesterWindow::on_exportBenchmarkButton_clicked()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Append benchmark to CSV"), QString(),
+                                                    tr("CSV File (*.csv);;All files (*.*)"), 0,
+                                                    QFileDialog::DontConfirmOverwrite);
+    if (filename.isEmpty())
+    {
+        return;
+    }
+    if (!Benchmark::appendToCsv(filename, _lastBenchmark))
+    {
+        appendResultMessage(QString(tr("ERROR: can't write %1.")).arg(filename), Qt::red);
+    }
+}
@@ -6,7 +6,14 @@
 #define REGEXTESTERWINDOW_H
 
 #include <QWidget>
+#include <QTimer>
+#include <QMap>
 #include "regexpcontroller.h"
+#include "matchworker.h"
+#include "matchresultmodel.h"
+#include "filesearcher.h"
+
+class MatchHighlighter;
 
 namespace Ui {
 class RegexTesterWindow;
@@ -21,7 +28,9 @@ public:
     ~RegexTesterWindow();
     void clearResultTable();
     void insertResultToTable(const QString &item, const QString &result);
+    void insertResultsToTable(const MatchResultRows &rows);
     QString boolToString(bool value);
+    static bool isBlank(const QString &text);
     void loadTesteeFromFile(const QString &filename);
     void run();
     bool saveToFile(const QString &filename);
@@ -32,19 +41,90 @@ public:
     void syncUiFromController();
     bool isPatternEmpty() const;
     void clearTestee();
+    bool isTesteeStreamed() const;
     void generatePatternForCode() const;
+    bool isRunning() const;
+    void cancel();
+    void exportMatches(const QString &filename, MatchExporter::Format format);
+    void searchFiles(const QString &root, const QStringList &globs);
+    void compareWith(RegexTesterWindow *other);
+
+signals:
+    void resultMemoryChanged();
 
 public slots:
     void doExactMatch();
     void doIndexIn();
+    void doBenchmark();
+    void doGrowthProbe();
+    void doProfile();
+    void runLive();
     void clear();    
 
 private slots:
     void on_runButton_clicked();
+    void on_liveCheckBox_toggled(bool checked);
+    void onLiveInputChanged();
+    void onLiveTesteeChanged();
+    void onTesteeContentsChange(int position, int charsRemoved, int charsAdded);
+    void on_cancelButton_clicked();
+    void on_exportBenchmarkButton_clicked();
+    void onWorkerResultsReady(const MatchResultRows &rows);
+    void onWorkerMatchesReady(const QVector<qint64> &spans);
+    void onWorkerProgressChanged(qint64 scanned, qint64 total, int matches);
+    void onWorkerTruncatedMatchesFound(int count);
+    void onWorkerMatchingFinished(const QString &engine, qint64 nsecs);
+    void onWorkerBenchmarkFinished(const BenchmarkResult &result);
+    void onWorkerProfileFinished(const PatternProfile &profile);
+    void onWorkerComparisonFinished(const ComparisonResult &result);
+    void onWorkerWarningRaised(const QString &message);
+    void onWorkerRescanFinished(int from, int to);
+    void onWorkerFinished();
+    void onWorkerTimeout();
+    void onExportFinished(qint64 matches, const QString &error);
+    void onFileSearched(const FileSearchResult &result);
+    void onFileSearchFinished(int files, qint64 bytes, int matches, qint64 nsecs);
+    void onFileSearcherFinished();
+    void clearProfileHeatMap();
+    void onDensityBucketClicked(qint64 from, qint64 to);
 
 private:
+    void startWorker(MatchWorker::Mode mode);
+    void createWorker(MatchWorker::Mode mode, const QString &testee);
+    void launchWorker();
+    void cancelLiveRun();
+    void resetLive();
+    QString liveOptionsKey() const;
+    void releaseWorker();
+    void setRunning(bool running);
+    void setMappedTestee(const MappedTesteePtr &testee);
+    void setCompressedTestee(const QString &filename);
+    void appendResultMessage(const QString &message, const QColor &color);
+    void showProfileHeatMap(const PatternProfile &profile);
+    static QString describeCaptures(const QStringList &captures);
+
     Ui::RegexTesterWindow *ui;
     RegExpController *_regexp;
+    MatchResultModel *_resultModel;
+    MappedTesteePtr _mappedTestee;
+    QString _compressedTestee;
+    MatchWorker *_worker;
+    MatchExporterPtr _exporter;
+    FileSearcher *_fileSearcher;
+    int _searchedFiles;
+    int _searchedMatches;
+    QTimer *_timeoutTimer;
+    QString _runTestee;
+    QMap<QString, qint64> _engineTimings;
+    BenchmarkResult _lastBenchmark;
+    MatchHighlighter *_highlighter;
+    QTimer *_liveTimer;
+    QString _liveTestee;
+    QString _liveOptions;
+    QVector<qint64> _liveSpans;
+    int _liveCaptureCount;
+    QString _pendingLiveTestee;
+    QString _pendingLiveOptions;
 };
 
 #endif // REGEXTESTERWINDOW_H
@@ -0,0 +1,90 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "spanarena.h"
+#include <cstring>
+
+// 64K values, 512 KB per chunk.
+#define CHUNK_SHIFT 16
+#define CHUNK_VALUES (1 << CHUNK_SHIFT)
+#define CHUNK_MASK (CHUNK_VALUES - 1)
+
+qint64 SpanArena::_totalBytes = 0;
+
+SpanArena::SpanArena() :
+    _size(0)
+{
+}
+
+SpanArena::~SpanArena()
+{
+    clear();
+}
+
+void SpanArena::clear()
+{
+    foreach (qint64 *chunk, _chunks)
+    {
+        delete[] chunk;
+    }
+    _totalBytes -= byteSize();
+    _chunks.clear();
+    _size = 0;
+}
+
+void SpanArena::append(const qint64 *values, int count)
+{
+    while (count > 0)
+    {
+        int chunk = int(_size >> CHUNK_SHIFT);
+        int offset = int(_size & CHUNK_MASK);
+        if (chunk == _chunks.size())
+        {
+            _chunks << new qint64[CHUNK_VALUES];
+            _totalBytes += chunkBytes();
+        }
+        int n = qMin(count, CHUNK_VALUES - offset);
+        memcpy(_chunks.at(chunk) + offset, values, n * sizeof(qint64));
+        values += n;
+        count -= n;
+        _size += n;
+    }
+}
+
+qint64 SpanArena::at(qint64 index) const
+{
+    Q_ASSERT(index >= 0 && index < _size);
+    return _chunks.at(int(index >> CHUNK_SHIFT))[index & CHUNK_MASK];
+}
+
+qint64 SpanArena::size() const
+{
+    return _size;
+}
+
+qint64 SpanArena::byteSize() const
+{
+    return _chunks.size() * chunkBytes();
+}
+
+QVector<qint64> SpanArena::toVector() const
+{
+    QVector<qint64> values(int(_size));
+    for (qint64 done = 0; done < _size; done += CHUNK_VALUES)
+    {
+        int n = int(qMin(_size - done, qint64(CHUNK_VALUES)));
+        memcpy(values.data() + done, _chunks.at(int(done >> CHUNK_SHIFT)), n * sizeof(qint64));
+    }
+    return values;
+}
+
+qint64 SpanArena::chunkBytes()
+{
+    return qint64(CHUNK_VALUES) * sizeof(qint64);
+}
+
+qint64 SpanArena::totalBytes()
+{
+    return _totalBytes;
+}
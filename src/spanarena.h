@@ -0,0 +1,42 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef SPANARENA_H
+#define SPANARENA_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/*
+ * Append-only storage for the match spans of one run. Values are bumped
+ * into fixed-size chunks that never move or grow, so a long run doesn't
+ * keep reallocating and copying what it already found, and clear()
+ * hands the whole run back by freeing a handful of chunks.
+ *
+ * totalBytes() adds up the chunks of every arena; it is only kept right
+ * when all arenas live in the GUI thread.
+ */
+class SpanArena
+{
+public:
+    SpanArena();
+    ~SpanArena();
+    void clear();
+    void append(const qint64 *values, int count);
+    qint64 at(qint64 index) const;
+    qint64 size() const;
+    qint64 byteSize() const;
+    QVector<qint64> toVector() const;
+    static qint64 chunkBytes();
+    static qint64 totalBytes();
+
+private:
+    Q_DISABLE_COPY(SpanArena)
+
+    QVector<qint64 *> _chunks;
+    qint64 _size;
+    static qint64 _totalBytes;
+};
+
+#endif // SPANARENA_H
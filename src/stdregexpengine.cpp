@@ -0,0 +1,216 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#include "stdregexpengine.h"
+
+namespace
+{
+
+// One wchar_t per UTF-16 unit, so a surrogate pair stays two units in
+// pattern and subject alike.
+void widen(const QString &str, std::wstring &wide)
+{
+    wide.resize(str.length());
+    const ushort *units = str.utf16();
+    for (int i = 0; i < str.length(); ++i)
+    {
+        wide[i] = wchar_t(units[i]);
+    }
+}
+
+}
+
+StdRegExpEngine::StdRegExpEngine(const QRegExp &options) :
+    _valid(false),
+    _matched(false),
+    _matchOffset(0)
+{
+    std::regex_constants::syntax_option_type flags =
+            std::regex_constants::ECMAScript | std::regex_constants::optimize;
+    if (options.caseSensitivity() == Qt::CaseInsensitive)
+    {
+        flags |= std::regex_constants::icase;
+    }
+    if (options.isMinimal())
+    {
+        _error = QString("minimal matching is not supported by std::regex");
+        return;
+    }
+
+    try
+    {
+        std::wstring pattern;
+        widen(replaceDot(translatePattern(options)), pattern);
+        _regexp.assign(pattern, flags);
+        _valid = true;
+    }
+    catch (const std::regex_error &error)
+    {
+        _error = QString::fromLocal8Bit(error.what());
+    }
+}
+
+StdRegExpEngine::StdRegExpEngine(const StdRegExpEngine &other) :
+    RegExpEngine(),
+    _regexp(other._regexp),
+    _valid(other._valid),
+    _error(other._error),
+    _matched(false),
+    _matchOffset(0)
+{
+}
+
+RegExpEngine::Type StdRegExpEngine::type() const
+{
+    return StdRegex;
+}
+
+RegExpEngine *StdRegExpEngine::clone() const
+{
+    return new StdRegExpEngine(*this);
+}
+
+bool StdRegExpEngine::isValid() const
+{
+    return _valid;
+}
+
+QString StdRegExpEngine::errorString() const
+{
+    return _valid ? QString("no error occurred") : _error;
+}
+
+bool StdRegExpEngine::exactMatch(const QString &str)
+{
+    _matched = false;
+    if (!_valid)
+    {
+        return false;
+    }
+    setSubject(str);
+    _matchOffset = 0;
+    _matched = std::regex_match(_wideSubject.cbegin(), _wideSubject.cend(), _match, _regexp);
+    return _matched;
+}
+
+int StdRegExpEngine::indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode)
+{
+    _matched = false;
+    if (!_valid || offset < 0 || offset > str.length())
+    {
+        return -1;
+    }
+    setSubject(str);
+
+    // match_prev_avail lets '\b' see the character before offset. It would
+    // also keep '^' from matching at offset, which CaretAtOffset asks for,
+    // so there the search start counts as the beginning of the subject.
+    std::regex_constants::match_flag_type flags = std::regex_constants::match_default;
+    if (offset > 0 && caretMode != QRegExp::CaretAtOffset)
+    {
+        flags |= std::regex_constants::match_prev_avail;
+    }
+    if (caretMode == QRegExp::CaretWontMatch || (caretMode == QRegExp::CaretAtZero && offset > 0))
+    {
+        flags |= std::regex_constants::match_not_bol;
+    }
+
+    _matchOffset = offset;
+    _matched = std::regex_search(_wideSubject.cbegin() + offset, _wideSubject.cend(), _match, _regexp, flags);
+    return pos(0);
+}
+
+int StdRegExpEngine::captureCount() const
+{
+    return _valid ? int(_regexp.mark_count()) : 0;
+}
+
+int StdRegExpEngine::pos(int nth) const
+{
+    if (!_matched || nth >= int(_match.size()) || !_match[nth].matched)
+    {
+        return -1;
+    }
+    return _matchOffset + int(_match.position(nth));
+}
+
+int StdRegExpEngine::capturedLength(int nth) const
+{
+    if (!_matched)
+    {
+        return nth == 0 ? -1 : 0;
+    }
+    if (nth >= int(_match.size()) || !_match[nth].matched)
+    {
+        return 0;
+    }
+    return int(_match.length(nth));
+}
+
+QString StdRegExpEngine::cap(int nth) const
+{
+    int start = pos(nth);
+    return start < 0 ? QString() : _subject.mid(start, capturedLength(nth));
+}
+
+void StdRegExpEngine::setSubject(const QString &str)
+{
+    if (str.constData() == _subject.constData() && str.length() == _subject.length())
+    {
+        return;
+    }
+
+    _subject = str;
+    widen(str, _wideSubject);
+}
+
+/*
+ * Rewrites every unescaped '.' outside a character class so it matches
+ * any character, line breaks included, as in QRegExp.
+ */
+QString StdRegExpEngine::replaceDot(const QString &pattern)
+{
+    QString result;
+    bool inClass = false;
+    int length = pattern.length();
+
+    result.reserve(length + 16);
+    for (int i = 0; i < length; ++i)
+    {
+        QChar ch = pattern.at(i);
+        if (ch == QChar('\\') && i + 1 < length)
+        {
+            result += ch;
+            result += pattern.at(++i);
+        }
+        else if (inClass)
+        {
+            inClass = (ch != QChar(']'));
+            result += ch;
+        }
+        else if (ch == QChar('['))
+        {
+            inClass = true;
+            result += ch;
+            // "[^" negates and "[]" or "[^]" starts with a literal ']'.
+            if (i + 1 < length && pattern.at(i + 1) == QChar('^'))
+            {
+                result += pattern.at(++i);
+            }
+            if (i + 1 < length && pattern.at(i + 1) == QChar(']'))
+            {
+                result += pattern.at(++i);
+            }
+        }
+        else if (ch == QChar('.'))
+        {
+            result += "[\\s\\S]";
+        }
+        else
+        {
+            result += ch;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,52 @@
+/*
+ * This file is subject to the terms and conditions defined in
+ * file 'LICENSE.txt', which is part of this source code package.
+ */
+#ifndef STDREGEXPENGINE_H
+#define STDREGEXPENGINE_H
+
+#include <regex>
+#include <string>
+#include "regexpengine.h"
+
+/*
+ * std::wregex (ECMAScript grammar) backend. The subject is widened one
+ * UTF-16 unit per wchar_t so positions line up with the QString, and the
+ * widened copy is kept until a different subject comes in. ECMAScript's
+ * '.' stops at line breaks, so it is rewritten to "[\s\S]". The pattern
+ * is widened the same way as the subject. Minimal matching has no
+ * ECMAScript equivalent and makes the engine invalid. Beware that the
+ * libstdc++ matcher recurses per character and may overflow the stack on
+ * very long subjects.
+ */
+class StdRegExpEngine : public RegExpEngine
+{
+public:
+    explicit StdRegExpEngine(const QRegExp &options);
+    Type type() const;
+    RegExpEngine *clone() const;
+    bool isValid() const;
+    QString errorString() const;
+    bool exactMatch(const QString &str);
+    int indexIn(const QString &str, int offset, QRegExp::CaretMode caretMode);
+    int captureCount() const;
+    int pos(int nth) const;
+    int capturedLength(int nth) const;
+    QString cap(int nth) const;
+
+private:
+    StdRegExpEngine(const StdRegExpEngine &other);
+    void setSubject(const QString &str);
+    static QString replaceDot(const QString &pattern);
+
+    std::wregex _regexp;
+    bool _valid;
+    QString _error;
+    QString _subject;
+    std::wstring _wideSubject;
+    std::wsmatch _match;
+    bool _matched;
+    int _matchOffset;
+};
+
+#endif // STDREGEXPENGINE_H